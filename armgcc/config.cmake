@@ -19,6 +19,7 @@ set(CONFIG_USE_device_MIMXRT685S_CMSIS true)
 set(CONFIG_USE_device_MIMXRT685S_startup true)
 set(CONFIG_USE_driver_cache_cache64 true)
 set(CONFIG_USE_driver_clock true)
+set(CONFIG_USE_driver_ctimer true)
 set(CONFIG_USE_driver_common true)
 set(CONFIG_USE_driver_flash_config_evkmimxrt685 true)
 set(CONFIG_USE_driver_flexcomm true)
@@ -202,3 +202,48 @@ void BOARD_BootClockRUN(void)
     /*!< Set SystemCoreClock variable. */
     SystemCoreClock = BOARD_BOOTCLOCKRUN_CORE_CLOCK;
 }
+
+/*******************************************************************************
+ * Audio PLL sampling rate families (not generated by the Config Tools)
+ ******************************************************************************/
+/**
+ * The boot configuration gives 24.576 MHz out of AUDIOPLLCLKDIV (512 fs at
+ * 48 kHz, 532.48 MHz PLL, PFD0 18/26, /15). For the 44.1 kHz family the PLL is
+ * moved to 489.216 MHz so that the same PFD0 and divider give 22.5792 MHz
+ * (512 fs at 44.1 kHz).
+ */
+static const clock_audio_pll_config_t s_audioPllConfig44k1 = {
+    .audio_pll_src = kCLOCK_AudioPllXtalIn, /* OSC clock */
+    .numerator = 10368,                     /* 24 MHz x (20 + 10368 / 27000) = 489.216 MHz */
+    .denominator = 27000,
+    .audio_pll_mult = kCLOCK_AudioPllMult20 /* Divide by 20 */
+};
+
+static const clock_audio_pll_config_t *s_audioPllConfig = &g_audioPllConfig_BOARD_BootClockRUN;
+
+void BOARD_SetAudioPllRate(uint32_t sampleRate)
+{
+    const clock_audio_pll_config_t *config =
+        ((sampleRate % 8000U) == 0U) ? &g_audioPllConfig_BOARD_BootClockRUN : &s_audioPllConfig44k1;
+
+    if (config == s_audioPllConfig)
+    {
+        return;
+    }
+
+    CLOCK_DeinitAudioPll();
+    CLOCK_InitAudioPll(config);
+    CLOCK_InitAudioPfd(kCLOCK_Pfd0, 26); /* Enable Audio PLL clock */
+
+    s_audioPllConfig = config;
+}
+
+/**
+ * The fractional numerator can be changed while the PLL is running, one LSB is
+ * 24 MHz / 27000 = 888.9 Hz of PLL [1.67 ppm at 532.48 MHz, 1.82 ppm at
+ * 489.216 MHz].
+ */
+void BOARD_TrimAudioPll(int32_t trim)
+{
+    CLKCTL1->AUDIOPLL0NUM = (uint32_t)((int32_t)s_audioPllConfig->numerator + trim);
+}
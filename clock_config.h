@@ -61,6 +61,19 @@ extern "C" {
  */
 void BOARD_BootClockRUN(void);
 
+/*!
+ * @brief Move the Audio PLL to the family (44.1 kHz or 48 kHz) of a sampling
+ * rate. Blocks until the PLL is locked, does nothing within the same family.
+ */
+void BOARD_SetAudioPllRate(uint32_t sampleRate);
+
+/*!
+ * @brief Offset the fractional numerator of the Audio PLL by trim LSBs from
+ * the nominal value of the current family, without relocking. Cleared by a
+ * family switch in BOARD_SetAudioPllRate().
+ */
+void BOARD_TrimAudioPll(int32_t trim);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus*/
@@ -5,11 +5,51 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <math.h>
+
 #include "fsl_i2s_bridge.h"
 #include "fsl_dma.h"
 
 #include "i2s.h"
+#include "i2s_rx.h"
+#include "i2s_tx.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+const i2s_tdm_geometry_t g_i2sTdmGeometry = {
+    .slots = I2S_TDM_SLOTS,
+    .slotBits = I2S_TDM_SLOT_BITS,
+    .dataBits = I2S_TDM_DATA_BITS,
+    .instNum = I2S_TDM_INST_NUM,
+    .slotOffset = I2S_TDM_SLOT_OFFSET,
+};
+
+static const uint32_t s_i2sRxFlexcomm[] = {
+    I2S_RX_0_FLEXCOMM,
+#if I2S_INST_NUM > 1
+    I2S_RX_1_FLEXCOMM,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_RX_2_FLEXCOMM,
+    I2S_RX_3_FLEXCOMM,
+#endif
+};
 
+static const uint32_t s_i2sTxFlexcomm[] = {
+    I2S_TX_0_FLEXCOMM,
+#if I2S_INST_NUM > 1
+    I2S_TX_1_FLEXCOMM,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_TX_2_FLEXCOMM,
+    I2S_TX_3_FLEXCOMM,
+#endif
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
 /*!
  * @brief I2S shared signals setup.
  *
@@ -19,30 +59,37 @@
  */
 static void I2S_SetupSharedSignals(void)
 {
-    /* [RX] FLEXCOMM5 sharing SCK, WS and SDIN */
-    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet0, kI2S_BRIDGE_SignalSCK, kI2S_BRIDGE_Flexcomm5);
-    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet0, kI2S_BRIDGE_SignalWS, kI2S_BRIDGE_Flexcomm5);
-    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet0, kI2S_BRIDGE_SignalDataIn, kI2S_BRIDGE_Flexcomm5);
-
-    /* [RX] FLEXCOMM7 getting SCK, WS and SDIN from FLEXCOMM5 */
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm7, kI2S_BRIDGE_SignalSCK, kI2S_BRIDGE_ShareSet0);
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm7, kI2S_BRIDGE_SignalWS, kI2S_BRIDGE_ShareSet0);
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm7, kI2S_BRIDGE_SignalDataIn, kI2S_BRIDGE_ShareSet0);
+    /* [RX] The first RX instance sharing SCK, WS and SDIN */
+    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet0, kI2S_BRIDGE_SignalSCK, s_i2sRxFlexcomm[0]);
+    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet0, kI2S_BRIDGE_SignalWS, s_i2sRxFlexcomm[0]);
+    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet0, kI2S_BRIDGE_SignalDataIn, s_i2sRxFlexcomm[0]);
 
-    /* [TX] FLEXCOMM4 getting SCK and WS from FLEXCOMM5 */
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm4, kI2S_BRIDGE_SignalSCK, kI2S_BRIDGE_ShareSet0);
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm4, kI2S_BRIDGE_SignalWS, kI2S_BRIDGE_ShareSet0);
+    /* [RX] The other RX instances getting SCK, WS and SDIN from the first one */
+    for (uint32_t inst = 1U; inst < I2S_INST_NUM; inst++)
+    {
+        I2S_BRIDGE_SetFlexcommSignalShareSet(s_i2sRxFlexcomm[inst], kI2S_BRIDGE_SignalSCK, kI2S_BRIDGE_ShareSet0);
+        I2S_BRIDGE_SetFlexcommSignalShareSet(s_i2sRxFlexcomm[inst], kI2S_BRIDGE_SignalWS, kI2S_BRIDGE_ShareSet0);
+        I2S_BRIDGE_SetFlexcommSignalShareSet(s_i2sRxFlexcomm[inst], kI2S_BRIDGE_SignalDataIn, kI2S_BRIDGE_ShareSet0);
+    }
 
-    /* [TX] FLEXCOMM6 getting SCK and WS from FLEXCOMM5 */
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm6, kI2S_BRIDGE_SignalSCK, kI2S_BRIDGE_ShareSet0);
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm6, kI2S_BRIDGE_SignalWS, kI2S_BRIDGE_ShareSet0);
+    /* [TX] All the TX instances getting SCK and WS from the first RX one */
+    for (uint32_t inst = 0U; inst < I2S_INST_NUM; inst++)
+    {
+        I2S_BRIDGE_SetFlexcommSignalShareSet(s_i2sTxFlexcomm[inst], kI2S_BRIDGE_SignalSCK, kI2S_BRIDGE_ShareSet0);
+        I2S_BRIDGE_SetFlexcommSignalShareSet(s_i2sTxFlexcomm[inst], kI2S_BRIDGE_SignalWS, kI2S_BRIDGE_ShareSet0);
+    }
 
-    /* [TX] FLEXCOMM6 and FLEXCOMM4 share the same SDOUT line */
-    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet1, kI2S_BRIDGE_SignalDataOut, kI2S_BRIDGE_Flexcomm4);
-    I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet1, kI2S_BRIDGE_SignalDataOut, kI2S_BRIDGE_Flexcomm6);
+    if (I2S_INST_NUM > 1U)
+    {
+        /* [TX] All the TX instances share the same SDOUT line */
+        for (uint32_t inst = 0U; inst < I2S_INST_NUM; inst++)
+        {
+            I2S_BRIDGE_SetShareSignalSrc(kI2S_BRIDGE_ShareSet1, kI2S_BRIDGE_SignalDataOut, s_i2sTxFlexcomm[inst]);
+        }
 
-    /* [TX] SDOUT is from FLEXCOMM4 connector */
-    I2S_BRIDGE_SetFlexcommSignalShareSet(kI2S_BRIDGE_Flexcomm4, kI2S_BRIDGE_SignalDataOut, kI2S_BRIDGE_ShareSet1);
+        /* [TX] SDOUT is from the first TX instance connector */
+        I2S_BRIDGE_SetFlexcommSignalShareSet(s_i2sTxFlexcomm[0], kI2S_BRIDGE_SignalDataOut, kI2S_BRIDGE_ShareSet1);
+    }
 }
 
 /*!
@@ -55,6 +102,556 @@ void BOARD_I2S_Init(void)
     I2S_SetupSharedSignals();
     DMA_Init(DMA);
 
+#if I2S_MASTER
+    CLOCK_AttachClk(I2S_RX_0_CLK_ATTACH);
+#endif
+
     /* Keep this priority in sync with USB_DEVICE_INTERRUPT_PRIORITY */
     NVIC_SetPriority(DMA0_IRQn, 6U);
 }
+
+/*!
+ * @brief Master mode, SCK divider for a sampling rate [Hz].
+ *
+ * The master FLEXCOMM is clocked at I2S_MASTER_CLK_FS times the base rate of
+ * the family, SCK runs at the sampling rate times the bits of the whole TDM
+ * frame on the bus.
+ *
+ * @return 0 when the rate cannot be generated.
+ */
+uint32_t I2S_MasterDivider(uint32_t rate)
+{
+    uint32_t clk = I2S_MASTER_CLK_FS * (((rate % 8000U) == 0U) ? 48000U : 44100U);
+    uint32_t sck = rate * (g_i2sTdmGeometry.slotOffset + g_i2sTdmGeometry.slots) * g_i2sTdmGeometry.slotBits;
+
+    if ((sck == 0U) || (sck > clk) || ((clk % sck) != 0U))
+    {
+        return 0U;
+    }
+
+    return clk / sck;
+}
+
+/*!
+ * @brief Pack 32-bit samples into 24-bit subslots, in place.
+ *
+ * The I2S data is MSB aligned in the 32-bit slots so the 24 MSBs of each
+ * sample are kept. The packed samples are written from the start of the buffer
+ * (each write lands before the samples still to be read), four samples in
+ * three words at a time. The buffer must be 4-byte aligned.
+ */
+void I2S_Pack32To24(uint8_t *buffer, uint32_t samples)
+{
+    const uint32_t *src = (const uint32_t *)buffer;
+    uint32_t *dst = (uint32_t *)buffer;
+    uint8_t *tail;
+
+    for (uint32_t n = samples / 4U; n > 0U; n--)
+    {
+        uint32_t s0 = src[0] >> 8;
+        uint32_t s1 = src[1] >> 8;
+        uint32_t s2 = src[2] >> 8;
+        uint32_t s3 = src[3] >> 8;
+
+        dst[0] = s0 | (s1 << 24);
+        dst[1] = (s1 >> 8) | (s2 << 16);
+        dst[2] = (s2 >> 16) | (s3 << 8);
+
+        src += 4;
+        dst += 3;
+    }
+
+    tail = (uint8_t *)dst;
+    for (uint32_t n = samples % 4U; n > 0U; n--)
+    {
+        uint32_t s = *src++;
+
+        tail[0] = (uint8_t)(s >> 8);
+        tail[1] = (uint8_t)(s >> 16);
+        tail[2] = (uint8_t)(s >> 24);
+        tail += 3;
+    }
+}
+
+/*!
+ * @brief Unpack 24-bit subslots into 32-bit samples, in place.
+ *
+ * Inverse of I2S_Pack32To24(): the buffer must be large enough for the
+ * unpacked samples. We go backwards so that each write lands after the
+ * samples still to be read.
+ */
+void I2S_Unpack24To32(uint8_t *buffer, uint32_t samples)
+{
+    const uint8_t *src = buffer + (samples * I2S_CH_LEN_PACKED);
+    uint32_t *dst = (uint32_t *)buffer + samples;
+
+    for (uint32_t n = samples % 4U; n > 0U; n--)
+    {
+        src -= 3;
+        dst--;
+
+        *dst = ((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24);
+    }
+
+    for (uint32_t n = samples / 4U; n > 0U; n--)
+    {
+        const uint32_t *p;
+        uint32_t p0, p1, p2;
+
+        src -= 12;
+        dst -= 4;
+
+        p = (const uint32_t *)src;
+        p0 = p[0];
+        p1 = p[1];
+        p2 = p[2];
+
+        dst[0] = p0 << 8;
+        dst[1] = ((p0 >> 16) & 0x0000FF00U) | (p1 << 16);
+        dst[2] = ((p1 >> 8) & 0x00FFFF00U) | (p2 << 24);
+        dst[3] = p2 & 0xFFFFFF00U;
+    }
+}
+
+/*!
+ * @brief Pack full frames into 24-bit subslots.
+ */
+static void I2S_PackFrames24(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize)
+{
+    I2S_Pack32To24(buffer, frames * I2S_CH_NUM);
+}
+
+/*!
+ * @brief Unpack full frames from 24-bit subslots.
+ */
+static void I2S_UnpackFrames24(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize)
+{
+    I2S_Unpack24To32(buffer, frames * I2S_CH_NUM);
+}
+
+/*!
+ * @brief Keep the first channels slots of each frame, 32-bit subslots.
+ *
+ * Each frame shrinks towards the start of the buffer, as for the packing.
+ */
+static void I2S_SelectSlots32(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize)
+{
+    const uint32_t *src = (const uint32_t *)buffer;
+    uint32_t *dst = (uint32_t *)buffer;
+
+    for (uint32_t f = frames; f > 0U; f--)
+    {
+        for (uint32_t n = 0U; n < channels; n++)
+        {
+            *dst++ = src[n];
+        }
+
+        src += I2S_CH_NUM;
+    }
+}
+
+/*!
+ * @brief Spread 32-bit subslots over full frames, the other slots are zeroed.
+ *
+ * Inverse of I2S_SelectSlots32(), going backwards.
+ */
+static void I2S_ExpandSlots32(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize)
+{
+    const uint32_t *src = (const uint32_t *)buffer + (frames * channels);
+    uint32_t *dst = (uint32_t *)buffer + (frames * I2S_CH_NUM);
+
+    for (uint32_t f = frames; f > 0U; f--)
+    {
+        for (uint32_t n = I2S_CH_NUM; n > channels; n--)
+        {
+            *--dst = 0U;
+        }
+
+        for (uint32_t n = channels; n > 0U; n--)
+        {
+            *--dst = *--src;
+        }
+    }
+}
+
+/*!
+ * @brief Keep the first channels slots of each frame, any subslot size.
+ *
+ * Bytewise, the MSBs of each sample are kept.
+ */
+static void I2S_SelectSlots(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize)
+{
+    const uint32_t *src = (const uint32_t *)buffer;
+    uint8_t *dst = buffer;
+
+    for (uint32_t f = frames; f > 0U; f--)
+    {
+        for (uint32_t n = 0U; n < channels; n++)
+        {
+            uint32_t s = src[n];
+
+            for (uint32_t b = I2S_CH_LEN_DATA - subslotSize; b < I2S_CH_LEN_DATA; b++)
+            {
+                *dst++ = (uint8_t)(s >> TO_BITS(b));
+            }
+        }
+
+        src += I2S_CH_NUM;
+    }
+}
+
+/*!
+ * @brief Spread subslots of any size over full frames.
+ *
+ * Inverse of I2S_SelectSlots(), going backwards. The LSBs and the other slots
+ * are zeroed.
+ */
+static void I2S_ExpandSlots(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize)
+{
+    const uint8_t *src = buffer + (frames * channels * subslotSize);
+    uint32_t *dst = (uint32_t *)buffer + (frames * I2S_CH_NUM);
+
+    for (uint32_t f = frames; f > 0U; f--)
+    {
+        for (uint32_t n = I2S_CH_NUM; n > channels; n--)
+        {
+            *--dst = 0U;
+        }
+
+        for (uint32_t n = channels; n > 0U; n--)
+        {
+            uint32_t s = 0U;
+
+            for (uint32_t b = I2S_CH_LEN_DATA; b > (I2S_CH_LEN_DATA - subslotSize); b--)
+            {
+                s |= (uint32_t)*--src << TO_BITS(b - 1U);
+            }
+
+            *--dst = s;
+        }
+    }
+}
+
+/*!
+ * @brief Kernel converting I2S frames into USB frames.
+ *
+ * Returns NULL when the USB frames are the I2S frames (all the channels,
+ * 32-bit), nothing to do then.
+ */
+i2s_usb_kernel_t I2S_GetPackKernel(uint32_t channels, uint32_t subslotSize)
+{
+    assert((channels > 0U) && (channels <= I2S_CH_NUM));
+    assert((subslotSize > 0U) && (subslotSize <= I2S_CH_LEN_DATA));
+
+    if (channels == I2S_CH_NUM)
+    {
+        if (subslotSize == I2S_CH_LEN_DATA)
+        {
+            return NULL;
+        }
+
+        if (subslotSize == I2S_CH_LEN_PACKED)
+        {
+            return I2S_PackFrames24;
+        }
+    }
+    else if (subslotSize == I2S_CH_LEN_DATA)
+    {
+        return I2S_SelectSlots32;
+    }
+
+    return I2S_SelectSlots;
+}
+
+/*!
+ * @brief Kernel converting USB frames into I2S frames.
+ *
+ * Returns NULL when the USB frames are the I2S frames.
+ */
+i2s_usb_kernel_t I2S_GetUnpackKernel(uint32_t channels, uint32_t subslotSize)
+{
+    assert((channels > 0U) && (channels <= I2S_CH_NUM));
+    assert((subslotSize > 0U) && (subslotSize <= I2S_CH_LEN_DATA));
+
+    if (channels == I2S_CH_NUM)
+    {
+        if (subslotSize == I2S_CH_LEN_DATA)
+        {
+            return NULL;
+        }
+
+        if (subslotSize == I2S_CH_LEN_PACKED)
+        {
+            return I2S_UnpackFrames24;
+        }
+    }
+    else if (subslotSize == I2S_CH_LEN_DATA)
+    {
+        return I2S_ExpandSlots32;
+    }
+
+    return I2S_ExpandSlots;
+}
+
+/*!
+ * @brief Linear gain of a volume in 1/256 dB, Q2.30.
+ *
+ * -32768 (0x8000) is -inf dB, anything above +6 dB is clamped. This uses the
+ * FPU, keep it out of the audio path.
+ */
+int32_t I2S_GainFromDb(int32_t volume)
+{
+    float gain;
+
+    if (volume <= INT16_MIN)
+    {
+        return 0;
+    }
+
+    gain = powf(10.0f, (float)volume / (20.0f * 256.0f)) * (float)I2S_GAIN_UNITY;
+
+    return (gain >= (float)INT32_MAX) ? INT32_MAX : (int32_t)(gain + 0.5f);
+}
+
+/*!
+ * @brief All the channels at unity, nothing to ramp.
+ */
+void I2S_GainInit(i2s_gain_t *gain)
+{
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        gain->target[n] = I2S_GAIN_UNITY;
+        gain->cur[n] = I2S_GAIN_UNITY;
+        gain->end[n] = I2S_GAIN_UNITY;
+        gain->step[n] = 0;
+    }
+
+    gain->serial = 0U;
+    gain->applied = 0U;
+    gain->ramp = 0U;
+    gain->unity = true;
+}
+
+/*!
+ * @brief Set the gains to ramp to, one per I2S_CH_NUM slot (Q2.30).
+ *
+ * Control side, can be preempted by I2S_GainApply(): a target seen half
+ * written is fixed up by the next packet, serial is only bumped afterwards.
+ */
+void I2S_GainSetTarget(i2s_gain_t *gain, const int32_t *target)
+{
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        gain->target[n] = target[n];
+    }
+
+    __DMB();
+    gain->serial++;
+}
+
+/*!
+ * @brief Saturating sample x Q2.30 gain.
+ *
+ * SMMULR gives the rounded high word of the product, that is two bits short of
+ * the Q1.31 result: saturate on 30 bits and shift them back in.
+ */
+static inline int32_t I2S_GainMul(int32_t sample, int32_t gain)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    int32_t p;
+
+    __ASM("smmulr %0, %1, %2" : "=r"(p) : "r"(sample), "r"(gain));
+
+    return (int32_t)((uint32_t)__SSAT(p, 30U) << 2U);
+#else
+    int64_t p = (((int64_t)sample * gain) + (1LL << 31)) >> 32;
+
+    if (p > ((1 << 29) - 1))
+    {
+        p = (1 << 29) - 1;
+    }
+    else if (p < -(1 << 29))
+    {
+        p = -(1 << 29);
+    }
+
+    return (int32_t)((uint32_t)p << 2U);
+#endif
+}
+
+/*!
+ * @brief All the channels at I2S_GAIN_UNITY.
+ */
+static inline bool I2S_GainIsUnity(const i2s_gain_t *gain)
+{
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        if (gain->cur[n] != I2S_GAIN_UNITY)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * @brief Apply the gains in place on full I2S frames.
+ *
+ * Only the first channels slots are touched, the others are dropped or zeroed
+ * by the kernels anyway. A new target restarts the ramp from wherever the
+ * gains are: each channel moves by a fixed step per frame for
+ * I2S_GAIN_RAMP_FRAMES frames, then lands exactly on the target.
+ */
+void I2S_GainApply(i2s_gain_t *gain, uint8_t *buffer, uint32_t frames, uint32_t channels)
+{
+    int32_t *s = (int32_t *)buffer;
+    uint32_t serial = gain->serial;
+
+    if (serial != gain->applied)
+    {
+        __DMB();
+
+        for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+        {
+            gain->end[n] = gain->target[n];
+            gain->step[n] = (gain->end[n] - gain->cur[n]) / (int32_t)I2S_GAIN_RAMP_FRAMES;
+        }
+
+        gain->applied = serial;
+        gain->ramp = I2S_GAIN_RAMP_FRAMES;
+        gain->unity = false;
+    }
+
+    if (gain->unity)
+    {
+        return;
+    }
+
+    for (; (frames > 0U) && (gain->ramp > 0U); frames--)
+    {
+        gain->ramp--;
+
+        for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+        {
+            gain->cur[n] = (gain->ramp == 0U) ? gain->end[n] : (gain->cur[n] + gain->step[n]);
+        }
+
+        for (uint32_t n = 0U; n < channels; n++)
+        {
+            s[n] = I2S_GainMul(s[n], gain->cur[n]);
+        }
+
+        s += I2S_CH_NUM;
+
+        if (gain->ramp == 0U)
+        {
+            gain->unity = I2S_GainIsUnity(gain);
+        }
+    }
+
+    if (gain->unity)
+    {
+        return;
+    }
+
+    for (; frames > 0U; frames--)
+    {
+        for (uint32_t n = 0U; n < channels; n++)
+        {
+            s[n] = I2S_GainMul(s[n], gain->cur[n]);
+        }
+
+        s += I2S_CH_NUM;
+    }
+}
+
+/*!
+ * @brief Identity map, each slot to itself.
+ */
+void I2S_RouteInit(i2s_route_t *route)
+{
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        route->map[0].index[n] = (uint8_t)n;
+    }
+
+    route->map[0].identity = true;
+    route->active = 0U;
+}
+
+/*!
+ * @brief Set the route, one source (or I2S_ROUTE_SILENCE) per destination.
+ *
+ * @return false, and the route is left alone, when a source is out of range.
+ */
+bool I2S_RouteSet(i2s_route_t *route, const uint8_t *map)
+{
+    uint8_t next = route->active ^ 1U;
+    i2s_route_map_t *m = &route->map[next];
+
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        if ((map[n] >= I2S_CH_NUM) && (map[n] != I2S_ROUTE_SILENCE))
+        {
+            return false;
+        }
+    }
+
+    m->identity = true;
+
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        m->index[n] = (map[n] == I2S_ROUTE_SILENCE) ? I2S_CH_NUM : map[n];
+        m->identity = m->identity && (m->index[n] == n);
+    }
+
+    __DMB();
+    route->active = next;
+
+    return true;
+}
+
+/*!
+ * @brief Current route, as given to I2S_RouteSet().
+ */
+void I2S_RouteGet(const i2s_route_t *route, uint8_t *map)
+{
+    const i2s_route_map_t *m = &route->map[route->active];
+
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        map[n] = (m->index[n] == I2S_CH_NUM) ? I2S_ROUTE_SILENCE : m->index[n];
+    }
+}
+
+/*!
+ * @brief Route full I2S frames in place.
+ *
+ * Only the first channels destinations are written, as for I2S_GainApply().
+ */
+void I2S_RouteApply(const i2s_route_t *route, uint8_t *buffer, uint32_t frames, uint32_t channels)
+{
+    const i2s_route_map_t *m = &route->map[route->active];
+    uint32_t *s = (uint32_t *)buffer;
+    uint32_t frame[I2S_CH_NUM + 1U];
+
+    if (m->identity)
+    {
+        return;
+    }
+
+    frame[I2S_CH_NUM] = 0U;
+
+    for (uint32_t f = frames; f > 0U; f--)
+    {
+        memcpy(frame, s, I2S_FRAME_LEN);
+
+        for (uint32_t n = 0U; n < channels; n++)
+        {
+            s[n] = frame[m->index[n]];
+        }
+
+        s += I2S_CH_NUM;
+    }
+}
@@ -9,6 +9,18 @@
 #define __I2S_H__ 1
 
 void BOARD_I2S_Init(void);
+uint32_t I2S_MasterDivider(uint32_t rate);
+
+/**
+ * In-place conversion between full I2S frames (I2S_CH_NUM 32-bit slots) and
+ * USB frames carrying the first `channels` slots in `subslotSize` bytes each.
+ */
+typedef void (*i2s_usb_kernel_t)(uint8_t *buffer, uint32_t frames, uint32_t channels, uint32_t subslotSize);
+
+void I2S_Pack32To24(uint8_t *buffer, uint32_t samples);
+void I2S_Unpack24To32(uint8_t *buffer, uint32_t samples);
+i2s_usb_kernel_t I2S_GetPackKernel(uint32_t channels, uint32_t subslotSize);
+i2s_usb_kernel_t I2S_GetUnpackKernel(uint32_t channels, uint32_t subslotSize);
 
 /**
  * Case for 16ch / 32bits:
@@ -30,10 +42,89 @@ void BOARD_I2S_Init(void);
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+/**
+ * TDM geometry of the bus, see i2s_tdm_geometry_t. The defaults are 16 slots
+ * of 32 bits, all carrying data, over two FLEXCOMM instances.
+ *
+ * Each FLEXCOMM moves at most 4 pairs of slots (the primary channel and 3
+ * secondary channels), so I2S_TDM_SLOTS / I2S_TDM_INST_NUM must be even and
+ * no more than 8. Up to 16 slots take 1 or 2 FLEXCOMMs per direction, 32 slots
+ * (I2S_TDM_INST_NUM = 4) take all the 8 FLEXCOMMs, including FLEXCOMM0 of the
+ * debug console (see i2s_rx.h / i2s_tx.h).
+ */
+#ifndef I2S_TDM_SLOTS
+#define I2S_TDM_SLOTS (16U)
+#endif
+
+#ifndef I2S_TDM_SLOT_BITS
+#define I2S_TDM_SLOT_BITS (32U)
+#endif
+
+/**
+ * Significant bits in each slot, MSB aligned. The LSBs are masked out by the
+ * RX filter (see USE_FILTER_32_DOWN).
+ */
+#ifndef I2S_TDM_DATA_BITS
+#define I2S_TDM_DATA_BITS (32U)
+#endif
+
+#ifndef I2S_TDM_INST_NUM
+#define I2S_TDM_INST_NUM (2U)
+#endif
+
+/**
+ * Slots on the bus before the first one we move, the TDM frame on the bus is
+ * I2S_TDM_SLOT_OFFSET + I2S_TDM_SLOTS slots long.
+ */
+#ifndef I2S_TDM_SLOT_OFFSET
+#define I2S_TDM_SLOT_OFFSET (0U)
+#endif
+
+/**
+ * Set I2S_MASTER to (1) to have the first RX instance (FLEXCOMM5) generating
+ * SCK and WS for the whole bus out of the Audio PLL, instead of receiving them
+ * from the other side of the bus. The other instances, RX and TX, still get
+ * them through the I2S bridge (see I2S_SetupSharedSignals()).
+ */
+#ifndef I2S_MASTER
+#define I2S_MASTER (0)
+#endif
+
+/**
+ * Clock of the master FLEXCOMM in multiples of the base rate of the family
+ * (44.1 kHz or 48 kHz), that is the AUDIOPLLCLKDIV output set up by
+ * BOARD_SetAudioPllRate() [512 fs, 24.576 MHz]
+ */
+#define I2S_MASTER_CLK_FS (512U)
+
+/**
+ * The frames are processed (gains, routing, USB formats) as arrays of 32-bit
+ * words.
+ */
+#if I2S_TDM_SLOT_BITS != 32U
+#error "I2S_TDM_SLOT_BITS must be 32"
+#endif
+
+#if (I2S_TDM_DATA_BITS == 0U) || (I2S_TDM_DATA_BITS > I2S_TDM_SLOT_BITS)
+#error "I2S_TDM_DATA_BITS must be between 1 and I2S_TDM_SLOT_BITS"
+#endif
+
+#if (I2S_TDM_INST_NUM != 1U) && (I2S_TDM_INST_NUM != 2U) && (I2S_TDM_INST_NUM != 4U)
+#error "I2S_TDM_INST_NUM must be 1, 2 or 4"
+#endif
+
+#if ((I2S_TDM_SLOTS % (2U * I2S_TDM_INST_NUM)) != 0U) || ((I2S_TDM_SLOTS / I2S_TDM_INST_NUM) > 8U)
+#error "Each I2S instance must move an even number of slots, 8 at most"
+#endif
+
+#if I2S_MASTER && ((I2S_MASTER_CLK_FS % ((I2S_TDM_SLOT_OFFSET + I2S_TDM_SLOTS) * I2S_TDM_SLOT_BITS)) != 0U)
+#error "I2S_MASTER requires a TDM frame on the bus dividing I2S_MASTER_CLK_FS bits"
+#endif
+
 /**
  * Helper macro to set the offset for the secondary channels.
  */
-#define CH_OFF(off, n) (TO_BITS(off) + (TO_BITS(I2S_CH_LEN_PER_PAIR) * (n)))
+#define CH_OFF(off, n) (TO_BITS(I2S_FRAME_OFFSET + (off)) + (TO_BITS(I2S_CH_LEN_PER_PAIR) * (n)))
 
 /**
  * Silly macro for byte -> bits conversion.
@@ -47,14 +138,15 @@ void BOARD_I2S_Init(void);
 
 /**
  * Number of I2S instances. Each I2S instance (controller) supports at maximum 8
- * channels, so we need 2 instances for 16-channels [2 instances]
+ * channels, so we need 2 instances for 16-channels and 4 for 32-channels
+ * [2 instances]
  */
-#define I2S_INST_NUM (2U)
+#define I2S_INST_NUM (I2S_TDM_INST_NUM)
 
 /**
  * Number of total channels [16 channels]
  */
-#define I2S_CH_NUM (16U)
+#define I2S_CH_NUM (I2S_TDM_SLOTS)
 
 /**
  * Number of channels per I2S pair (L/R) [2 channels]
@@ -64,7 +156,17 @@ void BOARD_I2S_Init(void);
 /**
  * Data bytes per channels [4 bytes / 32 bits]
  */
-#define I2S_CH_LEN_DATA (4U)
+#define I2S_CH_LEN_DATA (I2S_TDM_SLOT_BITS / 8U)
+
+/**
+ * Mask of the significant bits of a slot [0xFFFFFFFF]
+ */
+#define I2S_CH_DATA_MASK (0xFFFFFFFFU << (I2S_TDM_SLOT_BITS - I2S_TDM_DATA_BITS))
+
+/**
+ * Bytes on the bus before the first slot [0 bytes]
+ */
+#define I2S_FRAME_OFFSET (I2S_TDM_SLOT_OFFSET * I2S_CH_LEN_DATA)
 
 /**
  *  Number of channels per I2S instance [8 channels]
@@ -86,4 +188,106 @@ void BOARD_I2S_Init(void);
  */
 #define I2S_FRAME_LEN_PER_INST (I2S_CH_NUM_PER_INST * I2S_CH_LEN_DATA)
 
+/**
+ * Length of a packed 24-bit sample (3-byte USB subslot) [3 bytes]
+ */
+#define I2S_CH_LEN_PACKED (3U)
+
+/**
+ * Unity gain, Q2.30 [0 dB]
+ */
+#define I2S_GAIN_UNITY (1 << 30)
+
+/**
+ * Length of the gain ramps [256 frames, ~5 ms at 48 kHz]
+ */
+#define I2S_GAIN_RAMP_FRAMES (256U)
+
+/**
+ * Routing map entry for a silent destination (see i2s_route_t)
+ */
+#define I2S_ROUTE_SILENCE (0xFFU)
+
+/**
+ * USB RAM for the ring and the tail of each direction. RX and TX get the same
+ * amount, the USB stack gets what is left of the 16 KB. The ring geometry is
+ * derived from it, so that the tail fits a packet at the max sampling rate
+ * [7616 bytes, 119 frames]
+ */
+#define I2S_RING_RAM_SIZE (7616U)
+
+/**
+ * Per-channel gain, applied in place on full I2S frames (see I2S_GainApply()).
+ *
+ * The gains are Q2.30 (I2S_GAIN_UNITY is 0 dB, up to +6 dB). The target is
+ * written by I2S_GainSetTarget() from the control side, the audio side picks it
+ * up at the next I2S_GainApply() and ramps each channel linearly towards it in
+ * I2S_GAIN_RAMP_FRAMES frames. When all the channels are at unity nothing is
+ * done at all.
+ */
+typedef struct _i2s_gain
+{
+    int32_t target[I2S_CH_NUM];
+    volatile uint32_t serial; /* Incremented once target is written */
+    uint32_t applied; /* serial of the target ramped to, audio side only */
+    uint32_t ramp;    /* Frames left in the ramp */
+    bool unity;       /* All the channels at I2S_GAIN_UNITY, no ramp */
+    int32_t cur[I2S_CH_NUM];
+    int32_t end[I2S_CH_NUM];  /* target when the ramp was started */
+    int32_t step[I2S_CH_NUM];
+} i2s_gain_t;
+
+int32_t I2S_GainFromDb(int32_t volume);
+void I2S_GainInit(i2s_gain_t *gain);
+void I2S_GainSetTarget(i2s_gain_t *gain, const int32_t *target);
+void I2S_GainApply(i2s_gain_t *gain, uint8_t *buffer, uint32_t frames, uint32_t channels);
+
+/**
+ * Routing between the TDM slots and the USB channels, applied in place on full
+ * I2S frames (see I2S_RouteApply()).
+ *
+ * The map gives, for each destination, its source or I2S_ROUTE_SILENCE: a
+ * source can feed several destinations, or none. The sources are saved in a
+ * frame with one more zeroed slot (the silence) and the destinations gathered
+ * from it, with no branch per sample. When the map is the identity nothing is
+ * done at all.
+ *
+ * There are two maps: I2S_RouteSet() writes the one not in use and switches
+ * to it, so a route set from the control side never races with the audio side
+ * preempting it.
+ */
+typedef struct _i2s_route_map
+{
+    uint8_t index[I2S_CH_NUM]; /* Source slot, I2S_CH_NUM for the silence */
+    bool identity;
+} i2s_route_map_t;
+
+typedef struct _i2s_route
+{
+    i2s_route_map_t map[2];
+    volatile uint8_t active;
+} i2s_route_t;
+
+void I2S_RouteInit(i2s_route_t *route);
+bool I2S_RouteSet(i2s_route_t *route, const uint8_t *map);
+void I2S_RouteGet(const i2s_route_t *route, uint8_t *map);
+void I2S_RouteApply(const i2s_route_t *route, uint8_t *buffer, uint32_t frames, uint32_t channels);
+
+/**
+ * TDM geometry, as configured by the I2S_TDM_xxx options. The rings take it
+ * to set up the FLEXCOMM instances (frame, primary and secondary channels)
+ * and the DMA. The storage and the hot loops are sized and specialized on the
+ * same options at build time.
+ */
+typedef struct _i2s_tdm_geometry
+{
+    uint32_t slots;      /* Slots moved to / from USB */
+    uint32_t slotBits;   /* Bits per slot on the bus */
+    uint32_t dataBits;   /* Significant bits of each slot, MSB aligned */
+    uint32_t instNum;    /* FLEXCOMM instances sharing the bus */
+    uint32_t slotOffset; /* Slots on the bus before the first one moved */
+} i2s_tdm_geometry_t;
+
+extern const i2s_tdm_geometry_t g_i2sTdmGeometry;
+
 #endif /* __I2S_H__ */
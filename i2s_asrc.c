@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "usb_device_config.h"
+#include "usb.h"
+#include "usb_device.h"
+#include "usb_device_class.h"
+#include "usb_device_descriptor.h"
+#include "fsl_device_registers.h"
+
+#include "i2s.h"
+#include "i2s_asrc.h"
+
+#if I2S_ASRC
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * The output frame sits between the two taps in the middle of the window,
+ * frac after I2S_ASRC_CENTER.
+ */
+#define I2S_ASRC_CENTER ((I2S_ASRC_TAPS / 2U) - 1U)
+
+/**
+ * Frames of silence in the history after a reset, one short of the window as
+ * after each conversion. The output frames come I2S_ASRC_TAPS / 2 input frames
+ * late [15 frames]
+ */
+#define I2S_ASRC_PREFILL (I2S_ASRC_TAPS - 1U)
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+/**
+ * For each phase and tap, the coefficient and twice its distance to the same
+ * tap of the next phase (Q2.30), next to each other for the interpolation.
+ */
+static int32_t s_asrcCoef[I2S_ASRC_PHASES][I2S_ASRC_TAPS][2];
+static bool s_asrcCoefReady;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/*!
+ * @brief Modified Bessel function of the first kind, order 0.
+ */
+static float I2S_AsrcBesselI0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+
+    for (uint32_t k = 1U; term > (sum * 1e-9f); k++)
+    {
+        term *= (x / (2.0f * (float)k)) * (x / (2.0f * (float)k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/*!
+ * @brief Taps of the filter for an output frame mu frames after the center.
+ *
+ * Each set of taps is normalized to unity gain at DC.
+ */
+static void I2S_AsrcPhase(float mu, float *taps)
+{
+    const float fc = (2.0f * (float)I2S_ASRC_CUTOFF) / 1000.0f;
+    const float half = (float)(I2S_ASRC_TAPS / 2U);
+    float sum = 0.0f;
+
+    for (uint32_t k = 0U; k < I2S_ASRC_TAPS; k++)
+    {
+        float x = ((float)k - (float)I2S_ASRC_CENTER) - mu;
+        float t = (float)M_PI * fc * x;
+        float r = x / half;
+        float w = (r * r < 1.0f) ? I2S_AsrcBesselI0(I2S_ASRC_KAISER_BETA * sqrtf(1.0f - (r * r))) : 1.0f;
+
+        taps[k] = ((t == 0.0f) ? 1.0f : (sinf(t) / t)) * w;
+        sum += taps[k];
+    }
+
+    for (uint32_t k = 0U; k < I2S_ASRC_TAPS; k++)
+    {
+        taps[k] /= sum;
+    }
+}
+
+/*!
+ * @brief Build the coefficients table.
+ *
+ * This uses the FPU, keep it out of the audio path.
+ */
+static void I2S_AsrcBuildCoef(void)
+{
+    float cur[I2S_ASRC_TAPS];
+    float next[I2S_ASRC_TAPS];
+
+    I2S_AsrcPhase(0.0f, next);
+
+    for (uint32_t p = 0U; p < I2S_ASRC_PHASES; p++)
+    {
+        memcpy(cur, next, sizeof(cur));
+        I2S_AsrcPhase((float)(p + 1U) / (float)I2S_ASRC_PHASES, next);
+
+        for (uint32_t k = 0U; k < I2S_ASRC_TAPS; k++)
+        {
+            int32_t c = (int32_t)lroundf(cur[k] * (float)I2S_GAIN_UNITY);
+            int32_t n = (int32_t)lroundf(next[k] * (float)I2S_GAIN_UNITY);
+
+            s_asrcCoef[p][k][0] = c;
+            s_asrcCoef[p][k][1] = 2 * (n - c);
+        }
+    }
+
+    s_asrcCoefReady = true;
+}
+
+/*!
+ * @brief Rounded high word of a x b.
+ */
+static inline int32_t I2S_AsrcMul(int32_t a, int32_t b)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    int32_t p;
+
+    __ASM("smmulr %0, %1, %2" : "=r"(p) : "r"(a), "r"(b));
+
+    return p;
+#else
+    return (int32_t)((((int64_t)a * b) + (1LL << 31)) >> 32);
+#endif
+}
+
+/*!
+ * @brief acc + rounded high word of x * c.
+ */
+static inline int32_t I2S_AsrcMac(int32_t acc, int32_t x, int32_t c)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    __ASM("smmlar %0, %1, %2, %3" : "=r"(acc) : "r"(x), "r"(c), "r"(acc));
+
+    return acc;
+#else
+    return acc + (int32_t)((((int64_t)x * c) + (1LL << 31)) >> 32);
+#endif
+}
+
+/*!
+ * @brief Coefficients for an output frame frac after the center.
+ *
+ * Linear interpolation between the two nearest phases: the bits of frac below
+ * the phase are the weight of the next one, in Q1.31 so that SMMULR takes it
+ * as a positive number (hence the distance stored twice).
+ */
+static inline void I2S_AsrcCoef(uint32_t frac, int32_t *coef)
+{
+    const int32_t *c = &s_asrcCoef[frac >> (32U - I2S_ASRC_PHASE_BITS)][0][0];
+    int32_t mu = (int32_t)((frac << I2S_ASRC_PHASE_BITS) >> 1U);
+
+    for (uint32_t k = 0U; k < I2S_ASRC_TAPS; k++)
+    {
+        coef[k] = c[2U * k] + I2S_AsrcMul(c[(2U * k) + 1U], mu);
+    }
+}
+
+/*!
+ * @brief One output sample, saturated as for the gains (see I2S_GainMul()).
+ *
+ * SMMLAR drops the 32 LSBs of each product, that is two bits short of the
+ * Q1.31 result with the Q2.30 coefficients.
+ */
+static inline int32_t I2S_AsrcDot(const int32_t *x, const int32_t *coef)
+{
+    int32_t acc = 0;
+
+    for (uint32_t k = 0U; k < I2S_ASRC_TAPS; k += 4U)
+    {
+        acc = I2S_AsrcMac(acc, x[k], coef[k]);
+        acc = I2S_AsrcMac(acc, x[k + 1U], coef[k + 1U]);
+        acc = I2S_AsrcMac(acc, x[k + 2U], coef[k + 2U]);
+        acc = I2S_AsrcMac(acc, x[k + 3U], coef[k + 3U]);
+    }
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    return (int32_t)((uint32_t)__SSAT(acc, 30U) << 2U);
+#else
+    if (acc > ((1 << 29) - 1))
+    {
+        acc = (1 << 29) - 1;
+    }
+    else if (acc < -(1 << 29))
+    {
+        acc = -(1 << 29);
+    }
+
+    return (int32_t)((uint32_t)acc << 2U);
+#endif
+}
+
+/*!
+ * @brief Move the window back at the beginning of the history.
+ */
+static void I2S_AsrcCompact(i2s_asrc_t *asrc, uint32_t channels)
+{
+    for (uint32_t n = 0U; n < channels; n++)
+    {
+        memmove(&asrc->hist[n][0], &asrc->hist[n][asrc->start], asrc->avail * sizeof(int32_t));
+    }
+
+    asrc->start = 0U;
+}
+
+/*!
+ * @brief Silence in the history, same position and same ratio.
+ */
+void I2S_AsrcReset(i2s_asrc_t *asrc)
+{
+    memset(asrc->hist, 0, sizeof(asrc->hist));
+
+    asrc->frac = 0U;
+    asrc->start = 0U;
+    asrc->avail = I2S_ASRC_PREFILL;
+}
+
+/*!
+ * @brief Unity ratio and silence in the history.
+ *
+ * The coefficients are built at the first call.
+ */
+void I2S_AsrcInit(i2s_asrc_t *asrc)
+{
+    if (!s_asrcCoefReady)
+    {
+        I2S_AsrcBuildCoef();
+    }
+
+    asrc->step = 1ULL << 32U;
+    I2S_AsrcReset(asrc);
+}
+
+/*!
+ * @brief Set the ratio as in input frames for out output frames.
+ *
+ * Any unit as long as it is the same for both, for example the frames per
+ * microframe in Q16 of each side.
+ */
+void I2S_AsrcSetRatio(i2s_asrc_t *asrc, uint32_t in, uint32_t out)
+{
+    asrc->step = ((uint64_t)in << 32U) / out;
+}
+
+/*!
+ * @brief Input frames needed for the next frames output frames.
+ */
+uint32_t I2S_AsrcInputFrames(const i2s_asrc_t *asrc, uint32_t frames)
+{
+    uint32_t needed;
+
+    if (frames == 0U)
+    {
+        return 0U;
+    }
+
+    needed = I2S_ASRC_TAPS + (uint32_t)((asrc->frac + ((uint64_t)(frames - 1U) * asrc->step)) >> 32U);
+
+    return (needed > asrc->avail) ? (needed - asrc->avail) : 0U;
+}
+
+/*!
+ * @brief Convert full I2S frames.
+ *
+ * All the inFrames input frames are taken in, then up to maxFrames output
+ * frames are written to out, as many as the history allows: with the input
+ * frames from I2S_AsrcInputFrames() that is exactly the frames asked for.
+ * inFrames and maxFrames are I2S_ASRC_BATCH_FRAMES at most.
+ *
+ * @return the output frames.
+ */
+uint32_t I2S_AsrcProcess(
+    i2s_asrc_t *asrc, const uint8_t *in, uint32_t inFrames, uint8_t *out, uint32_t maxFrames, uint32_t channels)
+{
+    const int32_t *s = (const int32_t *)in;
+    int32_t *d = (int32_t *)out;
+    int32_t coef[I2S_ASRC_TAPS];
+    uint32_t frames = 0U;
+    uint32_t w;
+
+    assert((inFrames <= I2S_ASRC_BATCH_FRAMES) && (maxFrames <= I2S_ASRC_BATCH_FRAMES));
+
+    if ((asrc->start + asrc->avail + inFrames) > I2S_ASRC_HIST_LEN)
+    {
+        I2S_AsrcCompact(asrc, channels);
+    }
+
+    /* De-interleave the input frames at the end of the window */
+    w = asrc->start + asrc->avail;
+    for (uint32_t n = 0U; n < channels; n++)
+    {
+        int32_t *h = &asrc->hist[n][w];
+
+        for (uint32_t f = 0U; f < inFrames; f++)
+        {
+            h[f] = s[(f * I2S_CH_NUM) + n];
+        }
+    }
+    asrc->avail += inFrames;
+
+    while ((asrc->avail >= I2S_ASRC_TAPS) && (frames < maxFrames))
+    {
+        uint64_t pos;
+        uint32_t adv;
+
+        I2S_AsrcCoef(asrc->frac, coef);
+
+        for (uint32_t n = 0U; n < channels; n++)
+        {
+            d[n] = I2S_AsrcDot(&asrc->hist[n][asrc->start], coef);
+        }
+
+        for (uint32_t n = channels; n < I2S_CH_NUM; n++)
+        {
+            d[n] = 0;
+        }
+
+        d += I2S_CH_NUM;
+        frames++;
+
+        /* Slide the window by the integer part of the step */
+        pos = (uint64_t)asrc->frac + asrc->step;
+        adv = (uint32_t)(pos >> 32U);
+
+        asrc->frac = (uint32_t)pos;
+        asrc->start += adv;
+        asrc->avail -= adv;
+    }
+
+    return frames;
+}
+
+#endif /* I2S_ASRC */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __I2S_ASRC_H__
+#define __I2S_ASRC_H__ 1
+
+#include "fsl_common.h"
+#include "usb_device_descriptor.h"
+
+#include "i2s.h"
+
+/**
+ * Asynchronous sample rate converter between the I2S and the USB clock domains
+ * (I2S_ASRC).
+ *
+ * With the ASRC the USB side runs at exactly the nominal rate whatever the TDM
+ * clock is doing: the IN packets carry the nominal number of frames (the
+ * implicit feedback is gone) and the explicit feedback reports the nominal
+ * rate. The rings still track the I2S side with their fill level (and, for
+ * TX, the rate measured against the SOF), that now steers the conversion
+ * ratio instead of the USB packets.
+ *
+ * The converter is a polyphase windowed sinc of I2S_ASRC_TAPS taps and
+ * I2S_ASRC_PHASES phases, the coefficients of the output frame are linearly
+ * interpolated between the two nearest phases and shared by all the channels.
+ * The response is within 0.1 dB up to 0.31 fs (15 kHz at 48 kHz) and -3.7 dB
+ * at 0.42 fs, the images and the interpolation error stay below -85 dB up to
+ * 0.375 fs. Samples and coefficients are Q1.31 / Q2.30 as for the gains (see
+ * I2S_GainApply()), the inner loop is one SMMLAR per tap and channel.
+ *
+ * The input frames are saved per channel in a linear history, so that each
+ * output frame is a dot product over contiguous samples. Only the first
+ * `channels` slots of the I2S frames are converted, the others are zeroed.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * Set I2S_ASRC to (1) to convert between the I2S and the USB clocks in both
+ * directions, see above. This requires the copy mode on both sides
+ * (I2S_RX_DMA_INTERLEAVE = 0 and I2S_TX_DMA_INTERLEAVE = 0), the converted
+ * frames do not fit in the rings.
+ */
+#ifndef I2S_ASRC
+#define I2S_ASRC (0)
+#endif
+
+/* Taps of each phase, multiple of 4 [16 taps] */
+#define I2S_ASRC_TAPS (16U)
+
+/* Phases of the filter, power of two [64 phases] */
+#define I2S_ASRC_PHASE_BITS (6U)
+#define I2S_ASRC_PHASES (1U << I2S_ASRC_PHASE_BITS)
+
+/**
+ * Cutoff of the prototype filter in 1/1000 of the sampling rate and shape
+ * of its Kaiser window.
+ */
+#define I2S_ASRC_CUTOFF (440U)
+#define I2S_ASRC_KAISER_BETA (9.0f)
+
+/**
+ * Max frames in or out of a single conversion, a max packet with some margin
+ * for the ratio [15 frames]
+ */
+#define I2S_ASRC_BATCH_FRAMES ((HS_ISO_IN_ENDP_PACKET_SIZE_MAX / (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)) + 3U)
+
+/**
+ * Length of the history of each channel, the window of the filter plus room
+ * for two batches before the window is moved back [46 frames]
+ */
+#define I2S_ASRC_HIST_LEN (I2S_ASRC_TAPS + (2U * I2S_ASRC_BATCH_FRAMES))
+
+#if (I2S_ASRC_TAPS % 4U) != 0U
+#error "I2S_ASRC_TAPS must be a multiple of 4"
+#endif
+
+typedef struct _i2s_asrc
+{
+    uint64_t step;  /* Input frames per output frame, Q32.32 */
+    uint32_t frac;  /* Position of the next output frame after the window, Q0.32 */
+    uint32_t start; /* First frame of the window in hist */
+    uint32_t avail; /* Frames in hist from start */
+    int32_t hist[I2S_CH_NUM][I2S_ASRC_HIST_LEN];
+} i2s_asrc_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+#if I2S_ASRC
+void I2S_AsrcInit(i2s_asrc_t *asrc);
+void I2S_AsrcReset(i2s_asrc_t *asrc);
+void I2S_AsrcSetRatio(i2s_asrc_t *asrc, uint32_t in, uint32_t out);
+uint32_t I2S_AsrcInputFrames(const i2s_asrc_t *asrc, uint32_t frames);
+uint32_t I2S_AsrcProcess(
+    i2s_asrc_t *asrc, const uint8_t *in, uint32_t inFrames, uint8_t *out, uint32_t maxFrames, uint32_t channels);
+#endif
+
+#endif /* __I2S_ASRC_H__ */
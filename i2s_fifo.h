@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __I2S_FIFO_H__
+#define __I2S_FIFO_H__ 1
+
+#include "fsl_device_registers.h"
+
+/**
+ * Fill level of a single-producer / single-consumer stream between the I2S DMA
+ * buffers and the USB packets.
+ *
+ * The producer only writes head and the consumer only writes tail, each one
+ * from its own interrupt. Both are free running 32-bit frame counters: they
+ * are read and written atomically on the Cortex-M33 and their difference is
+ * correct across the wrap, so no critical section is needed.
+ *
+ * The barriers order the accesses to the data against the counters: the
+ * frames are in memory before head publishes them (release) and the level is
+ * read before the frames it covers (acquire).
+ */
+typedef struct
+{
+    volatile uint32_t head; /* Frames produced */
+    volatile uint32_t tail; /* Frames consumed */
+} i2s_fifo_t;
+
+/*!
+ * @brief Empty the FIFO. Only when both sides are stopped.
+ */
+static inline void I2S_FifoReset(i2s_fifo_t *fifo)
+{
+    fifo->head = 0;
+    fifo->tail = 0;
+}
+
+/*!
+ * @brief Producer side, publish frames.
+ */
+static inline void I2S_FifoPush(i2s_fifo_t *fifo, uint32_t frames)
+{
+    __DMB();
+    fifo->head = fifo->head + frames;
+}
+
+/*!
+ * @brief Consumer side, release frames.
+ */
+static inline void I2S_FifoPop(i2s_fifo_t *fifo, uint32_t frames)
+{
+    __DMB();
+    fifo->tail = fifo->tail + frames;
+}
+
+/*!
+ * @brief Consumer side, move the tail so that level frames are left.
+ */
+static inline void I2S_FifoSeek(i2s_fifo_t *fifo, uint32_t level)
+{
+    uint32_t head = fifo->head;
+
+    __DMB();
+    fifo->tail = head - level;
+}
+
+/*!
+ * @brief Frames produced and not consumed yet.
+ *
+ * Negative when the consumer went ahead of the producer (underrun).
+ */
+static inline int32_t I2S_FifoLevel(const i2s_fifo_t *fifo)
+{
+    int32_t level = (int32_t)(fifo->head - fifo->tail);
+
+    __DMB();
+
+    return level;
+}
+
+#endif /* __I2S_FIFO_H__ */
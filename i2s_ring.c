@@ -0,0 +1,675 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "fsl_common.h"
+#include "fsl_device_registers.h"
+
+#include "fsl_i2s.h"
+#include "fsl_i2s_dma.h"
+#include "fsl_dma.h"
+
+#include "i2s.h"
+#include "i2s_ring.h"
+#include "prof.h"
+#include "trace.h"
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/*!
+ * @brief Wrap a position advanced by at most size bytes.
+ *
+ * The ring is not a power of two in bytes (I2S_RX_BUFF_NUM / I2S_TX_BUFF_NUM
+ * buffers of 26 frames by default, 104 frames), a compare and subtract is
+ * cheaper than the division of the modulo.
+ */
+static inline uint32_t I2S_RingWrap(uint32_t pos, uint32_t size)
+{
+    return (pos >= size) ? (pos - size) : pos;
+}
+
+/*!
+ * @brief Bytes moved by each instance in a frame.
+ */
+static inline uint32_t I2S_RingInstLen(const i2s_ring_t *ring)
+{
+    return ring->frameLen / ring->instNum;
+}
+
+/*!
+ * @brief Is the ring following the geometry the build is configured for.
+ */
+static inline bool I2S_RingIsDefault(const i2s_ring_t *ring)
+{
+    return (ring->instNum == I2S_INST_NUM) && (ring->frameLen == I2S_FRAME_LEN);
+}
+
+/*!
+ * @brief Is the instance the SCK / WS master of the bus.
+ */
+static inline bool I2S_RingIsMaster(const i2s_ring_t *ring, uint32_t inst)
+{
+    return (inst == 0U) && (ring->masterDiv != 0U);
+}
+
+/*!
+ * @brief Copy layout, interleave frames from the instance rings.
+ *
+ * Called with instNum and instLen constant for the configured geometry, so
+ * that the copies are inlined as a few word moves instead of calls to memcpy.
+ */
+__STATIC_FORCEINLINE void I2S_RingGather(i2s_ring_t *ring, uint8_t *buffer, uint32_t frames, uint32_t instNum, uint32_t instLen)
+{
+    uint32_t instSize = I2S_RingFrames(ring) * instLen;
+
+    for (uint32_t k = 0; k < frames; k++)
+    {
+        for (uint32_t inst = 0; inst < instNum; inst++)
+        {
+            memcpy(buffer + (inst * instLen), &ring->data[(inst * instSize) + ring->pos], instLen);
+        }
+
+        buffer += instNum * instLen;
+        ring->pos = I2S_RingWrap(ring->pos + instLen, instSize);
+    }
+}
+
+/*!
+ * @brief Copy layout, de-interleave frames into the instance rings.
+ *
+ * Inverse of I2S_RingGather().
+ */
+__STATIC_FORCEINLINE void I2S_RingScatter(i2s_ring_t *ring, const uint8_t *buffer, uint32_t frames, uint32_t instNum, uint32_t instLen)
+{
+    uint32_t instSize = I2S_RingFrames(ring) * instLen;
+
+    for (uint32_t k = 0; k < frames; k++)
+    {
+        for (uint32_t inst = 0; inst < instNum; inst++)
+        {
+            memcpy(&ring->data[(inst * instSize) + ring->pos], buffer + (inst * instLen), instLen);
+        }
+
+        buffer += instNum * instLen;
+        ring->pos = I2S_RingWrap(ring->pos + instLen, instSize);
+    }
+}
+
+/*!
+ * @brief Update the statistics after a USB batch.
+ *
+ * The DMA side can only take the level out of range before the batch: a TX
+ * ring drained by the DMA (or an RX ring lapped by it) is checked on the level
+ * before the frames were written (read), that the batch may have brought back
+ * in range. The TX level is counted from the start of the buffer the DMA is
+ * moving, the frames of that buffer already sent can be written over.
+ */
+static inline void I2S_RingUpdateStats(i2s_ring_t *ring, uint32_t frames)
+{
+    int32_t level = I2S_FifoLevel(&ring->fifo);
+    int32_t prev = (ring->dir == kI2S_RingRx) ? (level + (int32_t)frames) : (level - (int32_t)frames);
+    int32_t max = (int32_t)I2S_RingFrames(ring) + ((ring->dir == kI2S_RingTx) ? (int32_t)ring->buffFrames : 0);
+
+    ring->stats.frames += frames;
+
+    if (MIN(level, prev) < 0)
+    {
+        ring->stats.underruns++;
+        TRACE((ring->dir == kI2S_RingRx) ? kTRACE_RxUnderrun : kTRACE_TxUnderrun, MIN(level, prev));
+    }
+    else if (MAX(level, prev) > max)
+    {
+        ring->stats.overruns++;
+        TRACE((ring->dir == kI2S_RingRx) ? kTRACE_RxOverrun : kTRACE_TxOverrun, MAX(level, prev));
+    }
+
+    if (level < ring->stats.levelMin)
+    {
+        ring->stats.levelMin = level;
+    }
+
+    if (level > ring->stats.levelMax)
+    {
+        ring->stats.levelMax = level;
+    }
+}
+
+/*!
+ * @brief Copy layout, queue one buffer of one instance.
+ */
+static inline void I2S_RingQueue(i2s_ring_t *ring, uint32_t inst, uint32_t buf)
+{
+    i2s_transfer_t transfer = ring->transfer[(inst * ring->buffNum) + buf];
+
+    if (ring->dir == kI2S_RingRx)
+    {
+        I2S_RxTransferReceiveDMA(ring->base[inst], &ring->i2sDmaHandle[inst], transfer);
+    }
+    else
+    {
+        I2S_TxTransferSendDMA(ring->base[inst], &ring->i2sDmaHandle[inst], transfer);
+    }
+}
+
+/*!
+ * @brief Profiler probe of the DMA callbacks.
+ */
+static inline prof_probe_t I2S_RingProbe(const i2s_ring_t *ring)
+{
+    return (ring->dir == kI2S_RingRx) ? kPROF_RxCallback : kPROF_TxCallback;
+}
+
+/*!
+ * @brief Buffer done.
+ *
+ * Bookkeeping common to both the layouts, called every time a full buffer has
+ * been moved by the DMA on all the instances.
+ */
+static inline void I2S_RingBufferDone(i2s_ring_t *ring)
+{
+    ring->nextBuf = (ring->nextBuf + 1U) & (ring->buffNum - 1U);
+    ring->stats.buffers++;
+
+    ring->traceSample = TRACE_Sample(&ring->traceTime);
+
+    if (ring->traceSample)
+    {
+        TRACE((ring->dir == kI2S_RingRx) ? kTRACE_RxLevel : kTRACE_TxLevel, I2S_FifoLevel(&ring->fifo));
+    }
+
+    if (ring->bufferDone != NULL)
+    {
+        ring->bufferDone(ring);
+    }
+}
+
+/*!
+ * @brief DMA callback.
+ *
+ * Interleave layout: called by the descriptor closing each buffer of the ring.
+ * The descriptor chain is circular so there is nothing to re-queue.
+ */
+static void I2S_RingDmaCallback(dma_handle_t *handle, void *userData, bool transferDone, uint32_t intmode)
+{
+    i2s_ring_t *ring = (i2s_ring_t *)userData;
+
+    PROF_BEGIN(I2S_RingProbe(ring));
+
+    I2S_RingBufferDone(ring);
+
+    PROF_END(I2S_RingProbe(ring));
+}
+
+/*!
+ * @brief I2S transfer callback.
+ *
+ * Copy layout: called when the buffer of the latest instance is done. The
+ * buffer is queued back at the end of the queue on all the instances.
+ */
+static void I2S_RingTransferCallback(I2S_Type *base, i2s_dma_handle_t *handle, status_t completionStatus, void *userData)
+{
+    i2s_ring_t *ring = (i2s_ring_t *)userData;
+
+    PROF_BEGIN(I2S_RingProbe(ring));
+
+    for (uint32_t inst = 0; inst < ring->instNum; inst++)
+    {
+        I2S_RingQueue(ring, inst, ring->nextBuf);
+    }
+
+    I2S_RingBufferDone(ring);
+
+    PROF_END(I2S_RingProbe(ring));
+}
+
+/*!
+ * @brief Reset the ring.
+ *
+ * Only when the DMA is stopped. The data is zeroed so that we send out
+ * silence until new data is written.
+ */
+static void I2S_RingReset(i2s_ring_t *ring)
+{
+    ring->nextBuf = 0;
+    ring->pos = 0;
+
+    I2S_FifoReset(&ring->fifo);
+    bzero(&ring->stats, sizeof(ring->stats));
+
+    if (ring->interleave)
+    {
+        bzero(ring->data, I2S_RingSize(ring) + ring->tailLen);
+    }
+    else
+    {
+        bzero(ring->data, I2S_RingSize(ring));
+    }
+}
+
+/*!
+ * @brief Read frames (RX).
+ *
+ * Interleave layout: buffer is ignored, the frames are returned in place. When
+ * crossing the end of the ring, the frames at the beginning of the ring are
+ * mirrored in the tail so that they are always contiguous.
+ *
+ * Copy layout: the frames are interleaved into buffer.
+ */
+uint8_t *I2S_RingRead(i2s_ring_t *ring, uint8_t *buffer, uint32_t frames)
+{
+    uint32_t size = frames * ring->frameLen;
+
+    if (ring->interleave)
+    {
+        uint32_t ringSize = I2S_RingSize(ring);
+
+        buffer = &ring->data[ring->pos];
+
+        if ((ring->pos + size) > ringSize)
+        {
+            memcpy(&ring->data[ringSize], &ring->data[0], (ring->pos + size) - ringSize);
+        }
+
+        ring->pos = I2S_RingWrap(ring->pos + size, ringSize);
+    }
+    else if (I2S_RingIsDefault(ring))
+    {
+        I2S_RingGather(ring, buffer, frames, I2S_INST_NUM, I2S_FRAME_LEN_PER_INST);
+    }
+    else
+    {
+        I2S_RingGather(ring, buffer, frames, ring->instNum, I2S_RingInstLen(ring));
+    }
+
+    I2S_FifoPop(&ring->fifo, frames);
+    I2S_RingUpdateStats(ring, frames);
+
+    return buffer;
+}
+
+/*!
+ * @brief Write frames (TX).
+ *
+ * Interleave layout: buffer is expected at I2S_RingPtr() and is moved there if
+ * it is not (for example when received in the tail, or further in the ring
+ * behind a packet that came in short). Whatever overflowed in the tail is moved
+ * back at the beginning of the ring.
+ *
+ * Copy layout: the frames are de-interleaved from buffer.
+ */
+void I2S_RingWrite(i2s_ring_t *ring, uint8_t *buffer, uint32_t frames)
+{
+    uint32_t size = frames * ring->frameLen;
+
+    if (ring->interleave)
+    {
+        uint32_t ringSize = I2S_RingSize(ring);
+
+        if (buffer != &ring->data[ring->pos])
+        {
+            memmove(&ring->data[ring->pos], buffer, size);
+        }
+
+        if ((ring->pos + size) > ringSize)
+        {
+            memcpy(&ring->data[0], &ring->data[ringSize], (ring->pos + size) - ringSize);
+        }
+
+        ring->pos = I2S_RingWrap(ring->pos + size, ringSize);
+    }
+    else if (I2S_RingIsDefault(ring))
+    {
+        I2S_RingScatter(ring, buffer, frames, I2S_INST_NUM, I2S_FRAME_LEN_PER_INST);
+    }
+    else
+    {
+        I2S_RingScatter(ring, buffer, frames, ring->instNum, I2S_RingInstLen(ring));
+    }
+
+    I2S_FifoPush(&ring->fifo, frames);
+    I2S_RingUpdateStats(ring, frames);
+}
+
+/*!
+ * @brief Stop the DMA and reset the ring.
+ *
+ * The master instance is left enabled, only its DMA is stopped.
+ */
+void I2S_RingStop(i2s_ring_t *ring)
+{
+    for (uint32_t inst = 0; inst < ring->instNum; inst++)
+    {
+        if (ring->interleave)
+        {
+            if (!I2S_RingIsMaster(ring, inst))
+            {
+                I2S_Disable(ring->base[inst]);
+            }
+
+            if (ring->dir == kI2S_RingRx)
+            {
+                I2S_RxEnableDMA(ring->base[inst], false);
+            }
+            else
+            {
+                I2S_TxEnableDMA(ring->base[inst], false);
+            }
+
+            DMA_AbortTransfer(&ring->dmaHandle[inst]);
+        }
+        else
+        {
+            I2S_TransferAbortDMA(ring->base[inst], &ring->i2sDmaHandle[inst]);
+
+            if (I2S_RingIsMaster(ring, inst))
+            {
+                I2S_Enable(ring->base[inst]);
+            }
+        }
+    }
+
+    I2S_RingReset(ring);
+}
+
+/*!
+ * @brief Master mode, set the SCK divider (see I2S_MasterDivider()).
+ *
+ * The master is briefly disabled, the whole bus stops meanwhile: only call it
+ * with the rings on the bus stopped.
+ */
+void I2S_RingSetMasterDiv(i2s_ring_t *ring, uint32_t div)
+{
+    I2S_Type *base = ring->base[0];
+
+    assert((ring->masterDiv != 0U) && (div != 0U));
+
+    ring->masterDiv = div;
+
+    I2S_Disable(base);
+    base->DIV = I2S_DIV_DIV(div - 1U);
+    I2S_Enable(base);
+}
+
+/*!
+ * @brief Reset the ring and start the DMA.
+ *
+ * The master kept clocking the bus while the ring was stopped, so its FIFO
+ * holds whatever slot came last and flushing it would land anywhere in the
+ * frame. It is disabled first (the whole bus stops, as in
+ * I2S_RingSetMasterDiv()), flushed and enabled last: the other instances wait
+ * for its first WS and all of them start on slot 0. The rings of the other
+ * direction see one short frame meanwhile.
+ */
+void I2S_RingStart(i2s_ring_t *ring)
+{
+    I2S_RingReset(ring);
+
+    if (ring->masterDiv != 0U)
+    {
+        I2S_Disable(ring->base[0]);
+        ring->base[0]->FIFOCFG |= (ring->dir == kI2S_RingRx) ? I2S_FIFOCFG_EMPTYRX_MASK : I2S_FIFOCFG_EMPTYTX_MASK;
+    }
+
+    /* Backwards, the master (if any) is the first instance and is enabled last */
+    for (uint32_t inst = ring->instNum; inst-- > 0U;)
+    {
+        if (ring->interleave)
+        {
+            /**
+             * The head descriptor is a copy of the first descriptor of the
+             * chain, the last descriptor links back to the first one.
+             */
+            DMA_SubmitChannelDescriptor(&ring->dmaHandle[inst], &ring->desc[inst * I2S_RingFrames(ring)]);
+            DMA_StartTransfer(&ring->dmaHandle[inst]);
+
+            /* Drop any stale (and possibly misaligned) sample left in the FIFO */
+            if (ring->dir == kI2S_RingRx)
+            {
+                ring->base[inst]->FIFOCFG |= I2S_FIFOCFG_EMPTYRX_MASK;
+                I2S_RxEnableDMA(ring->base[inst], true);
+            }
+            else
+            {
+                ring->base[inst]->FIFOCFG |= I2S_FIFOCFG_EMPTYTX_MASK;
+                I2S_TxEnableDMA(ring->base[inst], true);
+            }
+
+            I2S_Enable(ring->base[inst]);
+        }
+        else
+        {
+            for (uint32_t buf = 0; buf < ring->buffNum; buf++)
+            {
+                I2S_RingQueue(ring, inst, buf);
+            }
+        }
+    }
+}
+
+/*!
+ * @brief I2S parameters setup.
+ *
+ * Function to setup the I2S parameters.
+ */
+static void I2S_RingSetupParams(i2s_ring_t *ring, i2s_config_t *config)
+{
+    /**
+     * Default values:
+     *   config->masterSlave = kI2S_MasterSlaveNormalSlave;
+     *   config->mode = kI2S_ModeI2sClassic;
+     *   config->rightLow = false;
+     *   config->leftJust = false;
+     *   config->pdmData = false;
+     *   config->sckPol = false;
+     *   config->wsPol = false;
+     *   config->divider = 1;
+     *   config->oneChannel = false;
+     *   config->dataLength = 16;
+     *   config->frameLength = 32;
+     *   config->position = 0;
+     *   config->watermark = 4;
+     *   config->txEmptyZero = false; (true for TX)
+     *   config->pack48 = false;
+     */
+    if (ring->dir == kI2S_RingRx)
+    {
+        I2S_RxGetDefaultConfig(config);
+    }
+    else
+    {
+        I2S_TxGetDefaultConfig(config);
+    }
+
+    config->masterSlave = kI2S_MasterSlaveNormalSlave; /** Normal Slave */
+    config->mode = kI2S_ModeDspWsShort;                /** DSP mode, WS having one clock long pulse */
+    config->divider = (ring->masterDiv != 0U) ? ring->masterDiv : 1U;
+    config->dataLength = ring->geometry->slotBits;
+    config->frameLength = TO_BITS(ring->frameOffset + ring->frameLen);
+}
+
+/*!
+ * @brief DMA channels setup.
+ *
+ * Function to setup the DMA channels (one for each I2S instance).
+ */
+static void DMA_RingSetupChannels(i2s_ring_t *ring)
+{
+    for (uint32_t inst = 0; inst < ring->instNum; inst++)
+    {
+        DMA_EnableChannel(DMA, ring->dmaChannel[inst]);
+        DMA_SetChannelPriority(DMA, ring->dmaChannel[inst], ring->dmaPrio[inst]);
+        DMA_CreateHandle(&ring->dmaHandle[inst], DMA, ring->dmaChannel[inst]);
+
+        if (ring->interleave)
+        {
+            DMA_EnableChannelPeriphRq(DMA, ring->dmaChannel[inst]);
+        }
+    }
+}
+
+/*!
+ * @brief Interleave layout, descriptors setup.
+ *
+ * One descriptor per frame: the DMA moves the bytes of the instance in / out
+ * of its slot of the interleaved frame. Only the descriptor closing a buffer
+ * on the latest instance is raising the interrupt, so every time the callback
+ * is called the whole frame has been moved and not just part of it.
+ */
+static void DMA_RingSetupDescriptors(i2s_ring_t *ring, uint32_t inst)
+{
+    uint32_t instLen = I2S_RingInstLen(ring);
+    uint32_t frames = I2S_RingFrames(ring);
+    dma_descriptor_t *desc = &ring->desc[inst * frames];
+
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        bool intA = (inst == ring->lastInst) && (((frame + 1U) % ring->buffFrames) == 0U);
+        uint8_t *slot = &ring->data[(frame * ring->frameLen) + (inst * instLen)];
+        dma_descriptor_t *next = &desc[(frame + 1U) % frames];
+
+        if (ring->dir == kI2S_RingRx)
+        {
+            DMA_SetupDescriptor(&desc[frame],
+                                DMA_CHANNEL_XFER(1UL, 0UL, intA, 0UL, ring->slotSize, 0UL, 1UL, instLen),
+                                (void *)&ring->base[inst]->FIFORD, slot, next);
+        }
+        else
+        {
+            DMA_SetupDescriptor(&desc[frame],
+                                DMA_CHANNEL_XFER(1UL, 0UL, intA, 0UL, ring->slotSize, 1UL, 0UL, instLen),
+                                slot, (void *)&ring->base[inst]->FIFOWR, next);
+        }
+    }
+
+    if (inst == ring->lastInst)
+    {
+        DMA_SetCallback(&ring->dmaHandle[inst], I2S_RingDmaCallback, ring);
+    }
+}
+
+/*!
+ * @brief Copy layout, transfers setup.
+ *
+ * Install the callback only on the latest instance so every time the callback
+ * is called we are sure to have gathered the whole final frame.
+ */
+static void I2S_RingSetupTransfers(i2s_ring_t *ring, uint32_t inst)
+{
+    uint32_t buffSize = ring->buffFrames * I2S_RingInstLen(ring);
+    uint8_t *data = &ring->data[inst * ring->buffNum * buffSize];
+    i2s_dma_transfer_callback_t callback = NULL;
+    void *userData = NULL;
+
+    for (uint32_t buf = 0; buf < ring->buffNum; buf++)
+    {
+        ring->transfer[(inst * ring->buffNum) + buf].data = &data[buf * buffSize];
+        ring->transfer[(inst * ring->buffNum) + buf].dataSize = buffSize;
+    }
+
+    if (inst == ring->lastInst)
+    {
+        callback = I2S_RingTransferCallback;
+        userData = ring;
+    }
+
+    if (ring->dir == kI2S_RingRx)
+    {
+        I2S_RxTransferCreateHandleDMA(ring->base[inst], &ring->i2sDmaHandle[inst], &ring->dmaHandle[inst], callback, userData);
+    }
+    else
+    {
+        I2S_TxTransferCreateHandleDMA(ring->base[inst], &ring->i2sDmaHandle[inst], &ring->dmaHandle[inst], callback, userData);
+    }
+}
+
+/*!
+ * @brief I2S DMA setup.
+ *
+ * Function to setup I2S (with secondary channels) and DMA.
+ */
+static void I2S_DMA_RingSetup(i2s_ring_t *ring, i2s_config_t *config)
+{
+    uint32_t instLen = I2S_RingInstLen(ring);
+    uint32_t pairLen = ring->slotSize * I2S_CH_NUM_PER_PAIR;
+
+    for (uint32_t inst = 0; inst < ring->instNum; inst++)
+    {
+        config->position = TO_BITS(ring->frameOffset + (inst * instLen));
+        config->masterSlave = I2S_RingIsMaster(ring, inst) ? kI2S_MasterSlaveNormalMaster : kI2S_MasterSlaveNormalSlave;
+
+        if (ring->dir == kI2S_RingRx)
+        {
+            I2S_RxInit(ring->base[inst], config);
+        }
+        else
+        {
+            I2S_TxInit(ring->base[inst], config);
+        }
+
+        /* The first pair is the primary channel */
+        for (uint32_t pair = 1; pair < (instLen / pairLen); pair++)
+        {
+            I2S_EnableSecondaryChannel(ring->base[inst], (i2s_secondary_channel_t)(kI2S_SecondaryChannel1 + pair - 1U),
+                                       false, TO_BITS(ring->frameOffset + (inst * instLen) + (pair * pairLen)));
+        }
+
+        if (ring->interleave)
+        {
+            DMA_RingSetupDescriptors(ring, inst);
+        }
+        else
+        {
+            I2S_RingSetupTransfers(ring, inst);
+        }
+    }
+}
+
+/*!
+ * @brief Ring setup.
+ *
+ * Entry point function for I2S and DMA setup of all the instances of the ring.
+ */
+void I2S_RingInit(i2s_ring_t *ring)
+{
+    const i2s_tdm_geometry_t *geometry = ring->geometry;
+    i2s_config_t config = {0};
+
+    ring->instNum = geometry->instNum;
+    ring->slotSize = geometry->slotBits / 8U;
+    ring->frameLen = geometry->slots * ring->slotSize;
+    ring->frameOffset = geometry->slotOffset * ring->slotSize;
+
+    /**
+     * The instances request the DMA at the same time, on the same WS edge, and
+     * the channels with the same priority are served by increasing number: the
+     * latest instance is the one with the highest DMA channel.
+     */
+    ring->lastInst = 0U;
+    for (uint32_t inst = 1U; inst < ring->instNum; inst++)
+    {
+        if (ring->dmaChannel[inst] > ring->dmaChannel[ring->lastInst])
+        {
+            ring->lastInst = inst;
+        }
+    }
+
+    /* The buffer index is wrapped with a mask */
+    assert((ring->buffNum & (ring->buffNum - 1U)) == 0U);
+    assert((ring->frameLen % ring->instNum) == 0U);
+    assert((I2S_RingInstLen(ring) % (ring->slotSize * I2S_CH_NUM_PER_PAIR)) == 0U);
+    assert((I2S_RingInstLen(ring) / (ring->slotSize * I2S_CH_NUM_PER_PAIR)) <= 4U); /* Primary + 3 secondary */
+
+    I2S_RingSetupParams(ring, &config);
+    DMA_RingSetupChannels(ring);
+    I2S_DMA_RingSetup(ring, &config);
+
+    /* The bus is clocked from now on, whether the ring is started or not */
+    if (ring->masterDiv != 0U)
+    {
+        I2S_Enable(ring->base[0]);
+    }
+}
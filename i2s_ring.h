@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __I2S_RING_H__
+#define __I2S_RING_H__ 1
+
+#include "fsl_dma.h"
+#include "fsl_i2s.h"
+#include "fsl_i2s_dma.h"
+
+#include "i2s.h"
+#include "i2s_fifo.h"
+
+/**
+ * Stream ring between a group of I2S instances and the USB packets, shared by
+ * the RX and TX paths.
+ *
+ * The ring is made of buffNum ping-pong buffers of buffFrames frames each. The
+ * frames follow the TDM geometry: a frame is frameLen bytes (slotSize bytes per
+ * TDM slot) spread over instNum I2S instances, each one moving frameLen /
+ * instNum bytes with its own DMA channel.
+ * The DMA side completes one buffer at a time (bufferDone is called, nextBuf is
+ * the next buffer), the USB side reads / writes any number of frames at a time
+ * with I2S_RingRead() / I2S_RingWrite().
+ *
+ * Two layouts are supported:
+ *
+ *  interleave) data is a single ring of interleaved frames followed by tailLen
+ *              bytes of tail. The DMA moves each instance in and out of its
+ *              slot of the frame with one linked descriptor per frame, the USB
+ *              packets are read / written straight in the ring.
+ *
+ *  copy)       data is one ring per instance (instNum x ring size), moved with
+ *              the fsl_i2s_dma transfers. The frames are (de-)interleaved by
+ *              the CPU on the USB side.
+ *
+ * The storage (data, DMA handles, descriptors or transfers) is provided by the
+ * user so that each path can place it where needed (USB RAM, alignment).
+ *
+ * With masterDiv set the first instance is the SCK / WS master of the bus
+ * (see I2S_MASTER): it is enabled by I2S_RingInit() and keeps running when the
+ * ring is stopped, so that the other rings sharing the bus keep their clock.
+ * I2S_RingStart() restarts it to start the ring on slot 0.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+typedef enum _i2s_ring_dir
+{
+    kI2S_RingRx = 0U, /* I2S -> USB, the DMA is the producer */
+    kI2S_RingTx,      /* USB -> I2S, the DMA is the consumer */
+} i2s_ring_dir_t;
+
+/**
+ * Statistics, cleared on every I2S_RingStart(). The level is the one seen by
+ * the USB side after each batch: below zero the USB side went ahead of the DMA
+ * (underrun), above the ring size the DMA went ahead of the USB side (overrun).
+ */
+typedef struct
+{
+    uint32_t buffers;   /* Buffers completed by the DMA */
+    uint32_t frames;    /* Frames read / written by the USB side */
+    uint32_t underruns; /* USB batches leaving a negative level */
+    uint32_t overruns;  /* USB batches leaving a level over the ring size */
+    int32_t levelMin;
+    int32_t levelMax;
+} i2s_ring_stats_t;
+
+typedef struct _i2s_ring i2s_ring_t;
+
+/*!
+ * @brief Called (DMA interrupt context) every time the DMA completes a buffer.
+ */
+typedef void (*i2s_ring_callback_t)(i2s_ring_t *ring);
+
+struct _i2s_ring
+{
+    /* Configuration, filled in by the user */
+    i2s_ring_dir_t dir;
+    bool interleave;
+    const i2s_tdm_geometry_t *geometry;
+    uint32_t buffNum; /* Power of two */
+    uint32_t buffFrames;
+    uint32_t tailLen;
+    I2S_Type **base;
+    uint32_t *dmaChannel;
+    dma_priority_t *dmaPrio;
+    uint8_t *data;
+    dma_handle_t *dmaHandle;        /* instNum */
+    dma_descriptor_t *desc;         /* interleave: instNum x ring frames */
+    i2s_dma_handle_t *i2sDmaHandle; /* copy: instNum */
+    i2s_transfer_t *transfer;       /* copy: instNum x buffNum */
+    i2s_ring_callback_t bufferDone;
+    uint32_t masterDiv; /* SCK divider of the first instance, 0 when slave */
+
+    /* From the geometry, set by I2S_RingInit() */
+    uint32_t instNum;
+    uint32_t slotSize;
+    uint32_t frameLen;
+    uint32_t frameOffset; /* Bytes on the bus before the first slot */
+    uint32_t lastInst;    /* Instance served last by the DMA */
+
+    /* State */
+    volatile uint32_t nextBuf;
+    uint32_t pos;
+    i2s_fifo_t fifo;
+    i2s_ring_stats_t stats;
+    uint32_t traceTime; /* DWT timestamp of the last sampled trace */
+    bool traceSample;   /* Sampled events to trace on this buffer */
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+void I2S_RingInit(i2s_ring_t *ring);
+void I2S_RingStart(i2s_ring_t *ring);
+void I2S_RingStop(i2s_ring_t *ring);
+void I2S_RingSetMasterDiv(i2s_ring_t *ring, uint32_t div);
+uint8_t *I2S_RingRead(i2s_ring_t *ring, uint8_t *buffer, uint32_t frames);
+void I2S_RingWrite(i2s_ring_t *ring, uint8_t *buffer, uint32_t frames);
+
+/*!
+ * @brief Number of frames in the ring.
+ */
+static inline uint32_t I2S_RingFrames(const i2s_ring_t *ring)
+{
+    return ring->buffNum * ring->buffFrames;
+}
+
+/*!
+ * @brief Size of the ring, without the tail.
+ */
+static inline uint32_t I2S_RingSize(const i2s_ring_t *ring)
+{
+    return I2S_RingFrames(ring) * ring->frameLen;
+}
+
+/*!
+ * @brief Interleave layout, start of the tail.
+ */
+static inline uint8_t *I2S_RingTail(const i2s_ring_t *ring)
+{
+    return &ring->data[I2S_RingSize(ring)];
+}
+
+/*!
+ * @brief Interleave layout, where the next USB batch is read / written.
+ */
+static inline uint8_t *I2S_RingPtr(const i2s_ring_t *ring)
+{
+    return &ring->data[ring->pos];
+}
+
+#endif /* __I2S_RING_H__ */
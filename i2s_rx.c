@@ -7,6 +7,8 @@
 
 // TODO: Manage reset
 
+#include <inttypes.h>
+
 #include "usb_device_config.h"
 #include "usb.h"
 #include "usb_device.h"
@@ -21,7 +23,11 @@
 #include "fsl_dma.h"
 
 #include "i2s.h"
+#include "i2s_asrc.h"
+#include "i2s_ring.h"
 #include "i2s_rx.h"
+#include "prof.h"
+#include "trace.h"
 
 /**
  * Some considerations about the channels offsetting.
@@ -55,61 +61,265 @@
  * Definitions
  ******************************************************************************/
 /**
- * Set USE_FILTER_32_DOWN to (1) (and the FILTER_32 accordingly) when you are
- * retrieving 32-bits per channel from I2S but the useful data is encoded in
- * fewer bits (for example when only 24-bits are actually carrying the real
+ * Set USE_FILTER_32_DOWN to (1) (and I2S_TDM_DATA_BITS accordingly) when you
+ * are retrieving 32-bits per channel from I2S but the useful data is encoded
+ * in fewer bits (for example when only 24-bits are actually carrying the real
  * audio information out of 32-bits).
  *
  * Note: this only works with 32-bit channels.
  */
 #define USE_FILTER_32_DOWN (0)
-#define FILTER_32 (0xFFFFFF00)
+#define FILTER_32 (I2S_CH_DATA_MASK)
+
+/**
+ * Set I2S_RX_DMA_INTERLEAVE to (1) to have the DMA writing the frames coming
+ * from all the I2S instances directly into a single interleaved ring (one
+ * linked descriptor per instance per frame). The USB IN packets are then sent
+ * straight out of the ring with no CPU copy.
+ *
+ * Set it to (0) to use the per-instance ping-pong buffers and copy (and
+ * interleave) each frame when preparing the USB packet.
+ */
+#ifndef I2S_RX_DMA_INTERLEAVE
+#define I2S_RX_DMA_INTERLEAVE (1)
+#endif
+
+#if I2S_RX_DMA_INTERLEAVE && USE_FILTER_32_DOWN
+#error "USE_FILTER_32_DOWN requires the copy mode (I2S_RX_DMA_INTERLEAVE = 0)"
+#endif
+
+#if I2S_RX_DMA_INTERLEAVE && I2S_ASRC
+#error "I2S_ASRC requires the copy mode (I2S_RX_DMA_INTERLEAVE = 0)"
+#endif
+
+#if I2S_RX_DMA_INTERLEAVE && ((AUDIO_SAMPLING_RATE_MAX_KHZ * HS_ISO_ENDP_INTERVAL_MAX_UFRAMES) > 96U)
+#error "AUDIO_SAMPLING_RATE_MAX_KHZ above 96 (or 96 / microframes per packet) requires the copy mode (I2S_RX_DMA_INTERLEAVE = 0)"
+#endif
+
+#if I2S_RX_DMA_INTERLEAVE
+/**
+ * Size of the interleaved ring [6656 bytes]
+ */
+#define I2S_RX_RING_SIZE (I2S_RX_BUFF_NUM * I2S_RX_BUFF_SIZE)
+
+/**
+ * Number of frames in the interleaved ring [104 frames]
+ */
+#define I2S_RX_RING_FRAMES (I2S_RX_RING_SIZE / I2S_FRAME_LEN)
+
+/**
+ * A USB packet can start anywhere in the ring. When it is crossing the end of
+ * the ring, the frames at the beginning of the ring are mirrored in the tail
+ * right after the end so that the packet is always contiguous. Before the
+ * streaming is started the (zeroed) tail is also used to send silence
+ * [832 bytes]
+ */
+#define I2S_RX_RING_TAIL (USB_MAX_PACKET_IN_SIZE)
+#endif
+
+/**
+ * Implicit feedback PI controller.
+ *
+ * The fill level of the RX DMA buffers (in frames) is compared against
+ * I2S_RX_FEEDBACK_TARGET and the error drives a proportional-integral
+ * controller. The output of the controller is the (fractional) number of frames
+ * to send in the next microframe, in Q16. The fractional part is carried over
+ * in an accumulator so that on average we send exactly the number of frames the
+ * I2S side is producing.
+ *
+ * With KP = 1/64 and KI = 1/8192 (per microframe) the loop is close to
+ * critically damped and settles in ~30ms. With a packet every few microframes
+ * (USB_AudioI2s2UsbSetInterval()) the controller runs once per packet: the
+ * integral and the output are scaled by the microframes per packet, so the
+ * loop keeps the same dynamics.
+ */
+#define I2S_RX_FEEDBACK_FRAME_SIZE (I2S_FRAME_LEN)
+
+/**
+ * Nominal frames per microframe in Q16 for a sampling rate [Hz]: rate / 8000
+ * with 65536 / 8000 = 1024 / 125 [6.0 at 48 kHz, 5.5125 at 44.1 kHz]
+ */
+#define I2S_RX_FEEDBACK_NORMAL(rate) (((rate) * 1024U) / 125U)
+
+/**
+ * Target fill level [39 frames]
+ *
+ * The RX buffers are filled by the DMA in chunks of I2S_RX_BUFF_SIZE, so the
+ * measured fill level is a sawtooth. We target the mean value of the sawtooth
+ * when half of the DMA buffers are full.
+ */
+#define I2S_RX_FEEDBACK_TARGET \
+    ((((I2S_RX_BUFF_NUM / 2) * I2S_RX_BUFF_SIZE) - (I2S_RX_BUFF_SIZE / 2)) / I2S_RX_FEEDBACK_FRAME_SIZE)
+
+#define I2S_RX_FEEDBACK_KP (1024)
+#define I2S_RX_FEEDBACK_KI (8)
+
+/**
+ * Anti-windup: the integral term alone can never ask for more than one frame of
+ * correction per microframe.
+ */
+#define I2S_RX_FEEDBACK_INTEG_MAX ((1 << 16) / I2S_RX_FEEDBACK_KI)
+
+/**
+ * We can never send more than the max packet size or less than one frame below
+ * nominal.
+ */
+#define I2S_RX_FEEDBACK_DEV (1 << 16)
+
+#if I2S_ASRC
+/**
+ * ASRC ratio controller (I2S_ASRC).
+ *
+ * The IN packets carry the nominal frames and the ASRC takes from the ring the
+ * frames the I2S side is producing, in Q16 frames per microframe as for the
+ * implicit feedback. The fill level is a sawtooth of one DMA buffer that the
+ * ratio must not follow: the error is first low-pass filtered over about
+ * 2^I2S_RX_ASRC_FILTER_SHIFT packets (in 1/256 frames), then drives a PI
+ * controller much slower than the implicit feedback one. With KP = 16 LSB per
+ * frame and KI = KP^2 / 4 the loop is critically damped with a time constant
+ * of about half a second.
+ */
+#define I2S_RX_ASRC_FILTER_SHIFT (4U)
+#define I2S_RX_ASRC_KP_SHIFT (4U)
+#define I2S_RX_ASRC_KI_SHIFT (18U)
+
+/**
+ * Never take more than 1/16 of a frame per microframe away from the nominal.
+ */
+#define I2S_RX_ASRC_MAX_DEV ((1 << 16) / 16)
+#define I2S_RX_ASRC_INTEG_MAX (I2S_RX_ASRC_MAX_DEV << I2S_RX_ASRC_KI_SHIFT)
 
-#define I2S_RX_FEEDBACK_TH_UP (9U)
-#define I2S_RX_FEEDBACK_TH_DOWN (4U)
+/**
+ * Beyond that, for example when the IN packets are missed because the
+ * application is late, the ratio cannot keep up: once the level is a DMA
+ * buffer away from the target the packets carry one frame more (or less) than
+ * nominal, as with the implicit feedback [26 frames]
+ */
+#define I2S_RX_ASRC_LEVEL_MAX ((int32_t)(I2S_RX_BUFF_SIZE / I2S_RX_FEEDBACK_FRAME_SIZE) << 8)
+#endif
 
-#define I2S_RX_FEEDBACK_TH_STEP (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)
-#define I2S_RX_FEEDBACK_NORMAL (HS_ISO_IN_ENDP_PACKET_SIZE)
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void I2S_RxBufferDone(i2s_ring_t *ring);
 
 /*******************************************************************************
  * Variables
  ******************************************************************************/
-USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE)
-uint8_t g_usbBuffIn[USB_DATA_ALIGN_SIZE_MULTIPLE(USB_MAX_PACKET_IN_SIZE)];
-
 /* RX */
 static I2S_Type *s_i2sRxBase[] = {
     I2S_RX_0,
+#if I2S_INST_NUM > 1
     I2S_RX_1,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_RX_2,
+    I2S_RX_3,
+#endif
 };
 
 static uint32_t s_i2sRxDmaChannel[] = {
     I2S_RX_0_DMA_CH,
+#if I2S_INST_NUM > 1
     I2S_RX_1_DMA_CH,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_RX_2_DMA_CH,
+    I2S_RX_3_DMA_CH,
+#endif
 };
 
 static dma_priority_t s_i2sRxDmaPrio[] = {
     I2S_RX_0_DMA_CH_PRIO,
+#if I2S_INST_NUM > 1
     I2S_RX_1_DMA_CH_PRIO,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_RX_2_DMA_CH_PRIO,
+    I2S_RX_3_DMA_CH_PRIO,
+#endif
 };
 
+#if I2S_RX_DMA_INTERLEAVE
+/**
+ * The ring is directly used as USB transfer buffer so it must live in the USB
+ * RAM.
+ */
+USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE)
+static uint8_t s_i2sRxRing[I2S_RX_RING_SIZE + I2S_RX_RING_TAIL];
+
+SDK_ALIGN(static dma_descriptor_t s_i2sRxDesc[I2S_INST_NUM][I2S_RX_RING_FRAMES], FSL_FEATURE_DMA_LINK_DESCRIPTOR_ALIGN_SIZE);
+#else
+/**
+ * One buffer for each IN transfer that can be queued on the audio class.
+ */
+USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE)
+uint8_t g_usbBuffIn[USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH][USB_DATA_ALIGN_SIZE_MULTIPLE(USB_MAX_PACKET_IN_SIZE)];
+static uint32_t s_usbBuffInIndex;
+
 USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 static uint8_t s_i2sRxBuff[I2S_INST_NUM][I2S_RX_BUFF_SIZE_PER_INST * I2S_RX_BUFF_NUM];
 
 static i2s_transfer_t s_i2sRxTransfer[I2S_INST_NUM][I2S_RX_BUFF_NUM];
 static i2s_dma_handle_t s_i2sDmaRxHandle[I2S_INST_NUM];
+#endif
+
 static dma_handle_t s_dmaRxHandle[I2S_INST_NUM];
-static uint32_t s_rxAudioPos[I2S_INST_NUM];
+
+static i2s_route_t s_rxRoute;
+static i2s_gain_t s_rxGain;
+
+#if I2S_ASRC
+static i2s_asrc_t s_rxAsrc;
+
+/* The I2S frames going into the ASRC, a packet at the I2S rate */
+static uint32_t s_rxAsrcBuff[I2S_ASRC_BATCH_FRAMES * I2S_CH_NUM];
+#endif
+
+static i2s_ring_t s_rxRing = {
+    .dir = kI2S_RingRx,
+    .interleave = I2S_RX_DMA_INTERLEAVE,
+    .geometry = &g_i2sTdmGeometry,
+    .buffNum = I2S_RX_BUFF_NUM,
+    .buffFrames = I2S_RX_BUFF_SIZE / I2S_FRAME_LEN,
+    .base = s_i2sRxBase,
+    .dmaChannel = s_i2sRxDmaChannel,
+    .dmaPrio = s_i2sRxDmaPrio,
+    .dmaHandle = s_dmaRxHandle,
+#if I2S_RX_DMA_INTERLEAVE
+    .tailLen = I2S_RX_RING_TAIL,
+    .data = s_i2sRxRing,
+    .desc = &s_i2sRxDesc[0][0],
+#else
+    .data = &s_i2sRxBuff[0][0],
+    .i2sDmaHandle = s_i2sDmaRxHandle,
+    .transfer = &s_i2sRxTransfer[0][0],
+#endif
+    .bufferDone = I2S_RxBufferDone,
+};
 
 USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 static struct
 {
-    volatile uint8_t vs_rxNextBufIndex;
     volatile uint8_t vs_rxFirstInt;
     volatile uint8_t vs_rxFirstGet;
-    volatile uint64_t vs_rxReadDataCount;
-    volatile uint64_t vs_rxWriteDataCount;
-} usb_ctx;
+    int32_t vs_rxFeedbackInteg;
+    uint32_t vs_rxFeedbackAcc;
+    uint32_t vs_rxFeedbackFrames;
+    int32_t vs_rxFeedbackNormal;
+#if I2S_ASRC
+    int32_t vs_rxAsrcLevel;
+#endif
+    uint32_t vs_rxUframes;
+    uint8_t vs_rxChannels;
+    uint8_t vs_rxSubslotSize;
+    i2s_usb_kernel_t vs_rxPack;
+} usb_ctx = {
+    .vs_rxFeedbackNormal = I2S_RX_FEEDBACK_NORMAL(AUDIO_SAMPLING_RATE_KHZ * 1000U),
+    .vs_rxUframes = 1U,
+    .vs_rxChannels = AUDIO_FORMAT_CHANNELS,
+    .vs_rxSubslotSize = AUDIO_FORMAT_SIZE,
+};
 
 /*******************************************************************************
  * Code
@@ -119,10 +329,30 @@ static struct
  */
 void USB_InPrintInfo(void)
 {
-    uint32_t diff;
+    const i2s_ring_stats_t *stats = &s_rxRing.stats;
+    int32_t diff;
+
+    diff = (I2S_FifoLevel(&s_rxRing.fifo) << 16) / usb_ctx.vs_rxFeedbackNormal;
+    usb_echo("[IN/RX] diff: %" PRId32 ", frames: %" PRIu32 ", integ: %" PRId32 "\n\r", diff,
+             usb_ctx.vs_rxFeedbackFrames, usb_ctx.vs_rxFeedbackInteg);
+    usb_echo("[IN/RX] buffers: %" PRIu32 ", level: %" PRId32 "..%" PRId32 ", underruns: %" PRIu32 ", overruns: %" PRIu32
+             "\n\r",
+             stats->buffers, stats->levelMin, stats->levelMax, stats->underruns, stats->overruns);
+}
+
+/*!
+ * @brief Reset the implicit feedback controller state.
+ */
+static inline void USB_ResetImplicitFeedback(void)
+{
+    usb_ctx.vs_rxFeedbackInteg = 0;
+    usb_ctx.vs_rxFeedbackAcc = 0;
+    usb_ctx.vs_rxFeedbackFrames = ((uint32_t)usb_ctx.vs_rxFeedbackNormal * usb_ctx.vs_rxUframes) >> 16;
 
-    diff = (usb_ctx.vs_rxWriteDataCount - usb_ctx.vs_rxReadDataCount) / HS_ISO_IN_ENDP_PACKET_SIZE;
-    usb_echo("[IN/RX] diff: %ld\n\r", diff);
+#if I2S_ASRC
+    usb_ctx.vs_rxAsrcLevel = 0;
+    I2S_AsrcReset(&s_rxAsrc);
+#endif
 }
 
 /*!
@@ -133,39 +363,210 @@ void USB_InPrintInfo(void)
  */
 static inline uint32_t USB_GetImplicitFeedback(void)
 {
-    uint32_t diff;
+    int32_t err;
+    int32_t out;
+    int32_t dev;
+
+    /**
+     * The error is the distance (in frames) of the current fill level from the
+     * target. A positive error means the I2S side is producing faster than we
+     * are sending so we need to speed up.
+     */
+    err = I2S_FifoLevel(&s_rxRing.fifo) - (int32_t)I2S_RX_FEEDBACK_TARGET;
+
+    usb_ctx.vs_rxFeedbackInteg += err * (int32_t)usb_ctx.vs_rxUframes;
+    if (usb_ctx.vs_rxFeedbackInteg > I2S_RX_FEEDBACK_INTEG_MAX)
+    {
+        usb_ctx.vs_rxFeedbackInteg = I2S_RX_FEEDBACK_INTEG_MAX;
+    }
+    else if (usb_ctx.vs_rxFeedbackInteg < -I2S_RX_FEEDBACK_INTEG_MAX)
+    {
+        usb_ctx.vs_rxFeedbackInteg = -I2S_RX_FEEDBACK_INTEG_MAX;
+    }
+
+    out = (err * I2S_RX_FEEDBACK_KP) + (usb_ctx.vs_rxFeedbackInteg * I2S_RX_FEEDBACK_KI);
+
+    /* One frame of deviation per packet */
+    dev = I2S_RX_FEEDBACK_DEV / (int32_t)usb_ctx.vs_rxUframes;
+    if (out > dev)
+    {
+        out = dev;
+    }
+    else if (out < -dev)
+    {
+        out = -dev;
+    }
+
+    out += usb_ctx.vs_rxFeedbackNormal;
 
     /**
-     * Logic here is based on the size of data present in the DMA buffers. That
-     * value is converted to the number of regular USB packets and decisions are
-     * taken considering and upper and lower threshold.
+     * Fractional-frame accumulator: the integer part is what we send in this
+     * packet, the fractional part is carried over to the next one.
      */
-    diff = (usb_ctx.vs_rxWriteDataCount - usb_ctx.vs_rxReadDataCount) / HS_ISO_IN_ENDP_PACKET_SIZE;
+    usb_ctx.vs_rxFeedbackAcc += (uint32_t)out * usb_ctx.vs_rxUframes;
+    usb_ctx.vs_rxFeedbackFrames = usb_ctx.vs_rxFeedbackAcc >> 16;
+    usb_ctx.vs_rxFeedbackAcc &= 0xFFFFU;
+
+    return usb_ctx.vs_rxFeedbackFrames * I2S_RX_FEEDBACK_FRAME_SIZE;
+}
+
+#if I2S_ASRC
+/*!
+ * @brief Nominal packet size and ASRC ratio (I2S_ASRC)
+ *
+ * The packet carries the nominal frames, the ratio is set from the fill level
+ * so that the ASRC takes from the ring as many frames as the I2S produces.
+ */
+static inline uint32_t USB_GetAsrcFeedback(void)
+{
+    int32_t err;
+    int32_t out;
+
+    /* As for the implicit feedback, positive when the I2S side is faster */
+    err = I2S_FifoLevel(&s_rxRing.fifo) - (int32_t)I2S_RX_FEEDBACK_TARGET;
+
+    usb_ctx.vs_rxAsrcLevel += ((err << 8) - usb_ctx.vs_rxAsrcLevel) >> I2S_RX_ASRC_FILTER_SHIFT;
 
-    /* We need to speed up */
-    if (diff >= I2S_RX_FEEDBACK_TH_UP)
+    usb_ctx.vs_rxFeedbackInteg += usb_ctx.vs_rxAsrcLevel * (int32_t)usb_ctx.vs_rxUframes;
+    if (usb_ctx.vs_rxFeedbackInteg > I2S_RX_ASRC_INTEG_MAX)
     {
-        return (I2S_RX_FEEDBACK_NORMAL + I2S_RX_FEEDBACK_TH_STEP);
+        usb_ctx.vs_rxFeedbackInteg = I2S_RX_ASRC_INTEG_MAX;
     }
+    else if (usb_ctx.vs_rxFeedbackInteg < -I2S_RX_ASRC_INTEG_MAX)
+    {
+        usb_ctx.vs_rxFeedbackInteg = -I2S_RX_ASRC_INTEG_MAX;
+    }
+
+    out = (usb_ctx.vs_rxAsrcLevel >> I2S_RX_ASRC_KP_SHIFT) + (usb_ctx.vs_rxFeedbackInteg >> I2S_RX_ASRC_KI_SHIFT);
+    if (out > I2S_RX_ASRC_MAX_DEV)
+    {
+        out = I2S_RX_ASRC_MAX_DEV;
+    }
+    else if (out < -I2S_RX_ASRC_MAX_DEV)
+    {
+        out = -I2S_RX_ASRC_MAX_DEV;
+    }
+
+    I2S_AsrcSetRatio(&s_rxAsrc, (uint32_t)(usb_ctx.vs_rxFeedbackNormal + out), (uint32_t)usb_ctx.vs_rxFeedbackNormal);
 
-    /* We need to slow down */
-    if (diff <= I2S_RX_FEEDBACK_TH_DOWN)
+    usb_ctx.vs_rxFeedbackAcc += (uint32_t)usb_ctx.vs_rxFeedbackNormal * usb_ctx.vs_rxUframes;
+    usb_ctx.vs_rxFeedbackFrames = usb_ctx.vs_rxFeedbackAcc >> 16;
+    usb_ctx.vs_rxFeedbackAcc &= 0xFFFFU;
+
+    if (usb_ctx.vs_rxAsrcLevel > I2S_RX_ASRC_LEVEL_MAX)
+    {
+        usb_ctx.vs_rxFeedbackFrames++;
+    }
+    else if ((usb_ctx.vs_rxAsrcLevel < -I2S_RX_ASRC_LEVEL_MAX) && (usb_ctx.vs_rxFeedbackFrames > 0U))
     {
-        return (I2S_RX_FEEDBACK_NORMAL - I2S_RX_FEEDBACK_TH_STEP);
+        usb_ctx.vs_rxFeedbackFrames--;
     }
 
-    /* We are just fine */
-    return I2S_RX_FEEDBACK_NORMAL;
+    return usb_ctx.vs_rxFeedbackFrames * I2S_RX_FEEDBACK_FRAME_SIZE;
+}
+#endif
+
+/*!
+ * @brief Set the USB sample format.
+ *
+ * The USB frames carry the first channels TDM slots, subslotSize bytes each
+ * (AUDIO_FORMAT_SIZE as on the I2S side or AUDIO_FORMAT_SIZE_24 for packed
+ * 24-bit samples). The I2S side always runs the full frame, the kernel
+ * converting the frames is selected here. Call it before I2S_RxStart().
+ */
+void USB_AudioI2s2UsbSetFormat(uint8_t channels, uint8_t subslotSize)
+{
+    usb_ctx.vs_rxChannels = channels;
+    usb_ctx.vs_rxSubslotSize = subslotSize;
+    usb_ctx.vs_rxPack = I2S_GetPackKernel(channels, subslotSize);
+}
+
+/*!
+ * @brief Set the sampling rate [Hz].
+ *
+ * The nominal of the implicit feedback depends on it and, when I2S_MASTER is
+ * set, the SCK divider of the master (the TX side is stopped as well then).
+ * Otherwise the I2S side is clocked by the other end of the bus. Call it
+ * before I2S_RxStart().
+ */
+void USB_AudioI2s2UsbSetRate(uint32_t rate)
+{
+    usb_ctx.vs_rxFeedbackNormal = (int32_t)I2S_RX_FEEDBACK_NORMAL(rate);
+
+#if I2S_MASTER
+    I2S_RingSetMasterDiv(&s_rxRing, I2S_MasterDivider(rate));
+#endif
+}
+
+/*!
+ * @brief Set the microframes between two IN packets.
+ *
+ * 2^(bInterval - 1) of the alternate setting, see USB_DeviceGetStreamUframes().
+ * The packets must fit in USB_MAX_PACKET_IN_SIZE at the current rate. Call it
+ * before I2S_RxStart().
+ */
+void USB_AudioI2s2UsbSetInterval(uint32_t uframes)
+{
+    usb_ctx.vs_rxUframes = uframes;
+}
+
+/*!
+ * @brief Set the gain of each TDM slot, Q2.30 (see I2S_GainSetTarget()).
+ *
+ * Ramped to from the next IN packet on, can be called at any time.
+ */
+void USB_AudioI2s2UsbSetGain(const int32_t *gain)
+{
+    I2S_GainSetTarget(&s_rxGain, gain);
+}
+
+/*!
+ * @brief Set the TDM slot of each USB channel (see I2S_RouteSet()).
+ *
+ * Switched to from the next IN packet on, can be called at any time.
+ *
+ * @return false when the map is not valid.
+ */
+bool USB_AudioI2s2UsbSetRoute(const uint8_t *map)
+{
+    return I2S_RouteSet(&s_rxRoute, map);
+}
+
+/*!
+ * @brief Get the TDM slot of each USB channel.
+ */
+void USB_AudioI2s2UsbGetRoute(uint8_t *map)
+{
+    I2S_RouteGet(&s_rxRoute, map);
 }
 
 /*!
  * @brief Audio wav data prepare function.
  *
- * This function prepare audio wav data before send through USB.
+ * This function prepare audio wav data before send through USB. On return
+ * usbBuffer points to the data to send: this is the next g_usbBuffIn slot or,
+ * when I2S_RX_DMA_INTERLEAVE is set, directly the DMA ring. The buffer is not
+ * touched again until USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH more packets have
+ * been prepared, so it can be queued on the audio class. size is the max
+ * packet size of the endpoint, also the length of the silence packets sent
+ * while the streaming is not started yet. The return value is the length of
+ * the packet.
  */
-uint32_t USB_AudioI2s2UsbBuffer(uint8_t *usbBuffer, uint32_t size)
+uint32_t USB_AudioI2s2UsbBuffer(uint8_t **usbBuffer, uint32_t size)
 {
-    assert(size % I2S_FRAME_LEN == 0);
+    uint32_t maxFrames = size / (usb_ctx.vs_rxChannels * usb_ctx.vs_rxSubslotSize);
+    uint32_t frames;
+
+    assert(size % (usb_ctx.vs_rxChannels * usb_ctx.vs_rxSubslotSize) == 0);
+
+    PROF_BEGIN(kPROF_I2s2UsbBuffer);
+
+#if I2S_RX_DMA_INTERLEAVE
+    *usbBuffer = I2S_RingTail(&s_rxRing);
+#else
+    *usbBuffer = g_usbBuffIn[s_usbBuffInIndex];
+    s_usbBuffInIndex = (s_usbBuffInIndex + 1) % USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH;
+#endif
 
     if (usb_ctx.vs_rxFirstGet == 0)
     {
@@ -182,45 +583,81 @@ uint32_t USB_AudioI2s2UsbBuffer(uint8_t *usbBuffer, uint32_t size)
          *    streaming or when the USB is a bit slow to ramp-up and I2S is catching
          *    up too quickly)
          */
-        if ((usb_ctx.vs_rxFirstInt == 0) || (usb_ctx.vs_rxNextBufIndex != (I2S_RX_BUFF_NUM / 2)))
+        if ((usb_ctx.vs_rxFirstInt == 0) || (s_rxRing.nextBuf != (I2S_RX_BUFF_NUM / 2)))
         {
-            bzero(usbBuffer, size);
+            bzero(*usbBuffer, size);
+            PROF_END(kPROF_I2s2UsbBuffer);
             return size;
         }
 
         /**
-         * We reset the recv counter in case we alrady rolled over. This usually
-         * happens if we start the I2S RX before the USB.
+         * The DMA is filling the buffer right after the middle of the DMA
+         * buffers and we start reading from the first one: we move the tail so
+         * that the level is half of the buffers, whatever the DMA produced
+         * before. This usually matters if we start the I2S RX before the USB.
          */
-        usb_ctx.vs_rxWriteDataCount = (I2S_RX_BUFF_NUM / 2) * I2S_RX_BUFF_SIZE;
-        usb_ctx.vs_rxReadDataCount = 0;
+        I2S_FifoSeek(&s_rxRing.fifo, (I2S_RX_BUFF_NUM / 2) * s_rxRing.buffFrames);
+
+        USB_ResetImplicitFeedback();
 
         usb_ctx.vs_rxFirstGet = 1;
     }
 
-    size = USB_GetImplicitFeedback();
+#if I2S_ASRC
+    frames = USB_GetAsrcFeedback() / I2S_FRAME_LEN;
+#else
+    frames = USB_GetImplicitFeedback() / I2S_FRAME_LEN;
+#endif
 
-    for (size_t k = 0; k < size; k += I2S_FRAME_LEN)
+    /* Only when a packet does not fit the endpoint, see USB_DeviceGetStreamPacketSize() */
+    if (frames > maxFrames)
     {
-        for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-        {
-            uint32_t *pos = &s_rxAudioPos[inst];
-#if USE_FILTER_32_DOWN
-            uint32_t *outBuffer = (uint32_t *)(usbBuffer + k);
-            uint32_t *i2sBuffer = (uint32_t *)&s_i2sRxBuff[inst][*pos];
+        frames = maxFrames;
+    }
+
+    size = frames * I2S_FRAME_LEN;
+
+#if I2S_ASRC
+    {
+        /**
+         * The I2S frames are read, routed and scaled in s_rxAsrcBuff, then
+         * converted to the USB rate in the USB buffer.
+         */
+        uint32_t i2sFrames = I2S_AsrcInputFrames(&s_rxAsrc, frames);
+        uint8_t *i2sBuffer = I2S_RingRead(&s_rxRing, (uint8_t *)s_rxAsrcBuff, i2sFrames);
 
-            for (size_t ch = 0; ch < I2S_CH_NUM_PER_INST; ch++)
-            {
-                outBuffer[ch + (inst * I2S_CH_NUM_PER_INST)] = i2sBuffer[ch] & FILTER_32;
-            }
+        I2S_RouteApply(&s_rxRoute, i2sBuffer, i2sFrames, usb_ctx.vs_rxChannels);
+        I2S_GainApply(&s_rxGain, i2sBuffer, i2sFrames, usb_ctx.vs_rxChannels);
+
+        frames = I2S_AsrcProcess(&s_rxAsrc, i2sBuffer, i2sFrames, *usbBuffer, frames, usb_ctx.vs_rxChannels);
+        size = frames * I2S_FRAME_LEN;
+    }
 #else
-            memcpy(usbBuffer + k + (inst * I2S_FRAME_LEN_PER_INST), &s_i2sRxBuff[inst][*pos], I2S_FRAME_LEN_PER_INST);
+    *usbBuffer = I2S_RingRead(&s_rxRing, *usbBuffer, frames);
+
+#if USE_FILTER_32_DOWN
+    for (size_t k = 0; k < (size / I2S_CH_LEN_DATA); k++)
+    {
+        ((uint32_t *)*usbBuffer)[k] &= FILTER_32;
+    }
 #endif
-            *pos = (*pos + I2S_FRAME_LEN_PER_INST) % (I2S_RX_BUFF_SIZE_PER_INST * I2S_RX_BUFF_NUM);
-        }
+
+    /* TDM slots to USB channels, then the gains of the USB channels */
+    I2S_RouteApply(&s_rxRoute, *usbBuffer, frames, usb_ctx.vs_rxChannels);
+    I2S_GainApply(&s_rxGain, *usbBuffer, frames, usb_ctx.vs_rxChannels);
+#endif
+
+    /**
+     * The USB frames are written over the I2S ones, the packet is sent from
+     * the same place.
+     */
+    if (usb_ctx.vs_rxPack != NULL)
+    {
+        usb_ctx.vs_rxPack(*usbBuffer, frames, usb_ctx.vs_rxChannels, usb_ctx.vs_rxSubslotSize);
+        size = frames * usb_ctx.vs_rxChannels * usb_ctx.vs_rxSubslotSize;
     }
 
-    usb_ctx.vs_rxReadDataCount += size;
+    PROF_END(kPROF_I2s2UsbBuffer);
 
     return size;
 }
@@ -236,6 +673,8 @@ static inline bool I2S_RxCheckReset(void)
 
         if (b->STAT & I2S_STAT_SLVFRMERR(1))
         {
+            TRACE(kTRACE_RxReset, inst);
+
             I2S_RxStop();
 
             b->STAT |= I2S_STAT_SLVFRMERR(1);
@@ -250,39 +689,32 @@ static inline bool I2S_RxCheckReset(void)
 }
 
 /*!
- * @brief I2S RX callback.
+ * @brief I2S RX buffer done.
  *
- * This function is called when at least one of the ping-pong buffers is full (I2S_RX_BUFF_SIZE bytes).
+ * Called by the ring every time I2S_RX_BUFF_SIZE bytes have been received.
  */
-static void I2S_RxCallback(I2S_Type *base, i2s_dma_handle_t *handle, status_t completionStatus, void *userData)
+static void I2S_RxBufferDone(i2s_ring_t *ring)
 {
     if (I2S_RxCheckReset())
     {
         return;
     }
 
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
+    I2S_FifoPush(&ring->fifo, ring->buffFrames);
+
+    if (ring->traceSample)
     {
-        I2S_RxTransferReceiveDMA(s_i2sRxBase[inst], &s_i2sDmaRxHandle[inst], s_i2sRxTransfer[inst][usb_ctx.vs_rxNextBufIndex]);
+        TRACE(kTRACE_RxFeedback, usb_ctx.vs_rxFeedbackInteg);
     }
 
-    usb_ctx.vs_rxNextBufIndex = ((usb_ctx.vs_rxNextBufIndex + 1) % I2S_RX_BUFF_NUM);
-
     /**
      * We start the USB data sending only when at least half of the DMA buffers
-     * are full. We also reset the recv counter in case we already rolled over.
+     * are full (the USB side then aligns its tail, see USB_AudioI2s2UsbBuffer()).
      */
-    if ((usb_ctx.vs_rxFirstInt == 0) && (usb_ctx.vs_rxNextBufIndex == (I2S_RX_BUFF_NUM / 2)))
+    if ((usb_ctx.vs_rxFirstInt == 0) && (ring->nextBuf == (I2S_RX_BUFF_NUM / 2)))
     {
-        usb_ctx.vs_rxWriteDataCount = (I2S_RX_BUFF_NUM / 2) * I2S_RX_BUFF_SIZE;
-        usb_ctx.vs_rxReadDataCount = 0;
-
         usb_ctx.vs_rxFirstInt = 1;
-
-        return;
     }
-
-    usb_ctx.vs_rxWriteDataCount += I2S_RX_BUFF_SIZE;
 }
 
 /*!
@@ -293,17 +725,10 @@ static void I2S_RxCallback(I2S_Type *base, i2s_dma_handle_t *handle, status_t co
  */
 static inline void I2S_RxCleanup(void)
 {
-    usb_ctx.vs_rxNextBufIndex = 0;
     usb_ctx.vs_rxFirstInt = 0;
     usb_ctx.vs_rxFirstGet = 0;
-    usb_ctx.vs_rxWriteDataCount = 0;
-    usb_ctx.vs_rxReadDataCount = 0;
 
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        s_rxAudioPos[inst] = 0;
-        bzero(s_i2sRxBuff[inst], I2S_RX_BUFF_NUM * I2S_RX_BUFF_SIZE_PER_INST);
-    }
+    USB_ResetImplicitFeedback();
 }
 
 /*!
@@ -311,11 +736,7 @@ static inline void I2S_RxCleanup(void)
  */
 void I2S_RxStop(void)
 {
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        I2S_TransferAbortDMA(s_i2sRxBase[inst], &s_i2sDmaRxHandle[inst]);
-    }
-
+    I2S_RingStop(&s_rxRing);
     I2S_RxCleanup();
 }
 
@@ -325,104 +746,7 @@ void I2S_RxStop(void)
 void I2S_RxStart(void)
 {
     I2S_RxCleanup();
-
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        for (size_t buf = 0; buf < I2S_RX_BUFF_NUM; buf++)
-        {
-            I2S_RxTransferReceiveDMA(s_i2sRxBase[inst], &s_i2sDmaRxHandle[inst], s_i2sRxTransfer[inst][buf]);
-        }
-    }
-}
-
-/*!
- * @brief I2S parameters setup.
- *
- * Function to setup the I2S parameters.
- */
-static void I2S_RxSetupParams(i2s_config_t *rxConfig)
-{
-    /**
-     * Default values:
-     *   config->masterSlave = kI2S_MasterSlaveNormalSlave;
-     *   config->mode = kI2S_ModeI2sClassic;
-     *   config->rightLow = false;
-     *   config->leftJust = false;
-     *   config->pdmData = false;
-     *   config->sckPol = false;
-     *   config->wsPol = false;
-     *   config->divider = 1;
-     *   config->oneChannel = false;
-     *   config->dataLength = 16;
-     *   config->frameLength = 32;
-     *   config->position = 0;
-     *   config->watermark = 4;
-     *   config->txEmptyZero = false;
-     *   config->pack48 = false;
-     */
-    I2S_RxGetDefaultConfig(rxConfig);
-
-    rxConfig->masterSlave = kI2S_MasterSlaveNormalSlave; /** Normal Slave */
-    rxConfig->mode = kI2S_ModeDspWsShort;                /** DSP mode, WS having one clock long pulse */
-    rxConfig->dataLength = TO_BITS(I2S_CH_LEN_DATA);
-    rxConfig->frameLength = TO_BITS(I2S_FRAME_LEN);
-}
-
-/*!
- * @brief DMA channels setup.
- *
- * Function to setup the DMA channel.
- */
-static void DMA_RxSetupChannels(void)
-{
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        DMA_EnableChannel(DMA, s_i2sRxDmaChannel[inst]);
-        DMA_SetChannelPriority(DMA, s_i2sRxDmaChannel[inst], s_i2sRxDmaPrio[inst]);
-        DMA_CreateHandle(&s_dmaRxHandle[inst], DMA, s_i2sRxDmaChannel[inst]);
-    }
-}
-
-/*!
- * @brief I2S DMA setup.
- *
- * Function to setup I2S (with secondary channels) and DMA.
- */
-static void I2S_DMA_RxSetup(i2s_config_t *rxConfig)
-{
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        for (size_t buf = 0; buf < I2S_RX_BUFF_NUM; buf++)
-        {
-            s_i2sRxTransfer[inst][buf].data = &s_i2sRxBuff[inst][buf * I2S_RX_BUFF_SIZE_PER_INST];
-            s_i2sRxTransfer[inst][buf].dataSize = I2S_RX_BUFF_SIZE_PER_INST;
-        }
-
-        rxConfig->position = (inst * TO_BITS(I2S_FRAME_LEN_PER_INST));
-
-        I2S_RxInit(s_i2sRxBase[inst], rxConfig);
-
-        I2S_EnableSecondaryChannel(s_i2sRxBase[inst], kI2S_SecondaryChannel1, false, CH_OFF((inst * I2S_FRAME_LEN_PER_INST), 1));
-        I2S_EnableSecondaryChannel(s_i2sRxBase[inst], kI2S_SecondaryChannel2, false, CH_OFF((inst * I2S_FRAME_LEN_PER_INST), 2));
-        I2S_EnableSecondaryChannel(s_i2sRxBase[inst], kI2S_SecondaryChannel3, false, CH_OFF((inst * I2S_FRAME_LEN_PER_INST), 3));
-
-        /**
-         * Install the callback only on the latest instance so every time the
-         * callback is called we are sure to have gathered the whole final frame
-         * and not just half of it.
-         *
-         * When the callback is called we have received I2S_RX_BUFF_SIZE bytes from
-         * the two instances.
-         */
-        if (inst == (I2S_INST_NUM - 1))
-        {
-            I2S_RxTransferCreateHandleDMA(s_i2sRxBase[inst], &s_i2sDmaRxHandle[inst], &s_dmaRxHandle[inst], I2S_RxCallback, (void *)inst);
-        }
-        else
-        {
-            I2S_RxTransferCreateHandleDMA(s_i2sRxBase[inst], &s_i2sDmaRxHandle[inst], &s_dmaRxHandle[inst], NULL, NULL);
-        }
-    }
+    I2S_RingStart(&s_rxRing);
 }
 
 /*!
@@ -432,9 +756,16 @@ static void I2S_DMA_RxSetup(i2s_config_t *rxConfig)
  */
 void BOARD_I2S_RxInit(void)
 {
-    i2s_config_t rxConfig = {0};
+    I2S_RouteInit(&s_rxRoute);
+    I2S_GainInit(&s_rxGain);
+#if I2S_ASRC
+    I2S_AsrcInit(&s_rxAsrc);
+#endif
+
+#if I2S_MASTER
+    s_rxRing.masterDiv = I2S_MasterDivider(AUDIO_SAMPLING_RATE_KHZ * 1000U);
+    assert(s_rxRing.masterDiv != 0U);
+#endif
 
-    I2S_RxSetupParams(&rxConfig);
-    DMA_RxSetupChannels();
-    I2S_DMA_RxSetup(&rxConfig);
+    I2S_RingInit(&s_rxRing);
 }
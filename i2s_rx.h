@@ -33,7 +33,13 @@
 
 #include "fsl_dma.h"
 
-uint32_t USB_AudioI2s2UsbBuffer(uint8_t *buffer, uint32_t size);
+uint32_t USB_AudioI2s2UsbBuffer(uint8_t **buffer, uint32_t size);
+void USB_AudioI2s2UsbSetFormat(uint8_t channels, uint8_t subslotSize);
+void USB_AudioI2s2UsbSetRate(uint32_t rate);
+void USB_AudioI2s2UsbSetInterval(uint32_t uframes);
+void USB_AudioI2s2UsbSetGain(const int32_t *gain);
+bool USB_AudioI2s2UsbSetRoute(const uint8_t *map);
+void USB_AudioI2s2UsbGetRoute(uint8_t *map);
 void BOARD_I2S_RxInit(void);
 
 void I2S_RxStart(void);
@@ -41,30 +47,50 @@ void I2S_RxStop(void);
 
 void USB_InPrintInfo(void);
 
-extern uint8_t g_usbBuffIn[];
-
 /**
  * I2S HW controllers.
  */
 #define I2S_RX_0 (I2S5) /* FLEXCOMM5 */
 #define I2S_RX_1 (I2S7) /* FLEXCOMM7 */
+#define I2S_RX_2 (I2S1) /* FLEXCOMM1, 4 instances only */
+#define I2S_RX_3 (I2S3) /* FLEXCOMM3, 4 instances only */
+
+/**
+ * I2S bridge index of the controllers, to share the signals.
+ */
+#define I2S_RX_0_FLEXCOMM (kI2S_BRIDGE_Flexcomm5)
+#define I2S_RX_1_FLEXCOMM (kI2S_BRIDGE_Flexcomm7)
+#define I2S_RX_2_FLEXCOMM (kI2S_BRIDGE_Flexcomm1)
+#define I2S_RX_3_FLEXCOMM (kI2S_BRIDGE_Flexcomm3)
+
+/**
+ * Clock of the first controller, the SCK / WS master when I2S_MASTER is set.
+ */
+#define I2S_RX_0_CLK_ATTACH (kAUDIO_PLL_to_FLEXCOMM5)
 
 /**
  * I2S DMA channels.
  */
 #define I2S_RX_0_DMA_CH (10) /* Flexcomm Interface 5 RX */
 #define I2S_RX_1_DMA_CH (14) /* Flexcomm Interface 7 RX */
+#define I2S_RX_2_DMA_CH (2)  /* Flexcomm Interface 1 RX */
+#define I2S_RX_3_DMA_CH (6)  /* Flexcomm Interface 3 RX */
 
 /**
  * I2S DMA chennels priority.
  */
 #define I2S_RX_0_DMA_CH_PRIO (kDMA_ChannelPriority7)
 #define I2S_RX_1_DMA_CH_PRIO (kDMA_ChannelPriority7)
+#define I2S_RX_2_DMA_CH_PRIO (kDMA_ChannelPriority7)
+#define I2S_RX_3_DMA_CH_PRIO (kDMA_ChannelPriority7)
 
 /**
- * USB max packet size. We default to High-Speed [448 bytes]
+ * USB max packet size, at the max sampling rate, counted in full I2S frames:
+ * the packets are built (or received) in place as I2S frames. We default to
+ * High-Speed [832 bytes]
  */
-#define USB_MAX_PACKET_IN_SIZE (HS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE))
+#define USB_MAX_PACKET_IN_SIZE \
+    (((HS_ISO_IN_ENDP_PACKET_SIZE_MAX / (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)) + 1U) * I2S_FRAME_LEN)
 
 /**
  * Number of buffers for I2S DMA ping-pong [4]
@@ -72,14 +98,16 @@ extern uint8_t g_usbBuffIn[];
 #define I2S_RX_BUFF_NUM (4U)
 
 /**
- * Size of each I2S DMA instance buffer. We use 4 times the size of the USB
- * packet divided by the number of I2S instances [896 bytes]
+ * Size of the I2S DMA buffer considering all the instances. The I2S_RX_BUFF_NUM
+ * buffers and a max packet of tail share I2S_RING_RAM_SIZE, in whole frames
+ * [1664 bytes, 26 frames]
  */
-#define I2S_RX_BUFF_SIZE_PER_INST ((USB_MAX_PACKET_IN_SIZE * 4U) / I2S_INST_NUM)
+#define I2S_RX_BUFF_SIZE \
+    ((((I2S_RING_RAM_SIZE - USB_MAX_PACKET_IN_SIZE) / I2S_RX_BUFF_NUM) / I2S_FRAME_LEN) * I2S_FRAME_LEN)
 
 /**
- * Size of the I2S DMA buffer considering all the instances [1792 bytes]
+ * Size of each I2S DMA instance buffer [832 bytes]
  */
-#define I2S_RX_BUFF_SIZE (I2S_INST_NUM * I2S_RX_BUFF_SIZE_PER_INST)
+#define I2S_RX_BUFF_SIZE_PER_INST (I2S_RX_BUFF_SIZE / I2S_INST_NUM)
 
 #endif /* __I2S_RX_H__ */
\ No newline at end of file
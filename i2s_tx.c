@@ -5,11 +5,14 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <inttypes.h>
+
 #include "usb_device_config.h"
 #include "usb.h"
 #include "usb_device.h"
 #include "usb_device_class.h"
 #include "usb_audio_config.h"
+#include "usb_device_audio.h"
 #include "usb_device_descriptor.h"
 #include "fsl_device_registers.h"
 
@@ -18,73 +21,299 @@
 #include "fsl_i2s_bridge.h"
 #include "fsl_dma.h"
 
+#include "tdm2usb.h"
 #include "i2s.h"
+#include "i2s_asrc.h"
+#include "i2s_ring.h"
 #include "i2s_tx.h"
+#include "prof.h"
+#include "trace.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-#define AUDIO_UPDATE_FEEDBACK_DATA(s, m, n)               \
-    if (USB_SPEED_HIGH == (s))                            \
-    {                                                     \
-        m[0] = (((n & 0x00001FFFu) << 3) & 0xFFu);        \
-        m[1] = ((((n & 0x00001FFFu) << 3) >> 8) & 0xFFu); \
-        m[2] = (((n & 0x01FFE000u) >> 13) & 0xFFu);       \
-        m[3] = (((n & 0x01FFE000u) >> 21) & 0xFFu);       \
-    }                                                     \
-    else                                                  \
-    {                                                     \
-        m[0] = ((n << 4) & 0xFFU);                        \
-        m[1] = (((n << 4) >> 8U) & 0xFFU);                \
-        m[2] = (((n << 4) >> 16U) & 0xFFU);               \
+/**
+ * The feedback value is always computed as frames per microframe in 16.16
+ * format. For High-Speed this is exactly what is sent on the wire, for
+ * Full-Speed we need frames per frame (x8) in 10.14 format (>>2).
+ */
+#define AUDIO_UPDATE_FEEDBACK_DATA(s, m, n)     \
+    if (USB_SPEED_HIGH == (s))                  \
+    {                                           \
+        m[0] = ((n) & 0xFFU);                   \
+        m[1] = (((n) >> 8U) & 0xFFU);           \
+        m[2] = (((n) >> 16U) & 0xFFU);          \
+        m[3] = (((n) >> 24U) & 0xFFU);          \
+    }                                           \
+    else                                        \
+    {                                           \
+        m[0] = (((n) << 1U) & 0xFFU);           \
+        m[1] = ((((n) << 1U) >> 8U) & 0xFFU);   \
+        m[2] = ((((n) << 1U) >> 16U) & 0xFFU);  \
+        m[3] = 0U;                              \
     }
 
-#define I2S_TX_FEEDBACK_TH_UP (9U)
-#define I2S_TX_FEEDBACK_TH_DOWN (4U)
+/**
+ * Set I2S_TX_DMA_INTERLEAVE to (1) to have the USB controller receiving the OUT
+ * packets directly into a single interleaved ring and the DMA reading from
+ * there the frames for all the I2S instances (one linked descriptor per
+ * instance per frame). No CPU copy and no bounce buffer.
+ *
+ * Set it to (0) to receive in g_usbBuffOut and copy (and de-interleave) each
+ * frame into the per-instance ping-pong buffers.
+ */
+#ifndef I2S_TX_DMA_INTERLEAVE
+#define I2S_TX_DMA_INTERLEAVE (1)
+#endif
+
+#if I2S_TX_DMA_INTERLEAVE && I2S_ASRC
+#error "I2S_ASRC requires the copy mode (I2S_TX_DMA_INTERLEAVE = 0)"
+#endif
+
+#if I2S_TX_DMA_INTERLEAVE && ((AUDIO_SAMPLING_RATE_MAX_KHZ * HS_ISO_ENDP_INTERVAL_MAX_UFRAMES) > 96U)
+#error "AUDIO_SAMPLING_RATE_MAX_KHZ above 96 (or 96 / microframes per packet) requires the copy mode (I2S_TX_DMA_INTERLEAVE = 0)"
+#endif
+
+#if I2S_TX_DMA_INTERLEAVE
+/**
+ * Size of the interleaved ring [6656 bytes]
+ */
+#define I2S_TX_RING_SIZE (I2S_TX_BUFF_NUM * I2S_TX_BUFF_SIZE)
+
+/**
+ * Number of frames in the interleaved ring [104 frames]
+ */
+#define I2S_TX_RING_FRAMES (I2S_TX_RING_SIZE / I2S_FRAME_LEN)
+
+/**
+ * The OUT packets are received in the ring and we do not know in advance how
+ * long they are going to be, so the ring is followed by a tail large enough for
+ * a full packet. Whatever lands in the tail is moved back at the beginning of
+ * the ring. Before the streaming is started the packets are received (and
+ * dropped) in the tail [832 bytes]
+ */
+#define I2S_TX_RING_TAIL (USB_MAX_PACKET_OUT_SIZE)
+#endif
+
+/**
+ * Receives queued on the audio class. With I2S_TX_DMA_INTERLEAVE each one is
+ * queued in the ring a max packet further, one g_usbBuffOut slot each
+ * otherwise.
+ */
+#define I2S_TX_USB_QUEUE_DEPTH (USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH)
+
+#define I2S_TX_FEEDBACK_FRAME_SIZE (I2S_FRAME_LEN)
+
+/**
+ * Nominal feedback for a sampling rate [Hz], frames per microframe in 16.16:
+ * rate / 8000 with 65536 / 8000 = 1024 / 125 [6.0 at 48 kHz]
+ */
+#define I2S_TX_FEEDBACK_NORMAL(rate) (((rate) * 1024U) / 125U)
+
+/**
+ * Rate measurement.
+ *
+ * Every I2S TX callback means that I2S_TX_BUFF_SIZE bytes were consumed by the
+ * DMA. The callbacks are timestamped with the USB SOF counter and every window
+ * of callbacks we compute the number of frames consumed per microframe. The
+ * timestamps are absolute so the quantization error of one window is
+ * compensated by the next one.
+ *
+ * The quantization error of a window is one microframe over its length, so
+ * to keep the same error in frames per microframe the window grows with the
+ * square of the sampling rate: I2S_TX_FEEDBACK_WINDOW callbacks at 48 kHz
+ * [about 1100 microframes with 26 frames buffers], 1024 callbacks at 96 kHz
+ * [about 2200 microframes].
+ *
+ * Until the first window is done the fill level correction alone steers the
+ * feedback, so the window is capped to I2S_TX_FEEDBACK_WINDOW_MAX callbacks
+ * [about 2200 microframes at 96 kHz]: the level must not drift by more than
+ * the margin of the target meanwhile. The larger quantization error is
+ * compensated by the following windows, as the timestamps are absolute.
+ *
+ * Keep the window shorter than the SOF counter wrap (2048 frames) at the
+ * maximum rate.
+ */
+#define I2S_TX_FEEDBACK_WINDOW (256U)
+#define I2S_TX_FEEDBACK_WINDOW_MAX (1024U)
+#define I2S_TX_FEEDBACK_WINDOW_RATE(rate)                                                         \
+    MIN((I2S_TX_FEEDBACK_WINDOW * ((rate) / 100U) * ((rate) / 100U)) / (480U * 480U), \
+        I2S_TX_FEEDBACK_WINDOW_MAX)
+#define I2S_TX_BUFF_FRAMES (I2S_TX_BUFF_SIZE / I2S_TX_FEEDBACK_FRAME_SIZE)
+
+/**
+ * Each new measurement is low-pass filtered: rate += (new - rate) >> SHIFT
+ */
+#define I2S_TX_FEEDBACK_FILTER_SHIFT (2U)
+
+/**
+ * SOF counter masks: 11-bit frame number, plus 3 bits of microframe in HS.
+ */
+#define I2S_TX_SOF_MASK_HS (0x3FFFU)
+#define I2S_TX_SOF_MASK_FS (0x07FFU)
+
+/**
+ * Fill level correction.
+ *
+ * A small proportional term (in 16.16 LSB per frame of error) on top of the
+ * measured rate so that the fill level is slowly pulled back to the target
+ * [39 frames at 48 kHz, mean of the sawtooth when half of the DMA buffers are
+ * full]. The frames arrive one packet at a time, so the target grows with two
+ * nominal packets (the one being received and the one the DMA is moving) to
+ * keep the same margin with the larger packets of the higher rates or of the
+ * longer intervals [51 frames at 96 kHz, or at 48 kHz every two microframes].
+ */
+#define I2S_TX_FEEDBACK_TARGET \
+    ((((I2S_TX_BUFF_NUM / 2) * I2S_TX_BUFF_SIZE) - (I2S_TX_BUFF_SIZE / 2)) / I2S_TX_FEEDBACK_FRAME_SIZE)
+#define I2S_TX_FEEDBACK_TARGET_PACKET(frames) (I2S_TX_FEEDBACK_TARGET + (2U * ((frames) - (48000U / 8000U))))
+#define I2S_TX_FEEDBACK_KP (8)
+
+/**
+ * Never report anything further than 1/16 of a frame from the nominal value.
+ */
+#define I2S_TX_FEEDBACK_MAX_DEV ((1 << 16) / 16)
 
-#define I2S_TX_FEEDBACK_TH_STEP (1U)
-#define I2S_TX_FEEDBACK_NORMAL \
-    ((HS_ISO_OUT_ENDP_PACKET_SIZE / (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)) << 13)
+/**
+ * With I2S_ASRC the same correction sets the ratio of the ASRC instead of the
+ * feedback. The fill level is a sawtooth of one DMA buffer that the ratio must
+ * not follow, so it is first low-pass filtered over about
+ * 2^I2S_TX_ASRC_FILTER_SHIFT packets (in 1/256 frames).
+ */
+#define I2S_TX_ASRC_FILTER_SHIFT (4U)
 
 /*******************************************************************************
- * Variables
+ * Prototypes
  ******************************************************************************/
-USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE)
-uint8_t g_usbBuffOut[USB_DATA_ALIGN_SIZE_MULTIPLE(USB_MAX_PACKET_OUT_SIZE)];
+static void I2S_TxBufferDone(i2s_ring_t *ring);
 
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
 static I2S_Type *s_i2sTxBase[] = {
     I2S_TX_0,
+#if I2S_INST_NUM > 1
     I2S_TX_1,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_TX_2,
+    I2S_TX_3,
+#endif
 };
 
 static uint32_t s_i2sTxDmaChannel[] = {
     I2S_TX_0_DMA_CH,
+#if I2S_INST_NUM > 1
     I2S_TX_1_DMA_CH,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_TX_2_DMA_CH,
+    I2S_TX_3_DMA_CH,
+#endif
 };
 
 static dma_priority_t s_i2sTxDmaPrio[] = {
     I2S_TX_0_DMA_CH_PRIO,
+#if I2S_INST_NUM > 1
     I2S_TX_1_DMA_CH_PRIO,
+#endif
+#if I2S_INST_NUM > 2
+    I2S_TX_2_DMA_CH_PRIO,
+    I2S_TX_3_DMA_CH_PRIO,
+#endif
 };
 
+#if I2S_TX_DMA_INTERLEAVE
+/**
+ * The ring is directly used as USB transfer buffer so it must live in the USB
+ * RAM.
+ */
+USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE)
+static uint8_t s_i2sTxRing[I2S_TX_RING_SIZE + I2S_TX_RING_TAIL];
+
+/* Where the queued OUT packets are received in the ring, oldest first */
+static uint32_t s_txRecvPos[I2S_TX_USB_QUEUE_DEPTH];
+static uint32_t s_txRecvFirst;
+
+SDK_ALIGN(static dma_descriptor_t s_i2sTxDesc[I2S_INST_NUM][I2S_TX_RING_FRAMES], FSL_FEATURE_DMA_LINK_DESCRIPTOR_ALIGN_SIZE);
+#else
+USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE)
+uint8_t g_usbBuffOut[I2S_TX_USB_QUEUE_DEPTH][USB_DATA_ALIGN_SIZE_MULTIPLE(USB_MAX_PACKET_OUT_SIZE)];
+static uint32_t s_usbBuffOutIndex;
+
 USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 static uint8_t s_i2sTxBuff[I2S_INST_NUM][I2S_TX_BUFF_SIZE_PER_INST * I2S_TX_BUFF_NUM];
 
 static i2s_transfer_t s_i2sTxTransfer[I2S_INST_NUM][I2S_TX_BUFF_NUM];
 static i2s_dma_handle_t s_i2sDmaTxHandle[I2S_INST_NUM];
+#endif
+
 static dma_handle_t s_dmaTxHandle[I2S_INST_NUM];
-static uint32_t s_txAudioPos[I2S_INST_NUM];
+
+static i2s_route_t s_txRoute;
+static i2s_gain_t s_txGain;
+
+#if I2S_ASRC
+static i2s_asrc_t s_txAsrc;
+
+/* The I2S frames coming out of the ASRC, a packet at the I2S rate */
+static uint32_t s_txAsrcBuff[I2S_ASRC_BATCH_FRAMES * I2S_CH_NUM];
+#endif
+
+static i2s_ring_t s_txRing = {
+    .dir = kI2S_RingTx,
+    .interleave = I2S_TX_DMA_INTERLEAVE,
+    .geometry = &g_i2sTdmGeometry,
+    .buffNum = I2S_TX_BUFF_NUM,
+    .buffFrames = I2S_TX_BUFF_SIZE / I2S_FRAME_LEN,
+    .base = s_i2sTxBase,
+    .dmaChannel = s_i2sTxDmaChannel,
+    .dmaPrio = s_i2sTxDmaPrio,
+    .dmaHandle = s_dmaTxHandle,
+#if I2S_TX_DMA_INTERLEAVE
+    .tailLen = I2S_TX_RING_TAIL,
+    .data = s_i2sTxRing,
+    .desc = &s_i2sTxDesc[0][0],
+#else
+    .data = &s_i2sTxBuff[0][0],
+    .i2sDmaHandle = s_i2sDmaTxHandle,
+    .transfer = &s_i2sTxTransfer[0][0],
+#endif
+    .bufferDone = I2S_TxBufferDone,
+};
 
 USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 static struct
 {
-    volatile uint8_t vs_txNextBufIndex;
     volatile uint8_t vs_txUsbStarted;
+    volatile uint8_t vs_txUsbQueued;
     volatile uint8_t vs_txDataIsValid;
-    volatile uint64_t vs_txReadDataCount;
-    volatile uint64_t vs_txWriteDataCount;
     volatile uint32_t vs_txFeedback;
-} usb_ctx;
+    volatile uint32_t vs_txRate;
+    uint32_t vs_txNormal;
+    uint32_t vs_txRateSofStart;
+    uint32_t vs_txRateCount;
+    uint32_t vs_txRateWindow;
+    uint32_t vs_txTarget;
+    uint32_t vs_txStartBufs;
+#if I2S_ASRC
+    int32_t vs_txAsrcLevel;
+#endif
+    uint32_t vs_txUframes;
+    uint8_t vs_txRateStarted;
+    uint8_t vs_txRateValid;
+    uint8_t vs_txSpeed;
+    uint8_t vs_txChannels;
+    uint8_t vs_txSubslotSize;
+    i2s_usb_kernel_t vs_txUnpack;
+} usb_ctx = {
+    .vs_txNormal = I2S_TX_FEEDBACK_NORMAL(AUDIO_SAMPLING_RATE_KHZ * 1000U),
+    .vs_txRateWindow = I2S_TX_FEEDBACK_WINDOW_RATE(AUDIO_SAMPLING_RATE_KHZ * 1000U),
+    .vs_txTarget = I2S_TX_FEEDBACK_TARGET_PACKET(AUDIO_SAMPLING_RATE_KHZ / 8U),
+    .vs_txStartBufs = 1U,
+    .vs_txUframes = 1U,
+    .vs_txChannels = AUDIO_FORMAT_CHANNELS,
+    .vs_txSubslotSize = AUDIO_FORMAT_SIZE,
+};
 
 USB_RAM_ADDRESS_ALIGNMENT(4)
 uint8_t audioFeedBackBuffer[4];
@@ -97,10 +326,15 @@ uint8_t audioFeedBackBuffer[4];
  */
 void USB_OutPrintInfo(void)
 {
-    uint32_t diff;
-
-    diff = (usb_ctx.vs_txWriteDataCount - usb_ctx.vs_txReadDataCount) / HS_ISO_OUT_ENDP_PACKET_SIZE;
-    usb_echo("[OUT/TX] diff: %ld, feedback: 0x%x\n\r", diff, usb_ctx.vs_txFeedback);
+    const i2s_ring_stats_t *stats = &s_txRing.stats;
+    int32_t diff;
+
+    diff = (I2S_FifoLevel(&s_txRing.fifo) << 16) / (int32_t)usb_ctx.vs_txNormal;
+    usb_echo("[OUT/TX] diff: %" PRId32 ", rate: 0x%" PRIx32 ", feedback: 0x%" PRIx32 "\n\r", diff, usb_ctx.vs_txRate,
+             usb_ctx.vs_txFeedback);
+    usb_echo("[OUT/TX] buffers: %" PRIu32 ", level: %" PRId32 "..%" PRId32 ", underruns: %" PRIu32 ", overruns: %" PRIu32
+             "\n\r",
+             stats->buffers, stats->levelMin, stats->levelMax, stats->underruns, stats->overruns);
 }
 
 /*!
@@ -111,49 +345,331 @@ void USB_OutPrintInfo(void)
  */
 uint32_t USB_GetFeedback(uint8_t speed)
 {
+    usb_ctx.vs_txSpeed = speed;
+
+#if I2S_ASRC
+    /* The ASRC follows the I2S rate, the host keeps sending the nominal one */
+    AUDIO_UPDATE_FEEDBACK_DATA(speed, audioFeedBackBuffer, usb_ctx.vs_txNormal);
+#else
     AUDIO_UPDATE_FEEDBACK_DATA(speed, audioFeedBackBuffer, usb_ctx.vs_txFeedback);
+#endif
 
     return *((uint32_t *)&audioFeedBackBuffer[0]);
 }
 
+/*!
+ * @brief Measure the I2S TX rate against the USB SOF
+ *
+ * Called from the I2S TX callback, every time I2S_TX_BUFF_SIZE bytes have been
+ * consumed by the DMA.
+ */
+static inline void I2S_TxMeasureRate(void)
+{
+    uint32_t sof;
+    uint32_t elapsed;
+    uint32_t rate;
+
+    if (kStatus_USB_Success != USB_DeviceClassGetCurrentFrameCount(CONTROLLER_ID, &sof))
+    {
+        return;
+    }
+
+    if (usb_ctx.vs_txRateStarted == 0)
+    {
+        usb_ctx.vs_txRateSofStart = sof;
+        usb_ctx.vs_txRateCount = 0;
+        usb_ctx.vs_txRateStarted = 1;
+        return;
+    }
+
+    if (++usb_ctx.vs_txRateCount < usb_ctx.vs_txRateWindow)
+    {
+        return;
+    }
+
+    /* Elapsed time in microframes */
+    if (USB_SPEED_HIGH == usb_ctx.vs_txSpeed)
+    {
+        elapsed = (sof - usb_ctx.vs_txRateSofStart) & I2S_TX_SOF_MASK_HS;
+    }
+    else
+    {
+        elapsed = ((sof - usb_ctx.vs_txRateSofStart) & I2S_TX_SOF_MASK_FS) << 3U;
+    }
+
+    usb_ctx.vs_txRateSofStart = sof;
+    usb_ctx.vs_txRateCount = 0;
+
+    if (elapsed == 0)
+    {
+        return;
+    }
+
+    rate = (uint32_t)(((uint64_t)(usb_ctx.vs_txRateWindow * I2S_TX_BUFF_FRAMES) << 16) / elapsed);
+
+    if (usb_ctx.vs_txRateValid == 0)
+    {
+        usb_ctx.vs_txRate = rate;
+        usb_ctx.vs_txRateValid = 1;
+    }
+    else
+    {
+        usb_ctx.vs_txRate = (uint32_t)((int32_t)usb_ctx.vs_txRate +
+                                       (((int32_t)rate - (int32_t)usb_ctx.vs_txRate) >> I2S_TX_FEEDBACK_FILTER_SHIFT));
+    }
+}
+
 /*!
  * @brief Logic to set the feedback data endpoint
+ *
+ * The feedback is the I2S rate measured against the SOF plus a small correction
+ * depending on the fill level of the DMA buffers.
  */
 static inline uint32_t USB_GetExplicitFeedback(void)
 {
-    uint32_t diff;
+    int32_t err;
+    int32_t dev;
 
     /**
-     * Logic here is based on the size of data present in the DMA buffers. That
-     * value is converted to the number of regular USB packets and decisions are
-     * taken considering and upper and lower threshold.
+     * Until the first measurement vs_txRate is the nominal rate, the fill
+     * level correction is applied from the start anyway.
+     *
+     * A positive error means the host is sending faster than the I2S is
+     * consuming so we need to slow down.
      */
-    diff = (usb_ctx.vs_txWriteDataCount - usb_ctx.vs_txReadDataCount) / HS_ISO_OUT_ENDP_PACKET_SIZE;
+    err = I2S_FifoLevel(&s_txRing.fifo) - (int32_t)usb_ctx.vs_txTarget;
+
+    dev = ((int32_t)usb_ctx.vs_txRate - (int32_t)usb_ctx.vs_txNormal) - (err * I2S_TX_FEEDBACK_KP);
+
+    if (dev > I2S_TX_FEEDBACK_MAX_DEV)
+    {
+        dev = I2S_TX_FEEDBACK_MAX_DEV;
+    }
+    else if (dev < -I2S_TX_FEEDBACK_MAX_DEV)
+    {
+        dev = -I2S_TX_FEEDBACK_MAX_DEV;
+    }
+
+    return (uint32_t)((int32_t)usb_ctx.vs_txNormal + dev);
+}
+
+#if I2S_ASRC
+/*!
+ * @brief Frames per microframe the ASRC has to produce (I2S_ASRC)
+ *
+ * As the explicit feedback, with the fill level low-pass filtered.
+ */
+static inline uint32_t USB_GetAsrcFeedback(void)
+{
+    int32_t err;
+    int32_t dev;
+
+    err = I2S_FifoLevel(&s_txRing.fifo) - (int32_t)usb_ctx.vs_txTarget;
+
+    usb_ctx.vs_txAsrcLevel += ((err << 8) - usb_ctx.vs_txAsrcLevel) >> I2S_TX_ASRC_FILTER_SHIFT;
+
+    dev = ((int32_t)usb_ctx.vs_txRate - (int32_t)usb_ctx.vs_txNormal) -
+          ((usb_ctx.vs_txAsrcLevel * I2S_TX_FEEDBACK_KP) >> 8);
+
+    if (dev > I2S_TX_FEEDBACK_MAX_DEV)
+    {
+        dev = I2S_TX_FEEDBACK_MAX_DEV;
+    }
+    else if (dev < -I2S_TX_FEEDBACK_MAX_DEV)
+    {
+        dev = -I2S_TX_FEEDBACK_MAX_DEV;
+    }
+
+    return (uint32_t)((int32_t)usb_ctx.vs_txNormal + dev);
+}
+#endif
+
+/*!
+ * @brief Set the USB sample format.
+ *
+ * The USB frames carry the first channels TDM slots, subslotSize bytes each
+ * (AUDIO_FORMAT_SIZE as on the I2S side or AUDIO_FORMAT_SIZE_24 for packed
+ * 24-bit samples). The other slots are sent as zeros. Call it before
+ * I2S_TxStart().
+ */
+void USB_AudioUsb2I2sSetFormat(uint8_t channels, uint8_t subslotSize)
+{
+    usb_ctx.vs_txChannels = channels;
+    usb_ctx.vs_txSubslotSize = subslotSize;
+    usb_ctx.vs_txUnpack = I2S_GetUnpackKernel(channels, subslotSize);
+}
+
+/*!
+ * @brief Fill level target for the nominal packet (rate and interval).
+ *
+ * The streaming starts with as many whole DMA buffers of frames as fit in the
+ * target (see USB_AudioUsb2I2sBuffer()), so that with the larger packets the
+ * fill level does not have to be pulled up from a single buffer while the
+ * first rate measurement is still pending.
+ */
+static void USB_SetExplicitFeedbackTarget(void)
+{
+    usb_ctx.vs_txTarget = I2S_TX_FEEDBACK_TARGET_PACKET((usb_ctx.vs_txNormal * usb_ctx.vs_txUframes) >> 16);
+    usb_ctx.vs_txStartBufs = MIN(MAX(usb_ctx.vs_txTarget / I2S_TX_BUFF_FRAMES, 1U), I2S_TX_BUFF_NUM - 1U);
+}
+
+/*!
+ * @brief Set the sampling rate [Hz].
+ *
+ * Only the explicit feedback depends on it (nominal, rate measurement window
+ * and fill level target), the I2S side is clocked by the master. Call it
+ * before I2S_TxStart().
+ */
+void USB_AudioUsb2I2sSetRate(uint32_t rate)
+{
+    usb_ctx.vs_txNormal = I2S_TX_FEEDBACK_NORMAL(rate);
+    usb_ctx.vs_txRateWindow = I2S_TX_FEEDBACK_WINDOW_RATE(rate);
+    USB_SetExplicitFeedbackTarget();
+}
+
+/*!
+ * @brief Set the microframes between two OUT packets.
+ *
+ * 2^(bInterval - 1) of the alternate setting, see USB_DeviceGetStreamUframes().
+ * The feedback stays in frames per microframe (the host scales it by the
+ * interval), only the fill level target depends on it. Call it before
+ * I2S_TxStart().
+ */
+void USB_AudioUsb2I2sSetInterval(uint32_t uframes)
+{
+    usb_ctx.vs_txUframes = uframes;
+    USB_SetExplicitFeedbackTarget();
+}
+
+/*!
+ * @brief Set the gain of each TDM slot, Q2.30 (see I2S_GainSetTarget()).
+ *
+ * Ramped to from the next OUT packet on, can be called at any time.
+ */
+void USB_AudioUsb2I2sSetGain(const int32_t *gain)
+{
+    I2S_GainSetTarget(&s_txGain, gain);
+}
+
+/*!
+ * @brief Set the USB channel of each TDM slot (see I2S_RouteSet()).
+ *
+ * Switched to from the next OUT packet on, can be called at any time.
+ *
+ * @return false when the map is not valid.
+ */
+bool USB_AudioUsb2I2sSetRoute(const uint8_t *map)
+{
+    return I2S_RouteSet(&s_txRoute, map);
+}
+
+/*!
+ * @brief Get the USB channel of each TDM slot.
+ */
+void USB_AudioUsb2I2sGetRoute(uint8_t *map)
+{
+    I2S_RouteGet(&s_txRoute, map);
+}
 
-    /* We need to slow down */
-    if (diff >= I2S_TX_FEEDBACK_TH_UP)
+/*!
+ * @brief Buffer for the next OUT packet.
+ *
+ * Where the USB controller has to receive the next OUT packet: the next
+ * g_usbBuffOut slot or, when I2S_TX_DMA_INTERLEAVE is set, directly the DMA
+ * ring. NULL when I2S_TX_USB_QUEUE_DEPTH receives are already queued and not
+ * yet handed back with USB_AudioUsb2I2sBuffer().
+ *
+ * With I2S_TX_DMA_INTERLEAVE a packet lands at least a max packet past the
+ * write position for each receive queued before it, and never over one of
+ * them: USB_AudioUsb2I2sBuffer() slides it down when the packets before it
+ * came in short. Before the streaming is started a single receive is queued,
+ * in the tail: call it again once the packet is handed back to queue the
+ * others.
+ */
+uint8_t *USB_AudioUsb2I2sNextBuffer(void)
+{
+    uint8_t *buffer;
+
+    if (usb_ctx.vs_txUsbQueued >= I2S_TX_USB_QUEUE_DEPTH)
     {
-        return (I2S_TX_FEEDBACK_NORMAL - I2S_TX_FEEDBACK_TH_STEP);
+        return NULL;
     }
 
-    /* We need to speed up */
-    if (diff <= I2S_TX_FEEDBACK_TH_DOWN)
+#if I2S_TX_DMA_INTERLEAVE
+    if (usb_ctx.vs_txUsbStarted == 0)
     {
-        return (I2S_TX_FEEDBACK_NORMAL + I2S_TX_FEEDBACK_TH_STEP);
+        if (usb_ctx.vs_txUsbQueued > 0)
+        {
+            return NULL;
+        }
+
+        buffer = I2S_RingTail(&s_txRing);
     }
+    else
+    {
+        uint32_t queued = usb_ctx.vs_txUsbQueued;
+        uint32_t offset = queued * USB_MAX_PACKET_OUT_SIZE;
+        uint32_t pos;
+        uint32_t k = 0;
 
-    /* We are just fine */
-    return I2S_TX_FEEDBACK_NORMAL;
+        /* Past the queued ones that would overlap, then check them again */
+        while (k < queued)
+        {
+            pos = s_txRecvPos[(s_txRecvFirst + k) % I2S_TX_USB_QUEUE_DEPTH];
+            pos = (pos >= s_txRing.pos) ? (pos - s_txRing.pos) : (pos + I2S_TX_RING_SIZE - s_txRing.pos);
+
+            if ((offset < (pos + USB_MAX_PACKET_OUT_SIZE)) && (pos < (offset + USB_MAX_PACKET_OUT_SIZE)))
+            {
+                offset = pos + USB_MAX_PACKET_OUT_SIZE;
+                k = 0;
+            }
+            else
+            {
+                k++;
+            }
+        }
+
+        pos = s_txRing.pos + offset;
+        if (pos >= I2S_TX_RING_SIZE)
+        {
+            pos -= I2S_TX_RING_SIZE;
+        }
+
+        s_txRecvPos[(s_txRecvFirst + queued) % I2S_TX_USB_QUEUE_DEPTH] = pos;
+        buffer = &s_txRing.data[pos];
+    }
+#else
+    buffer = g_usbBuffOut[s_usbBuffOutIndex];
+    s_usbBuffOutIndex = (s_usbBuffOutIndex + 1) % I2S_TX_USB_QUEUE_DEPTH;
+#endif
+
+    usb_ctx.vs_txUsbQueued++;
+
+    return buffer;
 }
 
 /*!
  * @brief Audio wav data prepare function.
  *
- * This function prepare audio wav data before send through I2S.
+ * This function prepare audio wav data before send through I2S. usbBuffer is
+ * where the packet was received (see USB_AudioUsb2I2sNextBuffer()).
  */
 void USB_AudioUsb2I2sBuffer(uint8_t *usbBuffer, uint32_t size)
 {
-    assert(size % I2S_FRAME_LEN == 0);
+    assert(size % (usb_ctx.vs_txChannels * usb_ctx.vs_txSubslotSize) == 0);
+
+    PROF_BEGIN(kPROF_Usb2I2sBuffer);
+
+    if (usb_ctx.vs_txUsbQueued > 0)
+    {
+        usb_ctx.vs_txUsbQueued--;
+#if I2S_TX_DMA_INTERLEAVE
+        if (usb_ctx.vs_txUsbStarted == 1)
+        {
+            s_txRecvFirst = (s_txRecvFirst + 1) % I2S_TX_USB_QUEUE_DEPTH;
+        }
+#endif
+    }
 
     /**
      * This is tricky but we we cannot start the I2S TX path and start gathering
@@ -163,47 +679,74 @@ void USB_AudioUsb2I2sBuffer(uint8_t *usbBuffer, uint32_t size)
      * from USB.
      *
      * What we do instead is we start the I2S TX path and we wait until the I2S
-     * TX pointers are in the middle of the DMA buffers before starting the
-     * actual data gathering from USB. In theory assuming the same rate of
-     * production and consumption by the time the TX pointers are pointing to
-     * the first buffer, we already have filled the half the buffers with data.
+     * TX pointers are vs_txStartBufs buffers away from the first one before
+     * starting the actual data gathering from USB. In theory assuming the same
+     * rate of production and consumption by the time the TX pointers are
+     * pointing to the first buffer, we already have filled vs_txStartBufs
+     * buffers with data (one at 48 kHz, see USB_SetExplicitFeedbackTarget()).
      */
-    if ((usb_ctx.vs_txUsbStarted == 0) && (usb_ctx.vs_txNextBufIndex != (I2S_TX_BUFF_NUM / 2) + 1))
+    if ((usb_ctx.vs_txUsbStarted == 0) && (s_txRing.nextBuf != (I2S_TX_BUFF_NUM - usb_ctx.vs_txStartBufs)))
     {
-        bzero(usbBuffer, size);
+        PROF_END(kPROF_Usb2I2sBuffer);
         return;
     }
 
     usb_ctx.vs_txUsbStarted = 1;
 
-    for (size_t k = 0; k < size; k += I2S_FRAME_LEN)
+    /**
+     * The I2S frames are written over the USB ones. The ring is followed by the
+     * tail and g_usbBuffOut is large enough for a full frames packet. The very
+     * first packet was received in the tail and the ones queued behind another
+     * one further in the ring (see USB_AudioUsb2I2sNextBuffer()), the ring
+     * moves them in place.
+     */
+    if (usb_ctx.vs_txUnpack != NULL)
     {
-        for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-        {
-            uint32_t *pos = &s_txAudioPos[inst];
+        uint32_t frames = size / (usb_ctx.vs_txChannels * usb_ctx.vs_txSubslotSize);
 
-            memcpy(&s_i2sTxBuff[inst][*pos], usbBuffer + k + (inst * I2S_FRAME_LEN_PER_INST), I2S_FRAME_LEN_PER_INST);
-            *pos = (*pos + I2S_FRAME_LEN_PER_INST) % (I2S_TX_BUFF_SIZE_PER_INST * I2S_TX_BUFF_NUM);
-        }
+        usb_ctx.vs_txUnpack(usbBuffer, frames, usb_ctx.vs_txChannels, usb_ctx.vs_txSubslotSize);
+        size = frames * I2S_FRAME_LEN;
     }
 
-    usb_ctx.vs_txWriteDataCount += size;
-
+#if I2S_ASRC
+    /* Converted to the I2S rate in s_txAsrcBuff, the rest goes from there */
+    size = I2S_AsrcProcess(&s_txAsrc, usbBuffer, size / I2S_FRAME_LEN, (uint8_t *)s_txAsrcBuff, I2S_ASRC_BATCH_FRAMES,
+                           usb_ctx.vs_txChannels) *
+           I2S_FRAME_LEN;
+    usbBuffer = (uint8_t *)s_txAsrcBuff;
+#endif
+
+    /* Gains of the USB channels, then USB channels to TDM slots (all of them) */
+    I2S_GainApply(&s_txGain, usbBuffer, size / I2S_FRAME_LEN, usb_ctx.vs_txChannels);
+    I2S_RouteApply(&s_txRoute, usbBuffer, size / I2S_FRAME_LEN, I2S_CH_NUM);
+
+    I2S_RingWrite(&s_txRing, usbBuffer, size / I2S_FRAME_LEN);
+
+#if I2S_ASRC
+    /* Ratio for the next packet */
+    usb_ctx.vs_txFeedback = USB_GetAsrcFeedback();
+    I2S_AsrcSetRatio(&s_txAsrc, usb_ctx.vs_txNormal, usb_ctx.vs_txFeedback);
+#else
     usb_ctx.vs_txFeedback = USB_GetExplicitFeedback();
+#endif
+
+    PROF_END(kPROF_Usb2I2sBuffer);
 }
 
 /*!
- * @brief I2S TX callback.
+ * @brief I2S TX buffer done.
+ *
+ * Called by the ring every time I2S_TX_BUFF_SIZE bytes have been consumed.
  */
-static void I2S_TxCallback(I2S_Type *base, i2s_dma_handle_t *handle, status_t completionStatus, void *userData)
+static void I2S_TxBufferDone(i2s_ring_t *ring)
 {
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
+    I2S_TxMeasureRate();
+
+    if (ring->traceSample)
     {
-        I2S_TxTransferSendDMA(s_i2sTxBase[inst], &s_i2sDmaTxHandle[inst], s_i2sTxTransfer[inst][usb_ctx.vs_txNextBufIndex]);
+        TRACE(kTRACE_TxFeedback, usb_ctx.vs_txFeedback);
     }
 
-    usb_ctx.vs_txNextBufIndex = ((usb_ctx.vs_txNextBufIndex + 1) % I2S_TX_BUFF_NUM);
-
     /**
      * We do not consider data in the buffer to be valid until:
      *
@@ -215,9 +758,9 @@ static void I2S_TxCallback(I2S_Type *base, i2s_dma_handle_t *handle, status_t co
      */
     if (usb_ctx.vs_txDataIsValid == 1)
     {
-        usb_ctx.vs_txReadDataCount += I2S_TX_BUFF_SIZE;
+        I2S_FifoPop(&ring->fifo, ring->buffFrames);
     }
-    else if ((usb_ctx.vs_txUsbStarted == 1) && (usb_ctx.vs_txNextBufIndex == 0))
+    else if ((usb_ctx.vs_txUsbStarted == 1) && (ring->nextBuf == 0))
     {
         usb_ctx.vs_txDataIsValid = 1;
     }
@@ -231,21 +774,24 @@ static void I2S_TxCallback(I2S_Type *base, i2s_dma_handle_t *handle, status_t co
  */
 static inline void I2S_TxCleanup(void)
 {
-    usb_ctx.vs_txNextBufIndex = 0;
-    usb_ctx.vs_txReadDataCount = 0;
     usb_ctx.vs_txDataIsValid = 0;
     usb_ctx.vs_txUsbStarted = 0;
-
-    usb_ctx.vs_txReadDataCount = 0;
-    usb_ctx.vs_txWriteDataCount = 0;
-
-    usb_ctx.vs_txFeedback = I2S_TX_FEEDBACK_NORMAL;
-
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        s_txAudioPos[inst] = 0;
-        bzero(s_i2sTxBuff[inst], I2S_TX_BUFF_NUM * I2S_TX_BUFF_SIZE_PER_INST);
-    }
+    usb_ctx.vs_txUsbQueued = 0;
+#if I2S_TX_DMA_INTERLEAVE
+    s_txRecvFirst = 0;
+#endif
+
+    usb_ctx.vs_txFeedback = usb_ctx.vs_txNormal;
+
+    usb_ctx.vs_txRate = usb_ctx.vs_txNormal;
+    usb_ctx.vs_txRateStarted = 0;
+    usb_ctx.vs_txRateValid = 0;
+
+#if I2S_ASRC
+    usb_ctx.vs_txAsrcLevel = 0;
+    I2S_AsrcSetRatio(&s_txAsrc, usb_ctx.vs_txNormal, usb_ctx.vs_txFeedback);
+    I2S_AsrcReset(&s_txAsrc);
+#endif
 }
 
 /*!
@@ -253,11 +799,7 @@ static inline void I2S_TxCleanup(void)
  */
 void I2S_TxStop(void)
 {
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        I2S_TransferAbortDMA(s_i2sTxBase[inst], &s_i2sDmaTxHandle[inst]);
-    }
-
+    I2S_RingStop(&s_txRing);
     I2S_TxCleanup();
 }
 
@@ -267,96 +809,7 @@ void I2S_TxStop(void)
 void I2S_TxStart(void)
 {
     I2S_TxCleanup();
-
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        for (size_t buf = 0; buf < I2S_TX_BUFF_NUM; buf++)
-        {
-            I2S_TxTransferSendDMA(s_i2sTxBase[inst], &s_i2sDmaTxHandle[inst], s_i2sTxTransfer[inst][buf]);
-        }
-    }
-}
-
-/*!
- * @brief I2S parameters setup.
- *
- * Function to setup the I2S parameters.
- */
-static void I2S_TxSetupParams(i2s_config_t *txConfig)
-{
-    /**
-     * Default values:
-     *   config->masterSlave = kI2S_MasterSlaveNormalSlave;
-     *   config->mode = kI2S_ModeI2sClassic;
-     *   config->rightLow = false;
-     *   config->leftJust = false;
-     *   config->pdmData = false;
-     *   config->sckPol = false;
-     *   config->wsPol = false;
-     *   config->divider = 1;
-     *   config->oneChannel = false;
-     *   config->dataLength = 16;
-     *   config->frameLength = 32;
-     *   config->position = 0;
-     *   config->watermark = 4;
-     *   config->txEmptyZero = true;
-     *   config->pack48 = false;
-     */
-    I2S_TxGetDefaultConfig(txConfig);
-
-    txConfig->masterSlave = kI2S_MasterSlaveNormalSlave; /** Normal Slave */
-    txConfig->mode = kI2S_ModeDspWsShort;                /** DSP mode, WS having one clock long pulse */
-    txConfig->dataLength = TO_BITS(I2S_CH_LEN_DATA);
-    txConfig->frameLength = TO_BITS(I2S_FRAME_LEN);
-}
-
-/*!
- * @brief DMA channels setup.
- *
- * Function to setup the DMA channels (one for each I2S instance).
- */
-static void DMA_TxSetupChannels(void)
-{
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        DMA_EnableChannel(DMA, s_i2sTxDmaChannel[inst]);
-        DMA_SetChannelPriority(DMA, s_i2sTxDmaChannel[inst], s_i2sTxDmaPrio[inst]);
-        DMA_CreateHandle(&s_dmaTxHandle[inst], DMA, s_i2sTxDmaChannel[inst]);
-    }
-}
-
-/*!
- * @brief I2S DMA setup.
- *
- * Function to setup I2S (with secondary channels) and DMA.
- */
-static void I2S_DMA_TxSetup(i2s_config_t *txConfig)
-{
-    for (size_t inst = 0; inst < I2S_INST_NUM; inst++)
-    {
-        for (size_t buf = 0; buf < I2S_TX_BUFF_NUM; buf++)
-        {
-            s_i2sTxTransfer[inst][buf].data = &s_i2sTxBuff[inst][buf * I2S_TX_BUFF_SIZE_PER_INST];
-            s_i2sTxTransfer[inst][buf].dataSize = I2S_TX_BUFF_SIZE_PER_INST;
-        }
-
-        txConfig->position = (inst * TO_BITS(I2S_FRAME_LEN_PER_INST));
-
-        I2S_TxInit(s_i2sTxBase[inst], txConfig);
-
-        I2S_EnableSecondaryChannel(s_i2sTxBase[inst], kI2S_SecondaryChannel1, false, CH_OFF((inst * I2S_FRAME_LEN_PER_INST), 1));
-        I2S_EnableSecondaryChannel(s_i2sTxBase[inst], kI2S_SecondaryChannel2, false, CH_OFF((inst * I2S_FRAME_LEN_PER_INST), 2));
-        I2S_EnableSecondaryChannel(s_i2sTxBase[inst], kI2S_SecondaryChannel3, false, CH_OFF((inst * I2S_FRAME_LEN_PER_INST), 3));
-
-        if (inst == (I2S_INST_NUM - 1))
-        {
-            I2S_TxTransferCreateHandleDMA(s_i2sTxBase[inst], &s_i2sDmaTxHandle[inst], &s_dmaTxHandle[inst], I2S_TxCallback, (void *)s_i2sTxTransfer[inst]);
-        }
-        else
-        {
-            I2S_TxTransferCreateHandleDMA(s_i2sTxBase[inst], &s_i2sDmaTxHandle[inst], &s_dmaTxHandle[inst], NULL, NULL);
-        }
-    }
+    I2S_RingStart(&s_txRing);
 }
 
 /*!
@@ -366,9 +819,10 @@ static void I2S_DMA_TxSetup(i2s_config_t *txConfig)
  */
 void BOARD_I2S_TxInit(void)
 {
-    i2s_config_t txConfig = {0};
-
-    I2S_TxSetupParams(&txConfig);
-    DMA_TxSetupChannels();
-    I2S_DMA_TxSetup(&txConfig);
+    I2S_RouteInit(&s_txRoute);
+    I2S_GainInit(&s_txGain);
+#if I2S_ASRC
+    I2S_AsrcInit(&s_txAsrc);
+#endif
+    I2S_RingInit(&s_txRing);
 }
@@ -34,6 +34,13 @@
 #include "fsl_dma.h"
 
 void USB_AudioUsb2I2sBuffer(uint8_t *buffer, uint32_t size);
+uint8_t *USB_AudioUsb2I2sNextBuffer(void);
+void USB_AudioUsb2I2sSetFormat(uint8_t channels, uint8_t subslotSize);
+void USB_AudioUsb2I2sSetRate(uint32_t rate);
+void USB_AudioUsb2I2sSetInterval(uint32_t uframes);
+void USB_AudioUsb2I2sSetGain(const int32_t *gain);
+bool USB_AudioUsb2I2sSetRoute(const uint8_t *map);
+void USB_AudioUsb2I2sGetRoute(uint8_t *map);
 void BOARD_I2S_TxInit(void);
 
 void I2S_TxStart(void);
@@ -43,30 +50,45 @@ uint32_t USB_GetFeedback(uint8_t speed);
 
 void USB_OutPrintInfo(void);
 
-extern uint8_t g_usbBuffOut[];
-
 /**
  * I2S HW controllers.
  */
 #define I2S_TX_0 (I2S4) /* FLEXCOMM4 */
 #define I2S_TX_1 (I2S6) /* FLEXCOMM6 */
+#define I2S_TX_2 (I2S2) /* FLEXCOMM2, 4 instances only */
+#define I2S_TX_3 (I2S0) /* FLEXCOMM0, 4 instances only (debug console) */
+
+/**
+ * I2S bridge index of the controllers, to share the signals.
+ */
+#define I2S_TX_0_FLEXCOMM (kI2S_BRIDGE_Flexcomm4)
+#define I2S_TX_1_FLEXCOMM (kI2S_BRIDGE_Flexcomm6)
+#define I2S_TX_2_FLEXCOMM (kI2S_BRIDGE_Flexcomm2)
+#define I2S_TX_3_FLEXCOMM (kI2S_BRIDGE_Flexcomm0)
 
 /**
  * I2S DMA channels.
  */
 #define I2S_TX_0_DMA_CH (9)  /* Flexcomm Interface 4 TX */
 #define I2S_TX_1_DMA_CH (13) /* Flexcomm Interface 6 TX */
+#define I2S_TX_2_DMA_CH (5)  /* Flexcomm Interface 2 TX */
+#define I2S_TX_3_DMA_CH (1)  /* Flexcomm Interface 0 TX */
 
 /**
  * I2S DMA chennels priority.
  */
 #define I2S_TX_0_DMA_CH_PRIO (kDMA_ChannelPriority7)
 #define I2S_TX_1_DMA_CH_PRIO (kDMA_ChannelPriority7)
+#define I2S_TX_2_DMA_CH_PRIO (kDMA_ChannelPriority7)
+#define I2S_TX_3_DMA_CH_PRIO (kDMA_ChannelPriority7)
 
 /**
- * USB max packet size. We default to High-Speed [448 bytes]
+ * USB max packet size, at the max sampling rate, counted in full I2S frames:
+ * the packets are built (or received) in place as I2S frames. We default to
+ * High-Speed [832 bytes]
  */
-#define USB_MAX_PACKET_OUT_SIZE (HS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE))
+#define USB_MAX_PACKET_OUT_SIZE \
+    (((HS_ISO_OUT_ENDP_PACKET_SIZE_MAX / (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)) + 1U) * I2S_FRAME_LEN)
 
 /**
  * Number of buffers for I2S DMA ping-pong [4]
@@ -74,14 +96,16 @@ extern uint8_t g_usbBuffOut[];
 #define I2S_TX_BUFF_NUM (4U)
 
 /**
- * Size of each I2S DMA instance buffer. We use 4 times the size of the USB
- * packet divided by the number of I2S instances [896 bytes]
+ * Size of the I2S DMA buffer considering all the instances. The I2S_TX_BUFF_NUM
+ * buffers and a max packet of tail share I2S_RING_RAM_SIZE, in whole frames
+ * [1664 bytes, 26 frames]
  */
-#define I2S_TX_BUFF_SIZE_PER_INST ((USB_MAX_PACKET_OUT_SIZE * 4U) / I2S_INST_NUM)
+#define I2S_TX_BUFF_SIZE \
+    ((((I2S_RING_RAM_SIZE - USB_MAX_PACKET_OUT_SIZE) / I2S_TX_BUFF_NUM) / I2S_FRAME_LEN) * I2S_FRAME_LEN)
 
 /**
- * Size of the I2S DMA buffer considering all the instances [1792 bytes]
+ * Size of each I2S DMA instance buffer [832 bytes]
  */
-#define I2S_TX_BUFF_SIZE (I2S_INST_NUM * I2S_TX_BUFF_SIZE_PER_INST)
+#define I2S_TX_BUFF_SIZE_PER_INST (I2S_TX_BUFF_SIZE / I2S_INST_NUM)
 
 #endif /* __I2S_TX_H__ */
\ No newline at end of file
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <inttypes.h>
+
+#include "usb_device_config.h"
+#include "usb.h"
+#include "fsl_device_registers.h"
+
+#include "prof.h"
+
+#if PROF_ENABLE
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+typedef struct _prof_frame
+{
+    prof_probe_t probe;
+    uint32_t ipsr;   /* Exception context the probe was started from */
+    uint32_t start;  /* [cycles] */
+    uint32_t nested; /* [cycles] spent in the preempting probes */
+} prof_frame_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static prof_stats_t s_profStats[kPROF_Count];
+static prof_frame_t s_profStack[PROF_MAX_DEPTH];
+static uint32_t s_profDepth;
+
+static const char *const s_profNames[kPROF_Count] = {
+    [kPROF_I2s2UsbBuffer] = "I2s2UsbBuffer",
+    [kPROF_Usb2I2sBuffer] = "Usb2I2sBuffer",
+    [kPROF_RxCallback] = "RxCallback",
+    [kPROF_TxCallback] = "TxCallback",
+    [kPROF_AudioCallback] = "AudioCallback",
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/*!
+ * @brief Account for a completed run of a probe.
+ */
+static inline void PROF_Account(prof_stats_t *stats, uint32_t cycles)
+{
+    uint32_t bin = (cycles == 0U) ? 0U : (31U - __CLZ(cycles));
+
+    if ((stats->count == 0U) || (cycles < stats->min))
+    {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max)
+    {
+        stats->max = cycles;
+    }
+
+    stats->count++;
+    stats->sum += cycles;
+    stats->hist[bin]++;
+}
+
+/*!
+ * @brief Start a probe.
+ *
+ * The interrupts are masked so that the stack is consistent when a probe is
+ * started or stopped by a preempting interrupt. Past PROF_MAX_DEPTH the probes
+ * are only counted to keep the stack balanced, not measured.
+ */
+void PROF_Begin(prof_probe_t probe)
+{
+    uint32_t primask = DisableGlobalIRQ();
+    uint32_t ipsr = __get_IPSR();
+
+    if (s_profDepth < PROF_MAX_DEPTH)
+    {
+        prof_frame_t *frame = &s_profStack[s_profDepth];
+
+        if ((s_profDepth > 0U) && (s_profStack[s_profDepth - 1U].ipsr != ipsr))
+        {
+            s_profStats[s_profStack[s_profDepth - 1U].probe].preempted++;
+        }
+
+        frame->probe = probe;
+        frame->ipsr = ipsr;
+        frame->nested = 0U;
+        frame->start = DWT->CYCCNT;
+    }
+
+    s_profDepth++;
+
+    EnableGlobalIRQ(primask);
+}
+
+/*!
+ * @brief Stop a probe.
+ *
+ * When the probe was preempting the one below it on the stack, its cycles are
+ * removed from the preempted one.
+ */
+void PROF_End(prof_probe_t probe)
+{
+    uint32_t primask = DisableGlobalIRQ();
+    uint32_t now = DWT->CYCCNT;
+
+    assert(s_profDepth > 0U);
+
+    s_profDepth--;
+
+    if (s_profDepth < PROF_MAX_DEPTH)
+    {
+        prof_frame_t *frame = &s_profStack[s_profDepth];
+        uint32_t elapsed = now - frame->start;
+
+        assert(frame->probe == probe);
+
+        if ((s_profDepth > 0U) && (s_profStack[s_profDepth - 1U].ipsr != frame->ipsr))
+        {
+            s_profStack[s_profDepth - 1U].nested += elapsed;
+        }
+
+        PROF_Account(&s_profStats[probe], elapsed - frame->nested);
+    }
+
+    EnableGlobalIRQ(primask);
+}
+
+/*!
+ * @brief Consistent snapshot of the statistics of a probe.
+ */
+void PROF_Get(prof_probe_t probe, prof_stats_t *stats)
+{
+    uint32_t primask = DisableGlobalIRQ();
+
+    *stats = s_profStats[probe];
+
+    EnableGlobalIRQ(primask);
+}
+
+/*!
+ * @brief Clear the statistics of all the probes.
+ *
+ * The running probes are left alone, they are accounted for when they end.
+ */
+void PROF_Reset(void)
+{
+    uint32_t primask = DisableGlobalIRQ();
+
+    memset(s_profStats, 0, sizeof(s_profStats));
+
+    EnableGlobalIRQ(primask);
+}
+
+/*!
+ * @brief Print the statistics of all the probes.
+ */
+void PROF_Print(void)
+{
+    prof_stats_t stats;
+
+    for (uint32_t probe = 0; probe < kPROF_Count; probe++)
+    {
+        PROF_Get((prof_probe_t)probe, &stats);
+
+        if (stats.count == 0U)
+        {
+            continue;
+        }
+
+        usb_echo("[PROF] %s: %" PRIu32 " runs, %" PRIu32 " / %" PRIu32 " / %" PRIu32
+                 " cycles (min / mean / max), %" PRIu32 " preempted\r\n",
+                 s_profNames[probe], stats.count, stats.min, (uint32_t)(stats.sum / stats.count), stats.max,
+                 stats.preempted);
+
+        usb_echo("[PROF]   log2:");
+        for (uint32_t bin = 0; bin < PROF_HIST_BINS; bin++)
+        {
+            if (stats.hist[bin] != 0U)
+            {
+                usb_echo(" %" PRIu32 ":%" PRIu32, bin, stats.hist[bin]);
+            }
+        }
+        usb_echo("\r\n");
+    }
+}
+
+#endif /* PROF_ENABLE */
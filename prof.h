@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __PROF_H__
+#define __PROF_H__ 1
+
+#include "fsl_common.h"
+
+/**
+ * Hot-path profiler, based on the DWT cycle counter.
+ *
+ * Every probe is a PROF_BEGIN() / PROF_END() pair around a function on the
+ * streaming path. For each probe we keep the number of runs, the min / max /
+ * total cycles and a log2 histogram (hist[n] counts the runs taking 2^n to
+ * 2^(n+1) - 1 cycles).
+ *
+ * The probes can nest: a probe started from the same exception context as the
+ * running one is a call (its cycles are part of the caller), a probe started
+ * from a different one is a preemption. The preempting cycles are removed from
+ * the preempted probe and its preempted counter is incremented, so min / max
+ * are the cycles spent by the function itself.
+ *
+ * Set PROF_ENABLE to (1) to build the profiler in, otherwise the probes are
+ * compiled out. The DWT cycle counter must be running (see main()).
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#ifndef PROF_ENABLE
+#define PROF_ENABLE (0)
+#endif
+
+/**
+ * Nesting depth: one per exception level that can run a probe (thread, USB,
+ * DMA) plus the calls between the probes.
+ */
+#define PROF_MAX_DEPTH (8U)
+
+/* log2 histogram bins, one per bit of the cycle counter */
+#define PROF_HIST_BINS (32U)
+
+typedef enum _prof_probe
+{
+    kPROF_I2s2UsbBuffer = 0U, /* USB_AudioI2s2UsbBuffer() */
+    kPROF_Usb2I2sBuffer,      /* USB_AudioUsb2I2sBuffer() */
+    kPROF_RxCallback,         /* RX ring, DMA buffer done */
+    kPROF_TxCallback,         /* TX ring, DMA buffer done */
+    kPROF_AudioCallback,      /* USB_DeviceAudioCallback() */
+    kPROF_Count,
+} prof_probe_t;
+
+/**
+ * Per-probe statistics. This is also the payload of the profiler vendor
+ * request (little endian, 152 bytes), keep the layout stable.
+ */
+typedef struct _prof_stats
+{
+    uint32_t count;     /* Completed runs */
+    uint32_t min;       /* [cycles] */
+    uint32_t max;       /* [cycles] */
+    uint32_t preempted; /* Times preempted by another probe */
+    uint64_t sum;       /* [cycles], mean is sum / count */
+    uint32_t hist[PROF_HIST_BINS];
+} prof_stats_t;
+
+#if PROF_ENABLE
+#define PROF_BEGIN(probe) PROF_Begin(probe)
+#define PROF_END(probe) PROF_End(probe)
+#else
+#define PROF_BEGIN(probe)
+#define PROF_END(probe)
+#endif
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+#if PROF_ENABLE
+void PROF_Begin(prof_probe_t probe);
+void PROF_End(prof_probe_t probe);
+void PROF_Get(prof_probe_t probe, prof_stats_t *stats);
+void PROF_Reset(void);
+void PROF_Print(void);
+#endif
+
+#endif /* __PROF_H__ */
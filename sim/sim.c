@@ -0,0 +1,1022 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "usb_device_config.h"
+#include "usb.h"
+#include "usb_device.h"
+#include "usb_device_class.h"
+#include "usb_audio_config.h"
+#include "usb_device_descriptor.h"
+
+#include "i2s.h"
+#include "i2s_asrc.h"
+#include "i2s_rx.h"
+#include "i2s_tx.h"
+#include "prof.h"
+#include "trace.h"
+#include "sync.h"
+
+#include "sim.h"
+
+/**
+ * Host simulation of the RX/TX streaming cores.
+ *
+ * Two independent virtual clocks are driving the simulation:
+ *
+ *  - the I2S clock, ticking once per TDM frame. Every tick one frame is pushed
+ *    into the RX DMA queues and one frame is pulled out of the TX DMA queues.
+ *
+ *  - the USB clock, ticking once per microframe. Every packet interval (one
+ *    or more microframes) the IN packet at the head of the IN queue goes on
+ *    the wire, the OUT packet (sized by the host according to the explicit
+ *    feedback) lands in the buffer at the head of the OUT queue and, every
+ *    feedback interval, the feedback value is read back. The queues model the transfers queued on the audio class (up to
+ *    USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH): the application refills them
+ *    from the completions, using USB_AudioI2s2UsbBuffer() and
+ *    USB_AudioUsb2I2sBuffer() / USB_AudioUsb2I2sNextBuffer(), and it can be
+ *    made late to check how much latency the queues absorb.
+ *
+ * Each clock has its own ppm offset and (non-accumulating) jitter.
+ *
+ * With USB_AUDIO_SYNC_MODE there is no feedback: the host sends the nominal
+ * rate of its SOF and the I2S clock follows the Audio PLL trim (see sync.h),
+ * the I2S ppm offset is the error of the crystal that the loop has to cancel.
+ *
+ * Every frame on the wire (both directions) is stamped: channel N carries
+ * (SEQ << 6 | N). Looking at the stamps at the other end of the pipe we detect
+ * repeated frames (underrun), skipped frames (overrun), silence and corrupted
+ * (misaligned) frames and we compute the end-to-end latency.
+ *
+ * With I2S_ASRC the frames are resampled and the stamps do not survive: each
+ * channel carries a sine instead and we measure how far the frames at the
+ * other end are from a clean sine (glitches, converter noise).
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SIM_NS_PER_SEC (1000000000.0)
+#define SIM_USB_UFRAME_NS (125000.0)
+
+/**
+ * HS feedback endpoint polling [2^(bInterval - 1) microframes]
+ */
+#define SIM_FEEDBACK_UFRAMES (1U << (HS_ISO_IN_FEEDBACK_ENDP_INTERVAL - 1U))
+
+/**
+ * Stamps are (SEQ << 6 | N) in the 24 MSBs of the samples, so that they go
+ * through the packed 24-bit alternate setting as well [18-bit sequence, ~5s]
+ */
+#define SIM_STAMP_SHIFT (8U)
+#define SIM_STAMP_CH_BITS (6U)
+#define SIM_STAMP_SEQ_BITS (32U - SIM_STAMP_SHIFT - SIM_STAMP_CH_BITS)
+#define SIM_STAMP_SEQ_MASK ((1U << SIM_STAMP_SEQ_BITS) - 1U)
+#define SIM_STAMP(seq, n) (((((seq) & SIM_STAMP_SEQ_MASK) << SIM_STAMP_CH_BITS) | (n)) << SIM_STAMP_SHIFT)
+
+#if I2S_ASRC
+/**
+ * The sine of each channel, about 1 kHz at -6 dBFS in the 24 MSBs. It makes a
+ * whole number of periods in the sequence space so that it wraps with no jump,
+ * with a different phase on each channel.
+ *
+ * Each sample is checked against the two before it: y[m] - 2 cos(w) y[m - 1] +
+ * y[m - 2] is zero for a clean sine, whatever its amplitude and phase, so the
+ * frames do not need to be aligned with the original ones. The residual of a
+ * skipped or repeated frame is in the order of the amplitude, that of the
+ * converter noise well below SIM_SINE_GLITCH. With --i2s-ppm / --usb-ppm the
+ * sine really moves by the clock offset, about -89 dB of residual per 1000 ppm.
+ */
+#define SIM_SINE_HZ (1000.0)
+#define SIM_SINE_AMPLITUDE ((double)(1 << 30))
+#define SIM_SINE_GLITCH (0.01)
+
+/* Frames skipped after the first non silent one, the converter ramping up */
+#define SIM_SINE_SETTLE (2U * I2S_ASRC_TAPS)
+#endif
+
+/**
+ * History of the frame timestamps, used for the latency [~1.3s]
+ */
+#define SIM_HISTORY (1U << 16)
+
+/**
+ * The application is late handling the completions once every period
+ */
+#define SIM_LATENCY_PERIOD_MS (10.0)
+
+#define SIM_QUEUE_DEPTH (USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH)
+
+typedef struct
+{
+    double durationS;
+    double i2sPpm;
+    double usbPpm;
+    double i2sJitterNs;
+    double usbJitterNs;
+    double i2sStartMs;
+    double usbStartMs;
+    double rxErrorMs;
+    double traceMs;
+    double latencyUs;
+    uint64_t seed;
+    uint32_t rate;
+    uint32_t interval;
+    uint32_t channels;
+    int packed;
+    int verbose;
+} sim_config_t;
+
+typedef struct
+{
+    double period;
+    double jitter;
+    double origin;
+    uint64_t ticks;
+    double next;
+} sim_clock_t;
+
+typedef struct
+{
+    const char *name;
+    int started;
+    uint32_t expected;
+    uint32_t lastSeq;
+    uint64_t frames;
+    uint64_t silent;
+    uint64_t repeated;
+    uint64_t skipped;
+    uint64_t corrupted;
+    double latMin;
+    double latMax;
+    double latSum;
+    uint64_t latCount;
+    double *history;
+#if I2S_ASRC
+    uint64_t sineFrames;
+    uint64_t glitches;
+    double residualMax;
+    double residualSum;
+    uint64_t residualCount;
+    double prev[2][I2S_CH_NUM];
+#endif
+} sim_checker_t;
+
+/**
+ * Transfers queued on an endpoint (head on the wire next) and the completions
+ * not yet handled by the application.
+ */
+typedef struct
+{
+    uint8_t *buffer[SIM_QUEUE_DEPTH];
+    uint32_t length[SIM_QUEUE_DEPTH];
+    uint32_t head;
+    uint32_t count;
+    uint8_t *doneBuffer[SIM_QUEUE_DEPTH];
+    uint32_t doneLength[SIM_QUEUE_DEPTH];
+    uint32_t done;
+    uint64_t missed;
+} sim_queue_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static sim_config_t s_config = {
+    .durationS = 10.0,
+    .i2sStartMs = 0.0,
+    .usbStartMs = 0.0,
+    .rxErrorMs = -1.0,
+    .seed = 1,
+    .rate = AUDIO_SAMPLING_RATE_KHZ * 1000U,
+    .interval = 1U,
+};
+
+static uint64_t s_rngState;
+
+static double s_rxHistory[SIM_HISTORY];
+static double s_txHistory[SIM_HISTORY];
+
+static sim_checker_t s_rxChecker = {.name = "IN/RX", .history = s_rxHistory};
+static sim_checker_t s_txChecker = {.name = "OUT/TX", .history = s_txHistory};
+
+static uint32_t s_i2sSeq;
+static uint32_t s_hostSeq;
+static uint32_t s_hostFeedback;
+static uint32_t s_hostAcc;
+static uint32_t s_lastInFrames;
+static uint32_t s_lastOutFrames;
+
+#if I2S_ASRC
+/* Sine step per frame and 2 cos() of it */
+static double s_sineOmega;
+static double s_sineCoef;
+#endif
+
+static uint32_t s_usbChannels = AUDIO_FORMAT_CHANNELS;
+static uint32_t s_usbSubslot = AUDIO_FORMAT_SIZE;
+static uint32_t s_usbFrameLen = I2S_FRAME_LEN;
+
+/* Max frames in a packet (nominal + 1, see USB_DeviceGetStreamPacketSize()) */
+static uint32_t s_packetFrames;
+
+/* Microframes between two packets, 2^(bInterval - 1) */
+static uint32_t s_uframes = 1U;
+
+static sim_queue_t s_inQueue;
+static sim_queue_t s_outQueue;
+static double s_appLateUntil;
+static double s_nextLatency;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double SIM_Random(void)
+{
+    /* xorshift64*, good enough for jitter */
+    s_rngState ^= s_rngState >> 12;
+    s_rngState ^= s_rngState << 25;
+    s_rngState ^= s_rngState >> 27;
+
+    return (double)((s_rngState * 0x2545F4914F6CDD1DULL) >> 11) / (double)(1ULL << 53);
+}
+
+static void SIM_ClockInit(sim_clock_t *clk, double nominalNs, double ppm, double jitterNs, double originNs)
+{
+    clk->period = nominalNs / (1.0 + (ppm / 1e6));
+    clk->jitter = jitterNs;
+    clk->origin = originNs;
+    clk->ticks = 0;
+    clk->next = originNs;
+
+    assert(jitterNs < (clk->period / 2));
+}
+
+#if USB_AUDIO_SYNC_MODE
+/*!
+ * @brief Change the period from the current tick on, without a phase jump.
+ */
+static void SIM_ClockSetPeriod(sim_clock_t *clk, double period)
+{
+    clk->origin += clk->period * clk->ticks;
+    clk->ticks = 0;
+    clk->period = period;
+}
+#endif
+
+static void SIM_ClockAdvance(sim_clock_t *clk)
+{
+    clk->ticks++;
+    clk->next = clk->origin + (clk->period * clk->ticks) + (clk->jitter * ((2.0 * SIM_Random()) - 1.0));
+}
+
+static void SIM_Stamp(uint8_t *frame, uint32_t seq)
+{
+    uint32_t *ch = (uint32_t *)frame;
+
+    for (uint32_t n = 0; n < I2S_CH_NUM; n++)
+    {
+#if I2S_ASRC
+        double y = SIM_SINE_AMPLITUDE * sin((s_sineOmega * (seq & SIM_STAMP_SEQ_MASK)) + ((M_PI * n) / 8.0));
+
+        ch[n] = (uint32_t)(int32_t)lrint(y) & 0xFFFFFF00U;
+#else
+        ch[n] = SIM_STAMP(seq, n);
+#endif
+    }
+}
+
+/*!
+ * @brief Convert a frame in the USB format to the 32-bit wire format.
+ *
+ * The slots not carried by the USB frame are zeroed.
+ */
+static void SIM_UsbToWire(const uint8_t *usb, uint8_t *frame)
+{
+    uint32_t *ch = (uint32_t *)frame;
+
+    memset(frame, 0, I2S_FRAME_LEN);
+
+    for (uint32_t n = 0; n < s_usbChannels; n++)
+    {
+        const uint8_t *p = &usb[n * s_usbSubslot];
+
+        ch[n] = 0;
+        for (uint32_t b = 0; b < s_usbSubslot; b++)
+        {
+            ch[n] |= (uint32_t)p[b] << (8U * (b + 4U - s_usbSubslot));
+        }
+    }
+}
+
+/*!
+ * @brief Convert a frame in the 32-bit wire format to the USB format.
+ */
+static void SIM_WireToUsb(const uint8_t *frame, uint8_t *usb)
+{
+    const uint32_t *ch = (const uint32_t *)frame;
+
+    for (uint32_t n = 0; n < s_usbChannels; n++)
+    {
+        uint8_t *p = &usb[n * s_usbSubslot];
+
+        for (uint32_t b = 0; b < s_usbSubslot; b++)
+        {
+            p[b] = (uint8_t)(ch[n] >> (8U * (b + 4U - s_usbSubslot)));
+        }
+    }
+}
+
+#if I2S_ASRC
+static void SIM_Check(sim_checker_t *chk, const uint8_t *frame, double now)
+{
+    const int32_t *ch = (const int32_t *)frame;
+    bool zero = true;
+
+    (void)now;
+
+    chk->frames++;
+
+    for (uint32_t n = 0; n < I2S_CH_NUM; n++)
+    {
+        zero &= (ch[n] == 0);
+    }
+
+    if (zero)
+    {
+        if (chk->started)
+        {
+            chk->silent++;
+        }
+        else
+        {
+            return;
+        }
+    }
+
+    chk->started = 1;
+
+    /* Only the slots carried over USB make it to the other side */
+    for (uint32_t n = s_usbChannels; n < I2S_CH_NUM; n++)
+    {
+        if (ch[n] != 0)
+        {
+            chk->corrupted++;
+            break;
+        }
+    }
+
+    for (uint32_t n = 0; n < s_usbChannels; n++)
+    {
+        double y = ch[n];
+
+        if (chk->sineFrames >= SIM_SINE_SETTLE)
+        {
+            double r = fabs(y - (s_sineCoef * chk->prev[0][n]) + chk->prev[1][n]) / SIM_SINE_AMPLITUDE;
+
+            if (r > chk->residualMax)
+            {
+                chk->residualMax = r;
+            }
+            if (r > SIM_SINE_GLITCH)
+            {
+                chk->glitches++;
+            }
+            chk->residualSum += r * r;
+            chk->residualCount++;
+        }
+
+        chk->prev[1][n] = chk->prev[0][n];
+        chk->prev[0][n] = y;
+    }
+
+    chk->sineFrames++;
+}
+#else
+static void SIM_Check(sim_checker_t *chk, const uint8_t *frame, double now)
+{
+    const uint32_t *ch = (const uint32_t *)frame;
+    uint32_t seq = ch[0] >> (SIM_STAMP_SHIFT + SIM_STAMP_CH_BITS);
+    int32_t delta;
+    bool zero = true;
+    double lat;
+
+    chk->frames++;
+
+    for (uint32_t n = 0; n < I2S_CH_NUM; n++)
+    {
+        zero &= (ch[n] == 0);
+    }
+
+    if (zero)
+    {
+        if (chk->started)
+        {
+            chk->silent++;
+        }
+        return;
+    }
+
+    /* Only the slots carried over USB make it to the other side */
+    for (uint32_t n = 0; n < I2S_CH_NUM; n++)
+    {
+        if (ch[n] != ((n < s_usbChannels) ? SIM_STAMP(seq, n) : 0U))
+        {
+            chk->corrupted++;
+            return;
+        }
+    }
+
+    if (chk->started)
+    {
+        /* Sign-extended distance on the sequence space */
+        delta = (int32_t)((seq - chk->expected) << (32U - SIM_STAMP_SEQ_BITS)) >> (32U - SIM_STAMP_SEQ_BITS);
+
+        if (delta > 0)
+        {
+            chk->skipped += delta;
+        }
+        else if (delta < 0)
+        {
+            chk->repeated += -delta;
+        }
+    }
+
+    chk->started = 1;
+    chk->lastSeq = seq;
+    chk->expected = (seq + 1) & SIM_STAMP_SEQ_MASK;
+
+    lat = now - chk->history[seq % SIM_HISTORY];
+
+    if ((chk->latCount == 0) || (lat < chk->latMin))
+    {
+        chk->latMin = lat;
+    }
+    if ((chk->latCount == 0) || (lat > chk->latMax))
+    {
+        chk->latMax = lat;
+    }
+    chk->latSum += lat;
+    chk->latCount++;
+}
+#endif
+
+static void SIM_Report(const sim_checker_t *chk)
+{
+#if I2S_ASRC
+    printf("[%s] frames: %llu, silent: %llu, corrupted: %llu, glitches: %llu\n", chk->name,
+           (unsigned long long)chk->frames, (unsigned long long)chk->silent, (unsigned long long)chk->corrupted,
+           (unsigned long long)chk->glitches);
+
+    if (chk->residualCount != 0)
+    {
+        printf("[%s] sine residual [dB] rms: %.1f, max: %.1f\n", chk->name,
+               10.0 * log10((chk->residualSum / chk->residualCount) + 1e-30), 20.0 * log10(chk->residualMax + 1e-15));
+    }
+#else
+    printf("[%s] frames: %llu, silent: %llu, repeated (underrun): %llu, skipped (overrun): %llu, corrupted: %llu\n",
+           chk->name, (unsigned long long)chk->frames, (unsigned long long)chk->silent,
+           (unsigned long long)chk->repeated, (unsigned long long)chk->skipped, (unsigned long long)chk->corrupted);
+
+    if (chk->latCount != 0)
+    {
+        printf("[%s] latency [us] min: %.1f, avg: %.1f, max: %.1f\n", chk->name, chk->latMin / 1e3,
+               (chk->latSum / chk->latCount) / 1e3, chk->latMax / 1e3);
+    }
+#endif
+}
+
+/*!
+ * @brief One tick of the I2S clock (one TDM frame in each direction).
+ *
+ * Only the slots after I2S_TDM_SLOT_OFFSET are stamped and checked.
+ */
+static void SIM_I2sTick(double now)
+{
+    uint8_t frame[SIM_WIRE_FRAME_MAX] = {0};
+
+    s_i2sSeq = (s_i2sSeq + 1) & SIM_STAMP_SEQ_MASK;
+    s_rxHistory[s_i2sSeq % SIM_HISTORY] = now;
+
+    SIM_Stamp(&frame[I2S_FRAME_OFFSET], s_i2sSeq);
+    SIM_I2sRxFrame(frame);
+
+    bzero(frame, sizeof(frame));
+    SIM_I2sTxFrame(frame);
+    SIM_Check(&s_txChecker, &frame[I2S_FRAME_OFFSET], now);
+}
+
+/*!
+ * @brief Queue a transfer (see USB_DeviceAudioSend() / USB_DeviceAudioRecv()).
+ */
+static void SIM_QueuePush(sim_queue_t *q, uint8_t *buffer, uint32_t length)
+{
+    uint32_t slot = (q->head + q->count) % SIM_QUEUE_DEPTH;
+
+    assert(q->count < SIM_QUEUE_DEPTH);
+
+    q->buffer[slot] = buffer;
+    q->length[slot] = length;
+    q->count++;
+}
+
+/*!
+ * @brief Complete the transfer at the head of the queue.
+ */
+static uint8_t *SIM_QueueComplete(sim_queue_t *q, uint32_t length)
+{
+    uint8_t *buffer = q->buffer[q->head];
+
+    assert(q->done < SIM_QUEUE_DEPTH);
+
+    q->doneBuffer[q->done] = buffer;
+    q->doneLength[q->done] = length;
+    q->done++;
+
+    q->head = (q->head + 1) % SIM_QUEUE_DEPTH;
+    q->count--;
+
+    return buffer;
+}
+
+/*!
+ * @brief Queue one more IN packet (see USB_DeviceAudioCallback()).
+ */
+static void SIM_InRefill(void)
+{
+    uint8_t *buffer;
+    uint32_t length;
+
+    length = USB_AudioI2s2UsbBuffer(&buffer, s_packetFrames * s_usbFrameLen);
+    assert(length <= (s_packetFrames * s_usbFrameLen));
+
+    SIM_QueuePush(&s_inQueue, buffer, length);
+}
+
+/*!
+ * @brief Queue OUT receives while the TX side has buffers for them.
+ */
+static void SIM_OutRefill(void)
+{
+    uint8_t *buffer;
+
+    while ((s_outQueue.count < SIM_QUEUE_DEPTH) && ((buffer = USB_AudioUsb2I2sNextBuffer()) != NULL))
+    {
+        SIM_QueuePush(&s_outQueue, buffer, s_packetFrames * s_usbFrameLen);
+    }
+}
+
+/*!
+ * @brief The application handles the pending completions.
+ */
+static void SIM_AppRun(void)
+{
+    for (uint32_t k = 0; k < s_inQueue.done; k++)
+    {
+        SIM_InRefill();
+    }
+    s_inQueue.done = 0;
+
+    for (uint32_t k = 0; k < s_outQueue.done; k++)
+    {
+        USB_AudioUsb2I2sBuffer(s_outQueue.doneBuffer[k], s_outQueue.doneLength[k]);
+    }
+    s_outQueue.done = 0;
+
+    SIM_OutRefill();
+}
+
+/*!
+ * @brief Streaming alternate setting selected: fill the queues.
+ */
+static void SIM_AppStart(void)
+{
+    for (uint32_t k = 0; k < SIM_QUEUE_DEPTH; k++)
+    {
+        SIM_InRefill();
+    }
+
+    SIM_OutRefill();
+}
+
+/*!
+ * @brief IN packet on the wire: it is read from its buffer when it goes out.
+ */
+static void SIM_UsbIn(double now)
+{
+    uint8_t wire[SIM_WIRE_FRAME_MAX];
+    uint8_t *buffer;
+
+    s_lastInFrames = 0;
+    if (s_inQueue.count > 0)
+    {
+        s_lastInFrames = s_inQueue.length[s_inQueue.head] / s_usbFrameLen;
+        buffer = SIM_QueueComplete(&s_inQueue, s_inQueue.length[s_inQueue.head]);
+
+        for (uint32_t k = 0; k < s_lastInFrames; k++)
+        {
+            SIM_UsbToWire(&buffer[k * s_usbFrameLen], wire);
+            SIM_Check(&s_rxChecker, wire, now);
+        }
+    }
+    else
+    {
+        s_inQueue.missed++;
+    }
+}
+
+/*!
+ * @brief OUT packet: the host sends as many frames as the feedback is asking
+ * for, the feedback being per microframe.
+ */
+static void SIM_UsbOut(double now)
+{
+    uint8_t wire[SIM_WIRE_FRAME_MAX];
+    uint8_t *buffer;
+    uint32_t frames;
+
+    s_hostAcc += s_hostFeedback * s_uframes;
+    frames = s_hostAcc >> 16;
+    s_hostAcc &= 0xFFFFU;
+
+    if (frames > s_packetFrames)
+    {
+        frames = s_packetFrames;
+    }
+
+    /* With no receive queued the packet is lost (the TX checker sees the skip) */
+    buffer = NULL;
+    if (s_outQueue.count > 0)
+    {
+        buffer = SIM_QueueComplete(&s_outQueue, frames * s_usbFrameLen);
+    }
+    else
+    {
+        s_outQueue.missed++;
+    }
+
+    for (uint32_t k = 0; k < frames; k++)
+    {
+        s_hostSeq = (s_hostSeq + 1) & SIM_STAMP_SEQ_MASK;
+        s_txHistory[s_hostSeq % SIM_HISTORY] = now;
+        if (buffer != NULL)
+        {
+            SIM_Stamp(wire, s_hostSeq);
+            SIM_WireToUsb(wire, &buffer[k * s_usbFrameLen]);
+        }
+    }
+
+    s_lastOutFrames = frames;
+}
+
+/*!
+ * @brief One tick of the USB clock (one microframe).
+ */
+static void SIM_UsbTick(double now, uint64_t uframe)
+{
+    SIM_UsbSof();
+
+    /* IN and OUT packets every s_uframes microframes */
+    if ((uframe % s_uframes) == 0)
+    {
+        SIM_UsbIn(now);
+    }
+
+#if !USB_AUDIO_SYNC_MODE
+    /* Feedback (HS: 16.16 frames per microframe, little endian) */
+    if ((uframe % SIM_FEEDBACK_UFRAMES) == 0)
+    {
+        uint32_t fb = USB_GetFeedback(USB_SPEED_HIGH);
+        const uint8_t *m = (const uint8_t *)&fb;
+
+        s_hostFeedback = m[0] | (m[1] << 8) | (m[2] << 16) | ((uint32_t)m[3] << 24);
+    }
+#endif
+
+    if ((uframe % s_uframes) == 0)
+    {
+        SIM_UsbOut(now);
+    }
+
+    /* Once every period the application is late */
+    if ((s_config.latencyUs > 0.0) && (now >= s_nextLatency))
+    {
+        s_appLateUntil = now + (s_config.latencyUs * 1e3);
+        s_nextLatency += SIM_LATENCY_PERIOD_MS * 1e6;
+    }
+
+    if (now >= s_appLateUntil)
+    {
+        SIM_AppRun();
+    }
+}
+
+static void SIM_Trace(double now)
+{
+    static int header;
+
+    if (!header)
+    {
+        printf("# t_ms,rx_fill,rx_pkt,tx_fill,tx_pkt,feedback\n");
+        header = 1;
+    }
+
+#if I2S_ASRC
+    /* No stamps to tell the end-to-end fill levels */
+    printf("%.3f,-1,%u,-1,%u,%.5f\n", now / 1e6, s_lastInFrames, s_lastOutFrames, s_hostFeedback / 65536.0);
+#else
+    printf("%.3f,%d,%u,%d,%u,%.5f\n", now / 1e6,
+           s_rxChecker.started ? (int32_t)(s_i2sSeq - s_rxChecker.lastSeq) : -1, s_lastInFrames,
+           s_txChecker.started ? (int32_t)(s_hostSeq - s_txChecker.lastSeq) : -1, s_lastOutFrames,
+           s_hostFeedback / 65536.0);
+#endif
+}
+
+static void SIM_Usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -d, --duration S      simulated time in seconds [10]\n"
+           "  -i, --i2s-ppm PPM     I2S clock offset [0]\n"
+           "  -u, --usb-ppm PPM     USB clock offset [0]\n"
+           "  -I, --i2s-jitter NS   I2S frame jitter (peak) [0]\n"
+           "  -U, --usb-jitter NS   USB SOF jitter (peak) [0]\n"
+           "  -s, --i2s-start MS    I2S clock start time [0]\n"
+           "  -S, --usb-start MS    USB streaming start time [0]\n"
+           "  -e, --rx-error MS     inject an RX slave frame error at MS\n"
+           "  -t, --trace MS        fill level trace period, 0 to disable [0]\n"
+           "  -l, --latency US      application late by US every 10ms [0]\n"
+           "  -c, --channels N      stream N channels (2, 8 or 16) [16]\n"
+           "  -p, --packed          use the packed 24-bit alternate setting\n"
+           "  -R, --rate HZ         sampling rate [48000]\n"
+           "  -b, --interval N      HS bInterval of the data endpoints (1 to 3) [1]\n"
+           "  -r, --seed N          jitter seed [1]\n"
+           "  -v, --verbose         dump the firmware debug info every second\n",
+           prog);
+}
+
+static void SIM_ParseArgs(int argc, char **argv)
+{
+    static const struct option opts[] = {
+        {"duration", required_argument, NULL, 'd'},   {"i2s-ppm", required_argument, NULL, 'i'},
+        {"usb-ppm", required_argument, NULL, 'u'},    {"i2s-jitter", required_argument, NULL, 'I'},
+        {"usb-jitter", required_argument, NULL, 'U'}, {"i2s-start", required_argument, NULL, 's'},
+        {"usb-start", required_argument, NULL, 'S'},  {"rx-error", required_argument, NULL, 'e'},
+        {"trace", required_argument, NULL, 't'},      {"seed", required_argument, NULL, 'r'},
+        {"latency", required_argument, NULL, 'l'},    {"channels", required_argument, NULL, 'c'},
+        {"packed", no_argument, NULL, 'p'},           {"verbose", no_argument, NULL, 'v'},
+        {"rate", required_argument, NULL, 'R'},       {"interval", required_argument, NULL, 'b'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int c;
+
+    while ((c = getopt_long(argc, argv, "d:i:u:I:U:s:S:e:t:r:l:c:pR:b:vh", opts, NULL)) != -1)
+    {
+        switch (c)
+        {
+            case 'd':
+                s_config.durationS = atof(optarg);
+                break;
+            case 'i':
+                s_config.i2sPpm = atof(optarg);
+                break;
+            case 'u':
+                s_config.usbPpm = atof(optarg);
+                break;
+            case 'I':
+                s_config.i2sJitterNs = atof(optarg);
+                break;
+            case 'U':
+                s_config.usbJitterNs = atof(optarg);
+                break;
+            case 's':
+                s_config.i2sStartMs = atof(optarg);
+                break;
+            case 'S':
+                s_config.usbStartMs = atof(optarg);
+                break;
+            case 'e':
+                s_config.rxErrorMs = atof(optarg);
+                break;
+            case 't':
+                s_config.traceMs = atof(optarg);
+                break;
+            case 'l':
+                s_config.latencyUs = atof(optarg);
+                break;
+            case 'c':
+                s_config.channels = strtoul(optarg, NULL, 0);
+                if ((s_config.channels == 0) || (s_config.channels > I2S_CH_NUM))
+                {
+                    SIM_Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'p':
+                s_config.packed = 1;
+                break;
+            case 'R':
+                s_config.rate = strtoul(optarg, NULL, 0);
+                if ((s_config.rate == 0) || (s_config.rate > (AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U)))
+                {
+                    SIM_Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'b':
+                s_config.interval = strtoul(optarg, NULL, 0);
+                if ((s_config.interval == 0) || (s_config.interval > HS_ISO_ENDP_INTERVAL_MAX))
+                {
+                    SIM_Usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'r':
+                s_config.seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'v':
+                s_config.verbose = 1;
+                break;
+            default:
+                SIM_Usage(argv[0]);
+                exit(c == 'h' ? 0 : 1);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    sim_clock_t i2sClk;
+    sim_clock_t usbClk;
+    const sim_stats_t *stats;
+    double end;
+    double nextTrace;
+    double nextInfo;
+    bool rxErrorPending;
+#if USB_AUDIO_SYNC_MODE
+    double pllOffset = 0.0;
+#endif
+
+    SIM_ParseArgs(argc, argv);
+
+    s_rngState = s_config.seed ? s_config.seed : 1;
+
+#if I2S_ASRC
+    s_sineOmega = (2.0 * M_PI * round((SIM_SINE_HZ * (SIM_STAMP_SEQ_MASK + 1.0)) / s_config.rate)) /
+                  (SIM_STAMP_SEQ_MASK + 1.0);
+    s_sineCoef = 2.0 * cos(s_sineOmega);
+#endif
+
+    SIM_ClockInit(&i2sClk, SIM_NS_PER_SEC / s_config.rate, s_config.i2sPpm, s_config.i2sJitterNs,
+                  s_config.i2sStartMs * 1e6);
+    SIM_ClockInit(&usbClk, SIM_USB_UFRAME_NS, s_config.usbPpm, s_config.usbJitterNs, 0.0);
+
+    end = s_config.durationS * SIM_NS_PER_SEC;
+    nextTrace = 0.0;
+    nextInfo = SIM_NS_PER_SEC;
+    rxErrorPending = (s_config.rxErrorMs >= 0.0);
+
+    BOARD_I2S_Init();
+    BOARD_I2S_RxInit();
+    BOARD_I2S_TxInit();
+
+    /**
+     * The streaming cores are only called once the host selected the
+     * streaming alternate setting (see USB_DeviceCallback()), before that the
+     * SOF is running and the I2S side is free-running with no DMA armed.
+     */
+    while (usbClk.next < (s_config.usbStartMs * 1e6))
+    {
+        SIM_UsbSof();
+        SIM_ClockAdvance(&usbClk);
+    }
+
+    while (i2sClk.next < (s_config.usbStartMs * 1e6))
+    {
+        SIM_ClockAdvance(&i2sClk);
+    }
+
+    if (s_config.packed)
+    {
+        s_usbSubslot = AUDIO_FORMAT_SIZE_24;
+    }
+    if (s_config.channels != 0)
+    {
+        s_usbChannels = s_config.channels;
+    }
+    s_usbFrameLen = s_usbChannels * s_usbSubslot;
+    s_uframes = 1U << (s_config.interval - 1U);
+    s_packetFrames = (((s_config.rate * s_uframes) + 7999U) / 8000U) + 1U;
+    if ((s_packetFrames * s_usbFrameLen) > HS_ISO_MAX_PACKET_SIZE)
+    {
+        /* As the firmware build check, see HS_ISO_ENDP_PACKET_SIZE_AT_MAX */
+        fprintf(stderr, "%u bytes packets do not fit an isochronous transaction, lower --interval or --channels\n",
+                s_packetFrames * s_usbFrameLen);
+        exit(1);
+    }
+
+    USB_AudioI2s2UsbSetFormat(s_usbChannels, s_usbSubslot);
+    USB_AudioUsb2I2sSetFormat(s_usbChannels, s_usbSubslot);
+    USB_AudioI2s2UsbSetRate(s_config.rate);
+    USB_AudioUsb2I2sSetRate(s_config.rate);
+    USB_AudioI2s2UsbSetInterval(s_uframes);
+    USB_AudioUsb2I2sSetInterval(s_uframes);
+
+    I2S_RxStart();
+    I2S_TxStart();
+
+#if USB_AUDIO_SYNC_MODE
+    /* Synchronous OUT endpoint: nominal frames per microframe, 16.16 */
+    s_hostFeedback = (s_config.rate * 1024U) / 125U;
+
+    SYNC_Init();
+    SYNC_SetRate(s_config.rate);
+    SYNC_Start(USB_SPEED_HIGH);
+#endif
+
+    SIM_AppStart();
+    s_nextLatency = (s_config.usbStartMs + SIM_LATENCY_PERIOD_MS) * 1e6;
+
+    SIM_SetEcho(s_config.verbose);
+
+    while ((i2sClk.next < end) || (usbClk.next < end))
+    {
+        double now;
+
+        if (i2sClk.next <= usbClk.next)
+        {
+            now = i2sClk.next;
+
+            if (rxErrorPending && (now >= (s_config.rxErrorMs * 1e6)))
+            {
+                SIM_I2sRxFrameError();
+                rxErrorPending = false;
+            }
+
+            SIM_I2sTick(now);
+#if USB_AUDIO_SYNC_MODE
+            SIM_CtimerTick(I2S_MASTER_CLK_FS);
+            if (SIM_AudioPllOffset() != pllOffset)
+            {
+                pllOffset = SIM_AudioPllOffset();
+                SIM_ClockSetPeriod(&i2sClk, SIM_NS_PER_SEC / s_config.rate /
+                                                ((1.0 + (s_config.i2sPpm / 1e6)) * (1.0 + pllOffset)));
+            }
+#endif
+            SIM_ClockAdvance(&i2sClk);
+        }
+        else
+        {
+            now = usbClk.next;
+
+            SIM_UsbTick(now, usbClk.ticks);
+            SIM_ClockAdvance(&usbClk);
+        }
+
+        if ((s_config.traceMs > 0.0) && (now >= nextTrace))
+        {
+            SIM_Trace(now);
+            nextTrace += s_config.traceMs * 1e6;
+        }
+
+        if (s_config.verbose && (now >= nextInfo))
+        {
+            USB_OutPrintInfo();
+            USB_InPrintInfo();
+#if PROF_ENABLE
+            PROF_Print();
+#endif
+#if USB_AUDIO_SYNC_MODE
+            SYNC_PrintInfo();
+#endif
+#if TRACE_ENABLE
+            /* The DWT stub counts nanoseconds */
+            TRACE_Drain(SIM_NS_PER_SEC);
+#endif
+            nextInfo += SIM_NS_PER_SEC;
+        }
+    }
+
+    stats = SIM_GetStats();
+
+    printf("[SIM] duration: %.3fs, I2S: %+.1f ppm (%.0f ns), USB: %+.1f ppm (%.0f ns)\n", s_config.durationS,
+           s_config.i2sPpm, s_config.i2sJitterNs, s_config.usbPpm, s_config.usbJitterNs);
+    SIM_Report(&s_rxChecker);
+    SIM_Report(&s_txChecker);
+#if USB_AUDIO_SYNC_MODE
+    printf("[PLL] trim: %+.1f ppm\n", SIM_AudioPllOffset() * 1e6);
+#endif
+    printf("[USB] channels: %u, subslot: %u bytes, queue depth: %u, IN missed: %llu, OUT missed: %llu\n",
+           s_usbChannels, s_usbSubslot, SIM_QUEUE_DEPTH, (unsigned long long)s_inQueue.missed, (unsigned long long)s_outQueue.missed);
+    printf("[DMA] rx callbacks: %llu, tx callbacks: %llu, rx starved: %llu, tx starved: %llu\n",
+           (unsigned long long)stats->rxCallbacks, (unsigned long long)stats->txCallbacks,
+           (unsigned long long)stats->rxStarved, (unsigned long long)stats->txStarved);
+
+    return 0;
+}
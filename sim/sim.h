@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_H__
+#define __SIM_H__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * Max frame length on the virtual TDM wire [256 bytes / 64 channels]
+ */
+#define SIM_WIRE_FRAME_MAX (256U)
+
+/**
+ * Counters exported by the driver shims.
+ */
+typedef struct
+{
+    uint64_t rxStarved; /* RX frames lost because no DMA transfer was queued */
+    uint64_t txStarved; /* TX frames sent as zeros because no DMA transfer was queued */
+    uint64_t rxCallbacks;
+    uint64_t txCallbacks;
+} sim_stats_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+/**
+ * Push one frame from the virtual I2S RX wire into the RX DMA queues.
+ */
+void SIM_I2sRxFrame(const uint8_t *frame);
+
+/**
+ * Pull one frame for the virtual I2S TX wire from the TX DMA queues.
+ */
+void SIM_I2sTxFrame(uint8_t *frame);
+
+/**
+ * Raise a slave frame error on all the RX instances (resync on the I2S side).
+ */
+void SIM_I2sRxFrameError(void);
+
+/**
+ * Advance the USB SOF counter (one call per microframe).
+ */
+void SIM_UsbSof(void);
+
+/**
+ * Advance CTIMER0 by cycles of the Audio PLL clock.
+ */
+void SIM_CtimerTick(uint32_t cycles);
+
+/**
+ * Relative frequency offset of the Audio PLL set by BOARD_TrimAudioPll().
+ */
+double SIM_AudioPllOffset(void);
+
+/**
+ * Enable / disable the usb_echo() output.
+ */
+void SIM_SetEcho(int enable);
+
+const sim_stats_t *SIM_GetStats(void);
+
+#endif /* __SIM_H__ */
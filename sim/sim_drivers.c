@@ -0,0 +1,742 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdarg.h>
+#include <time.h>
+
+#include "usb_device_config.h"
+#include "usb.h"
+#include "usb_device.h"
+#include "usb_device_class.h"
+#include "fsl_device_registers.h"
+
+#include "fsl_i2s.h"
+#include "fsl_i2s_dma.h"
+#include "fsl_i2s_bridge.h"
+#include "fsl_dma.h"
+#include "fsl_ctimer.h"
+
+#include "clock_config.h"
+#include "sim.h"
+
+/**
+ * Host implementation of the SDK drivers used by the streaming cores.
+ *
+ * Every FLEXCOMM I2S instance remembers the slots it was configured for
+ * (primary pair + secondary pairs, as programmed through I2S_xxInit() and
+ * I2S_EnableSecondaryChannel()) so that a frame on the virtual TDM wire is
+ * scattered / gathered exactly as the FIFO would do on the real hardware.
+ *
+ * The DMA is modelled at frame granularity: every frame moves one slice per
+ * instance into (out of) the transfer at the head of the queue and when the
+ * transfer is complete the slot is released and the callback is called.
+ *
+ * CTIMER0 and the Audio PLL trim only exist to close the loop of the sync mode
+ * (see sync.h): the counter advances with the I2S frames and the trim is read
+ * back by the simulation to move the I2S clock.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SIM_I2S_ROLE_NONE (0U)
+#define SIM_I2S_ROLE_RX (1U)
+#define SIM_I2S_ROLE_TX (2U)
+
+#define SIM_I2S_PAIR_NUM (4U)
+
+/**
+ * Audio PLL numerator LSB in PLL cycles: 24 MHz x (mult + num / 27000), so
+ * one LSB of 888.9 Hz is 1 / 599040 of the 532.48 MHz PLL (48 kHz family) and
+ * 1 / 550368 of the 489.216 MHz one (44.1 kHz family).
+ */
+#define SIM_AUDIO_PLL_LSB_48K (599040.0)
+#define SIM_AUDIO_PLL_LSB_44K1 (550368.0)
+
+typedef struct
+{
+    uint8_t role;
+    uint8_t pairNum;
+    uint32_t pairLen;
+    uint32_t pairPos[SIM_I2S_PAIR_NUM];
+    i2s_dma_handle_t *handle;
+} sim_i2s_inst_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+I2S_Type g_simI2s[SIM_I2S_INST_COUNT];
+DMA_Type g_simDma0;
+CTIMER_Type g_simCtimer0;
+
+static DWT_Type s_simDwt;
+
+/* The DWT stub counts nanoseconds */
+uint32_t SystemCoreClock = 1000000000U;
+
+static sim_i2s_inst_t s_simI2s[SIM_I2S_INST_COUNT];
+static sim_stats_t s_simStats;
+static uint32_t s_simSofCount;
+static int s_simEcho;
+static ctimer_callback_t s_simCtimerCallback;
+static double s_simAudioPllLsb = SIM_AUDIO_PLL_LSB_48K;
+static int32_t s_simAudioPllTrim;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static inline sim_i2s_inst_t *SIM_I2sInst(I2S_Type *base)
+{
+    return &s_simI2s[base - g_simI2s];
+}
+
+void usb_echo(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (!s_simEcho)
+    {
+        return;
+    }
+
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+void SIM_SetEcho(int enable)
+{
+    s_simEcho = enable;
+}
+
+const sim_stats_t *SIM_GetStats(void)
+{
+    return &s_simStats;
+}
+
+/* DWT */
+
+DWT_Type *SIM_Dwt(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    s_simDwt.CYCCNT = (uint32_t)((ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+
+    return &s_simDwt;
+}
+
+/* Audio PLL */
+
+void BOARD_SetAudioPllRate(uint32_t sampleRate)
+{
+    double lsb = ((sampleRate % 8000U) == 0U) ? SIM_AUDIO_PLL_LSB_48K : SIM_AUDIO_PLL_LSB_44K1;
+
+    /* Relocking on the other family clears the trim */
+    if (lsb != s_simAudioPllLsb)
+    {
+        s_simAudioPllLsb = lsb;
+        s_simAudioPllTrim = 0;
+    }
+}
+
+void BOARD_TrimAudioPll(int32_t trim)
+{
+    s_simAudioPllTrim = trim;
+}
+
+double SIM_AudioPllOffset(void)
+{
+    return s_simAudioPllTrim / s_simAudioPllLsb;
+}
+
+/* CTIMER */
+
+void CTIMER_GetDefaultConfig(ctimer_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+}
+
+void CTIMER_Init(CTIMER_Type *base, const ctimer_config_t *config)
+{
+    (void)config;
+
+    memset(base, 0, sizeof(*base));
+}
+
+void CTIMER_SetupMatch(CTIMER_Type *base, ctimer_match_t matchChannel, const ctimer_match_config_t *config)
+{
+    /* Reset and interrupt on match 0 is all we model */
+    assert((matchChannel == kCTIMER_Match_0) && config->enableCounterReset && config->enableInterrupt);
+
+    base->MR[matchChannel] = config->matchValue;
+}
+
+void CTIMER_RegisterCallBack(CTIMER_Type *base, ctimer_callback_t *cb_func, ctimer_callback_type_t cb_type)
+{
+    (void)base;
+    (void)cb_type;
+
+    s_simCtimerCallback = cb_func[0];
+}
+
+void CTIMER_StartTimer(CTIMER_Type *base)
+{
+    base->TCR = 1U;
+}
+
+void CTIMER_StopTimer(CTIMER_Type *base)
+{
+    base->TCR = 0U;
+}
+
+void CTIMER_Reset(CTIMER_Type *base)
+{
+    base->TC = 0U;
+}
+
+void SIM_CtimerTick(uint32_t cycles)
+{
+    if (g_simCtimer0.TCR == 0U)
+    {
+        return;
+    }
+
+    g_simCtimer0.TC += cycles;
+
+    /* The counter goes back to 0 on the cycle after the match */
+    while (g_simCtimer0.TC > g_simCtimer0.MR[0])
+    {
+        g_simCtimer0.TC -= g_simCtimer0.MR[0] + 1U;
+
+        if (s_simCtimerCallback != NULL)
+        {
+            s_simCtimerCallback(1U);
+        }
+    }
+}
+
+/* USB */
+
+usb_status_t USB_DeviceClassGetCurrentFrameCount(uint8_t controllerId, uint32_t *currentFrameCount)
+{
+    (void)controllerId;
+
+    /* HS: 11-bit frame number and 3-bit microframe number */
+    *currentFrameCount = s_simSofCount & 0x3FFFU;
+
+    return kStatus_USB_Success;
+}
+
+void SIM_UsbSof(void)
+{
+    s_simSofCount++;
+}
+
+/**
+ * SLVFRMERR is write-one-to-clear on the hardware. The completion callbacks are
+ * the only place checking (and clearing) it so we emulate the W1C by dropping
+ * it once the callback had a chance to look at it.
+ */
+static void SIM_I2sAckFrameError(bool rx)
+{
+    for (size_t i = 0; i < SIM_I2S_INST_COUNT; i++)
+    {
+        if (s_simI2s[i].role == (rx ? SIM_I2S_ROLE_RX : SIM_I2S_ROLE_TX))
+        {
+            g_simI2s[i].STAT &= ~I2S_STAT_SLVFRMERR_MASK;
+        }
+    }
+}
+
+/* DMA */
+
+/**
+ * Only the descriptor chain engine is modelled: one descriptor at a time is
+ * active on each channel, RELOAD moves to the linked descriptor and SETINTA /
+ * SETINTB call back into the handle when the descriptor is exhausted.
+ */
+typedef struct
+{
+    dma_handle_t *handle;
+    dma_descriptor_t desc;
+    uint32_t index;
+    uint32_t generation;
+    bool active;
+} sim_dma_channel_t;
+
+static sim_dma_channel_t s_simDma[FSL_FEATURE_DMA_NUMBER_OF_CHANNELS];
+
+#define SIM_DMA_WIDTH(cfg) (1U << (((cfg) >> 8U) & 0x3U))
+#define SIM_DMA_INC(v) ((v) == 3U ? 4U : (v))
+#define SIM_DMA_SRCINC(cfg) SIM_DMA_INC(((cfg) >> 12U) & 0x3U)
+#define SIM_DMA_DSTINC(cfg) SIM_DMA_INC(((cfg) >> 14U) & 0x3U)
+#define SIM_DMA_COUNT(cfg) ((((cfg) >> 16U) & 0x3FFU) + 1U)
+
+void DMA_Init(DMA_Type *base)
+{
+    (void)base;
+}
+
+void DMA_EnableChannel(DMA_Type *base, uint32_t channel)
+{
+    (void)base;
+    (void)channel;
+}
+
+void DMA_SetChannelPriority(DMA_Type *base, uint32_t channel, dma_priority_t priority)
+{
+    (void)base;
+    (void)channel;
+    (void)priority;
+}
+
+void DMA_EnableChannelPeriphRq(DMA_Type *base, uint32_t channel)
+{
+    (void)base;
+    (void)channel;
+}
+
+void DMA_CreateHandle(dma_handle_t *handle, DMA_Type *base, uint32_t channel)
+{
+    memset(handle, 0, sizeof(*handle));
+
+    handle->base = base;
+    handle->channel = channel;
+
+    s_simDma[channel].handle = handle;
+}
+
+void DMA_SetCallback(dma_handle_t *handle, dma_callback callback, void *userData)
+{
+    handle->callback = callback;
+    handle->userData = userData;
+}
+
+void DMA_SetupDescriptor(
+    dma_descriptor_t *desc, uint32_t xfercfg, void *srcStartAddr, void *dstStartAddr, void *nextDesc)
+{
+    uint32_t width = SIM_DMA_WIDTH(xfercfg);
+    uint32_t count = SIM_DMA_COUNT(xfercfg);
+
+    assert(((uintptr_t)nextDesc % FSL_FEATURE_DMA_LINK_DESCRIPTOR_ALIGN_SIZE) == 0U);
+
+    /* Like the hardware, the descriptor holds the end addresses */
+    desc->xfercfg = xfercfg;
+    desc->srcEndAddr = (uint8_t *)srcStartAddr + ((count - 1U) * width * SIM_DMA_SRCINC(xfercfg));
+    desc->dstEndAddr = (uint8_t *)dstStartAddr + ((count - 1U) * width * SIM_DMA_DSTINC(xfercfg));
+    desc->linkToNextDesc = nextDesc;
+}
+
+void DMA_SubmitChannelDescriptor(dma_handle_t *handle, dma_descriptor_t *descriptor)
+{
+    sim_dma_channel_t *ch = &s_simDma[handle->channel];
+
+    ch->desc = *descriptor;
+    ch->index = 0;
+    ch->active = false;
+    ch->generation++;
+}
+
+void DMA_StartTransfer(dma_handle_t *handle)
+{
+    s_simDma[handle->channel].active = true;
+}
+
+void DMA_AbortTransfer(dma_handle_t *handle)
+{
+    sim_dma_channel_t *ch = &s_simDma[handle->channel];
+
+    ch->active = false;
+    ch->generation++;
+}
+
+/**
+ * Move data between a FIFO (the slice of the frame handled by one I2S
+ * instance) and memory through the descriptor chain of a channel.
+ */
+static bool SIM_DmaMove(uint32_t channel, uint8_t *fifo, uint32_t len, bool rx)
+{
+    sim_dma_channel_t *ch = &s_simDma[channel];
+    uint32_t generation = ch->generation;
+
+    for (uint32_t off = 0; off < len;)
+    {
+        uint32_t cfg = ch->desc.xfercfg;
+        uint32_t width = SIM_DMA_WIDTH(cfg);
+        uint32_t count = SIM_DMA_COUNT(cfg);
+        uint8_t *src;
+        uint8_t *dst;
+
+        if (!ch->active)
+        {
+            if (!rx)
+            {
+                bzero(fifo + off, len - off);
+            }
+            return false;
+        }
+
+        src = (uint8_t *)ch->desc.srcEndAddr - ((count - 1U - ch->index) * width * SIM_DMA_SRCINC(cfg));
+        dst = (uint8_t *)ch->desc.dstEndAddr - ((count - 1U - ch->index) * width * SIM_DMA_DSTINC(cfg));
+
+        /* The peripheral side is the FIFO register (no increment) */
+        if (rx)
+        {
+            memcpy(dst, fifo + off, width);
+        }
+        else
+        {
+            memcpy(fifo + off, src, width);
+        }
+
+        off += width;
+
+        if (++ch->index < count)
+        {
+            continue;
+        }
+
+        ch->index = 0;
+
+        if (cfg & DMA_CHANNEL_XFERCFG_RELOAD(1))
+        {
+            ch->desc = *(dma_descriptor_t *)ch->desc.linkToNextDesc;
+        }
+        else
+        {
+            ch->active = false;
+        }
+
+        if ((cfg & (DMA_CHANNEL_XFERCFG_SETINTA(1) | DMA_CHANNEL_XFERCFG_SETINTB(1))) && (ch->handle->callback != NULL))
+        {
+            if (rx)
+            {
+                s_simStats.rxCallbacks++;
+            }
+            else
+            {
+                s_simStats.txCallbacks++;
+            }
+
+            ch->handle->callback(ch->handle, ch->handle->userData, true,
+                                 (cfg & DMA_CHANNEL_XFERCFG_SETINTA(1)) ? kDMA_IntA : kDMA_IntB);
+            SIM_I2sAckFrameError(rx);
+
+            /* Aborted / restarted from the callback: drop the rest of the frame */
+            if (generation != ch->generation)
+            {
+                return true;
+            }
+        }
+    }
+
+    return true;
+}
+
+/* I2S */
+
+static void I2S_GetDefaultConfig(i2s_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+
+    config->masterSlave = kI2S_MasterSlaveNormalSlave;
+    config->mode = kI2S_ModeI2sClassic;
+    config->divider = 1;
+    config->dataLength = 16;
+    config->frameLength = 32;
+    config->watermark = 4;
+}
+
+void I2S_TxGetDefaultConfig(i2s_config_t *config)
+{
+    I2S_GetDefaultConfig(config);
+    config->txEmptyZero = true;
+}
+
+void I2S_RxGetDefaultConfig(i2s_config_t *config)
+{
+    I2S_GetDefaultConfig(config);
+}
+
+static void I2S_Init(I2S_Type *base, const i2s_config_t *config, uint8_t role)
+{
+    sim_i2s_inst_t *inst = SIM_I2sInst(base);
+
+    assert(config->position % 8U == 0U);
+
+    inst->role = role;
+    inst->pairNum = 1;
+    inst->pairLen = (config->dataLength / 8U) * (config->oneChannel ? 1U : 2U);
+    inst->pairPos[0] = config->position / 8U;
+
+    base->STAT = 0;
+}
+
+void I2S_TxInit(I2S_Type *base, const i2s_config_t *config)
+{
+    I2S_Init(base, config, SIM_I2S_ROLE_TX);
+}
+
+void I2S_RxInit(I2S_Type *base, const i2s_config_t *config)
+{
+    I2S_Init(base, config, SIM_I2S_ROLE_RX);
+}
+
+void I2S_EnableSecondaryChannel(I2S_Type *base, uint32_t channel, bool oneChannel, uint32_t position)
+{
+    sim_i2s_inst_t *inst = SIM_I2sInst(base);
+
+    assert(channel < (SIM_I2S_PAIR_NUM - 1U));
+    assert(position % 8U == 0U);
+    (void)oneChannel;
+
+    inst->pairPos[channel + 1U] = position / 8U;
+    if (inst->pairNum < channel + 2U)
+    {
+        inst->pairNum = channel + 2U;
+    }
+}
+
+/* I2S DMA */
+
+static void I2S_TransferCreateHandleDMA(I2S_Type *base,
+                                        i2s_dma_handle_t *handle,
+                                        dma_handle_t *dmaHandle,
+                                        i2s_dma_transfer_callback_t callback,
+                                        void *userData)
+{
+    memset(handle, 0, sizeof(*handle));
+
+    handle->dmaHandle = dmaHandle;
+    handle->completionCallback = callback;
+    handle->userData = userData;
+
+    SIM_I2sInst(base)->handle = handle;
+}
+
+void I2S_TxTransferCreateHandleDMA(I2S_Type *base,
+                                   i2s_dma_handle_t *handle,
+                                   dma_handle_t *dmaHandle,
+                                   i2s_dma_transfer_callback_t callback,
+                                   void *userData)
+{
+    I2S_TransferCreateHandleDMA(base, handle, dmaHandle, callback, userData);
+}
+
+void I2S_RxTransferCreateHandleDMA(I2S_Type *base,
+                                   i2s_dma_handle_t *handle,
+                                   dma_handle_t *dmaHandle,
+                                   i2s_dma_transfer_callback_t callback,
+                                   void *userData)
+{
+    I2S_TransferCreateHandleDMA(base, handle, dmaHandle, callback, userData);
+}
+
+static status_t I2S_TransferQueueDMA(i2s_dma_handle_t *handle, i2s_transfer_t transfer)
+{
+    if (handle->i2sQueue[handle->queueUser].data != NULL)
+    {
+        return kStatus_I2S_Busy;
+    }
+
+    handle->i2sQueue[handle->queueUser].data = transfer.data;
+    handle->i2sQueue[handle->queueUser].dataSize = transfer.dataSize;
+    handle->queueUser = (handle->queueUser + 1U) % I2S_NUM_BUFFERS;
+
+    return kStatus_Success;
+}
+
+status_t I2S_TxTransferSendDMA(I2S_Type *base, i2s_dma_handle_t *handle, i2s_transfer_t transfer)
+{
+    (void)base;
+
+    return I2S_TransferQueueDMA(handle, transfer);
+}
+
+status_t I2S_RxTransferReceiveDMA(I2S_Type *base, i2s_dma_handle_t *handle, i2s_transfer_t transfer)
+{
+    (void)base;
+
+    return I2S_TransferQueueDMA(handle, transfer);
+}
+
+void I2S_TransferAbortDMA(I2S_Type *base, i2s_dma_handle_t *handle)
+{
+    (void)base;
+
+    for (size_t i = 0; i < I2S_NUM_BUFFERS; i++)
+    {
+        handle->i2sQueue[i].data = NULL;
+        handle->i2sQueue[i].dataSize = 0;
+    }
+
+    handle->queueUser = 0;
+    handle->queueDriver = 0;
+    handle->offset = 0;
+}
+
+/**
+ * Move one frame slice between the wire and the FIFO served by a DMA channel
+ * programmed directly (no fsl_i2s_dma handle). FLEXCOMM n is using DMA channel
+ * 2n for RX and 2n + 1 for TX.
+ */
+static bool SIM_I2sMoveFrameDma(I2S_Type *base, uint8_t *wire, bool rx)
+{
+    sim_i2s_inst_t *inst = SIM_I2sInst(base);
+    uint32_t channel = ((base - g_simI2s) * 2U) + (rx ? 0U : 1U);
+    uint8_t fifo[SIM_WIRE_FRAME_MAX];
+    uint32_t len = 0;
+    bool ret;
+
+    if (rx)
+    {
+        for (size_t p = 0; p < inst->pairNum; p++)
+        {
+            memcpy(fifo + len, wire + inst->pairPos[p], inst->pairLen);
+            len += inst->pairLen;
+        }
+
+        return SIM_DmaMove(channel, fifo, len, true);
+    }
+
+    len = inst->pairNum * inst->pairLen;
+    ret = SIM_DmaMove(channel, fifo, len, false);
+
+    len = 0;
+    for (size_t p = 0; p < inst->pairNum; p++)
+    {
+        memcpy(wire + inst->pairPos[p], fifo + len, inst->pairLen);
+        len += inst->pairLen;
+    }
+
+    return ret;
+}
+
+/**
+ * Move one frame slice between the wire and the transfer at the head of the
+ * queue. Returns false when no transfer is queued (the frame is lost).
+ */
+static bool SIM_I2sMoveFrame(I2S_Type *base, uint8_t *wire, bool rx)
+{
+    sim_i2s_inst_t *inst = SIM_I2sInst(base);
+    i2s_dma_handle_t *handle = inst->handle;
+    volatile i2s_transfer_t *xfer;
+    status_t status = kStatus_I2S_BufferComplete;
+
+    if ((handle == NULL) && (base->FIFOCFG & (rx ? I2S_FIFOCFG_DMARX_MASK : I2S_FIFOCFG_DMATX_MASK)))
+    {
+        return SIM_I2sMoveFrameDma(base, wire, rx);
+    }
+
+    if ((handle == NULL) || (handle->i2sQueue[handle->queueDriver].data == NULL))
+    {
+        if (!rx)
+        {
+            for (size_t p = 0; p < inst->pairNum; p++)
+            {
+                bzero(wire + inst->pairPos[p], inst->pairLen);
+            }
+        }
+
+        return false;
+    }
+
+    xfer = &handle->i2sQueue[handle->queueDriver];
+
+    for (size_t p = 0; p < inst->pairNum; p++)
+    {
+        if (rx)
+        {
+            memcpy(xfer->data + handle->offset, wire + inst->pairPos[p], inst->pairLen);
+        }
+        else
+        {
+            memcpy(wire + inst->pairPos[p], xfer->data + handle->offset, inst->pairLen);
+        }
+
+        handle->offset += inst->pairLen;
+    }
+
+    if (handle->offset < xfer->dataSize)
+    {
+        return true;
+    }
+
+    /* Transfer done: release the slot before calling back, as the driver does */
+    xfer->data = NULL;
+    xfer->dataSize = 0;
+    handle->queueDriver = (handle->queueDriver + 1U) % I2S_NUM_BUFFERS;
+    handle->offset = 0;
+
+    if (handle->completionCallback != NULL)
+    {
+        if (rx)
+        {
+            s_simStats.rxCallbacks++;
+        }
+        else
+        {
+            s_simStats.txCallbacks++;
+        }
+
+        handle->completionCallback(base, handle, status, handle->userData);
+        SIM_I2sAckFrameError(rx);
+    }
+
+    return true;
+}
+
+void SIM_I2sRxFrame(const uint8_t *frame)
+{
+    uint8_t wire[SIM_WIRE_FRAME_MAX];
+    bool starved = false;
+
+    memcpy(wire, frame, sizeof(wire));
+
+    for (size_t i = 0; i < SIM_I2S_INST_COUNT; i++)
+    {
+        if (s_simI2s[i].role == SIM_I2S_ROLE_RX)
+        {
+            starved |= !SIM_I2sMoveFrame(&g_simI2s[i], wire, true);
+        }
+    }
+
+    if (starved)
+    {
+        s_simStats.rxStarved++;
+    }
+}
+
+void SIM_I2sTxFrame(uint8_t *frame)
+{
+    bool starved = false;
+
+    for (size_t i = 0; i < SIM_I2S_INST_COUNT; i++)
+    {
+        if (s_simI2s[i].role == SIM_I2S_ROLE_TX)
+        {
+            starved |= !SIM_I2sMoveFrame(&g_simI2s[i], frame, false);
+        }
+    }
+
+    if (starved)
+    {
+        s_simStats.txStarved++;
+    }
+}
+
+void SIM_I2sRxFrameError(void)
+{
+    for (size_t i = 0; i < SIM_I2S_INST_COUNT; i++)
+    {
+        if (s_simI2s[i].role == SIM_I2S_ROLE_RX)
+        {
+            g_simI2s[i].STAT |= I2S_STAT_SLVFRMERR(1);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FREERTOS_H__
+#define __SIM_FREERTOS_H__ 1
+
+/**
+ * Host stub for FreeRTOS. Only the types referenced by tdm2usb.h are provided.
+ */
+
+#include <stdint.h>
+
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#endif /* __SIM_FREERTOS_H__ */
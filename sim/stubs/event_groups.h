@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_EVENT_GROUPS_H__
+#define __SIM_EVENT_GROUPS_H__ 1
+
+typedef void *EventGroupHandle_t;
+
+#endif /* __SIM_EVENT_GROUPS_H__ */
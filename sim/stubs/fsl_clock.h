@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_CLOCK_H__
+#define __SIM_FSL_CLOCK_H__ 1
+
+/**
+ * Host stub for the clock driver. The simulation has a single virtual I2S
+ * clock, whatever the FLEXCOMMs and CTIMER0 are attached to.
+ */
+
+typedef enum _clock_attach_id
+{
+    kAUDIO_PLL_to_FLEXCOMM5 = 0x0,
+    kAUDIO_PLL_to_CTIMER0 = 0x1,
+} clock_attach_id_t;
+
+static inline void CLOCK_AttachClk(clock_attach_id_t connection)
+{
+    (void)connection;
+}
+
+#endif /* __SIM_FSL_CLOCK_H__ */
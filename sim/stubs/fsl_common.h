@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_COMMON_H__
+#define __SIM_FSL_COMMON_H__ 1
+
+/**
+ * Host stub for the MCUXpresso SDK common header.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "fsl_clock.h"
+
+typedef int32_t status_t;
+
+#define SDK_ALIGN(var, alignbytes) var __attribute__((aligned(alignbytes)))
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define MAKE_STATUS(group, code) ((((group)*100) + (code)))
+
+enum
+{
+    kStatus_Success = MAKE_STATUS(0, 0),
+    kStatus_Fail = MAKE_STATUS(0, 1),
+};
+
+/* Single threaded host, nothing to mask */
+static inline uint32_t DisableGlobalIRQ(void)
+{
+    return 0U;
+}
+
+static inline void EnableGlobalIRQ(uint32_t primask)
+{
+    (void)primask;
+}
+
+#endif /* __SIM_FSL_COMMON_H__ */
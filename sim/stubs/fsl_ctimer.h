@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_CTIMER_H__
+#define __SIM_FSL_CTIMER_H__ 1
+
+/**
+ * Host stub for the CTIMER driver. Only CTIMER0 exists, counting the virtual
+ * Audio PLL clock (see SIM_CtimerTick()), with match 0 resetting the counter
+ * and calling the single callback.
+ */
+
+#include "fsl_common.h"
+#include "fsl_device_registers.h"
+
+typedef void (*ctimer_callback_t)(uint32_t flags);
+
+typedef enum _ctimer_callback_type
+{
+    kCTIMER_SingleCallback = 0x0,
+    kCTIMER_MultipleCallback = 0x1,
+} ctimer_callback_type_t;
+
+typedef enum _ctimer_match
+{
+    kCTIMER_Match_0 = 0x0,
+    kCTIMER_Match_1 = 0x1,
+    kCTIMER_Match_2 = 0x2,
+    kCTIMER_Match_3 = 0x3,
+} ctimer_match_t;
+
+typedef enum _ctimer_match_output_control
+{
+    kCTIMER_Output_NoAction = 0x0,
+    kCTIMER_Output_Clear = 0x1,
+    kCTIMER_Output_Set = 0x2,
+    kCTIMER_Output_Toggle = 0x3,
+} ctimer_match_output_control_t;
+
+typedef struct _ctimer_config
+{
+    uint32_t mode;
+    uint32_t input;
+    uint32_t prescale;
+} ctimer_config_t;
+
+typedef struct _ctimer_match_config
+{
+    uint32_t matchValue;
+    bool enableCounterReset;
+    bool enableCounterStop;
+    ctimer_match_output_control_t outControl;
+    bool outPinInitState;
+    bool enableInterrupt;
+} ctimer_match_config_t;
+
+void CTIMER_GetDefaultConfig(ctimer_config_t *config);
+void CTIMER_Init(CTIMER_Type *base, const ctimer_config_t *config);
+void CTIMER_SetupMatch(CTIMER_Type *base, ctimer_match_t matchChannel, const ctimer_match_config_t *config);
+void CTIMER_RegisterCallBack(CTIMER_Type *base, ctimer_callback_t *cb_func, ctimer_callback_type_t cb_type);
+void CTIMER_StartTimer(CTIMER_Type *base);
+void CTIMER_StopTimer(CTIMER_Type *base);
+void CTIMER_Reset(CTIMER_Type *base);
+
+#endif /* __SIM_FSL_CTIMER_H__ */
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_DEVICE_REGISTERS_H__
+#define __SIM_FSL_DEVICE_REGISTERS_H__ 1
+
+/**
+ * Host stub for the RT685 register definitions. The FLEXCOMM I2S and DMA
+ * peripherals are plain structures living in host memory, the simulation
+ * shims know how to decode them back into an instance index.
+ */
+
+#include "fsl_common.h"
+
+/* CMSIS forced inlining */
+#define __STATIC_FORCEINLINE __attribute__((always_inline)) static inline
+
+/* CMSIS data memory barrier */
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/* CMSIS exclusive accesses, the host is single threaded */
+static inline uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    return *addr;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    *addr = value;
+    return 0U;
+}
+
+/* CMSIS count leading zeros */
+#define __CLZ(x) ((uint8_t)__builtin_clz(x))
+
+/* Always in thread mode, the simulation has no exceptions */
+static inline uint32_t __get_IPSR(void)
+{
+    return 0U;
+}
+
+/**
+ * DWT cycle counter: every read of DWT returns the host monotonic clock in
+ * nanoseconds, so the profiler figures are host nanoseconds, not cycles.
+ */
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+DWT_Type *SIM_Dwt(void);
+
+#define DWT (SIM_Dwt())
+
+/* The rate of the DWT stub */
+extern uint32_t SystemCoreClock;
+
+typedef struct
+{
+    volatile uint32_t CFG1;
+    volatile uint32_t CFG2;
+    volatile uint32_t STAT;
+    volatile uint32_t DIV;
+    volatile uint32_t FIFOCFG;
+    volatile uint32_t FIFOSTAT;
+    volatile uint32_t FIFOWR;
+    volatile uint32_t FIFORD;
+} I2S_Type;
+
+#define I2S_FIFOCFG_ENABLETX_MASK (0x1U)
+#define I2S_FIFOCFG_ENABLERX_MASK (0x2U)
+#define I2S_FIFOCFG_DMATX_MASK (0x1000U)
+#define I2S_FIFOCFG_DMARX_MASK (0x2000U)
+#define I2S_FIFOCFG_EMPTYTX_MASK (0x10000U)
+#define I2S_FIFOCFG_EMPTYRX_MASK (0x20000U)
+
+#define I2S_CFG1_MAINENABLE_MASK (0x1U)
+
+#define I2S_DIV_DIV_MASK (0xFFFU)
+#define I2S_DIV_DIV(x) (((uint32_t)(x)) & I2S_DIV_DIV_MASK)
+
+#define I2S_STAT_SLVFRMERR_MASK (0x2U)
+#define I2S_STAT_SLVFRMERR_SHIFT (1U)
+#define I2S_STAT_SLVFRMERR(x) (((uint32_t)(((uint32_t)(x)) << I2S_STAT_SLVFRMERR_SHIFT)) & I2S_STAT_SLVFRMERR_MASK)
+
+#define SIM_I2S_INST_COUNT (8U)
+
+extern I2S_Type g_simI2s[SIM_I2S_INST_COUNT];
+
+#define I2S0 (&g_simI2s[0])
+#define I2S1 (&g_simI2s[1])
+#define I2S2 (&g_simI2s[2])
+#define I2S3 (&g_simI2s[3])
+#define I2S4 (&g_simI2s[4])
+#define I2S5 (&g_simI2s[5])
+#define I2S6 (&g_simI2s[6])
+#define I2S7 (&g_simI2s[7])
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+} DMA_Type;
+
+extern DMA_Type g_simDma0;
+
+#define DMA0 (&g_simDma0)
+
+#define FSL_FEATURE_DMA_NUMBER_OF_CHANNELS (33U)
+#define FSL_FEATURE_DMA_LINK_DESCRIPTOR_ALIGN_SIZE (16U)
+
+typedef struct
+{
+    volatile uint32_t TCR;
+    volatile uint32_t TC;
+    volatile uint32_t MCR;
+    volatile uint32_t MR[4];
+} CTIMER_Type;
+
+extern CTIMER_Type g_simCtimer0;
+
+#define CTIMER0 (&g_simCtimer0)
+
+typedef enum
+{
+    DMA0_IRQn = 1,
+    CTIMER0_IRQn = 10,
+    USB0_IRQn = 50,
+} IRQn_Type;
+
+static inline void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void)IRQn;
+    (void)priority;
+}
+
+#endif /* __SIM_FSL_DEVICE_REGISTERS_H__ */
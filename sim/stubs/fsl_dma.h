@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_DMA_H__
+#define __SIM_FSL_DMA_H__ 1
+
+/**
+ * Host stub for the LPC DMA driver.
+ */
+
+#include "fsl_device_registers.h"
+
+typedef enum _dma_priority
+{
+    kDMA_ChannelPriority0 = 0,
+    kDMA_ChannelPriority1,
+    kDMA_ChannelPriority2,
+    kDMA_ChannelPriority3,
+    kDMA_ChannelPriority4,
+    kDMA_ChannelPriority5,
+    kDMA_ChannelPriority6,
+    kDMA_ChannelPriority7,
+} dma_priority_t;
+
+typedef enum _dma_int
+{
+    kDMA_IntA = 0U,
+    kDMA_IntB,
+    kDMA_IntError,
+} dma_irq_t;
+
+typedef struct _dma_descriptor
+{
+    volatile uint32_t xfercfg;
+    void *srcEndAddr;
+    void *dstEndAddr;
+    void *linkToNextDesc;
+} dma_descriptor_t;
+
+#define DMA_CHANNEL_XFERCFG_CFGVALID_MASK (0x1U)
+#define DMA_CHANNEL_XFERCFG_RELOAD(x) (((uint32_t)(x) << 1U) & 0x2U)
+#define DMA_CHANNEL_XFERCFG_CLRTRIG(x) (((uint32_t)(x) << 3U) & 0x8U)
+#define DMA_CHANNEL_XFERCFG_SETINTA(x) (((uint32_t)(x) << 4U) & 0x10U)
+#define DMA_CHANNEL_XFERCFG_SETINTB(x) (((uint32_t)(x) << 5U) & 0x20U)
+#define DMA_CHANNEL_XFERCFG_WIDTH(x) (((uint32_t)(x) << 8U) & 0x300U)
+#define DMA_CHANNEL_XFERCFG_SRCINC(x) (((uint32_t)(x) << 12U) & 0x3000U)
+#define DMA_CHANNEL_XFERCFG_DSTINC(x) (((uint32_t)(x) << 14U) & 0xC000U)
+#define DMA_CHANNEL_XFERCFG_XFERCOUNT(x) (((uint32_t)(x) << 16U) & 0x3FF0000U)
+
+#define DMA_CHANNEL_XFER(reload, clrTrig, intA, intB, width, srcInc, dstInc, bytes)                                 \
+    DMA_CHANNEL_XFERCFG_CFGVALID_MASK | DMA_CHANNEL_XFERCFG_RELOAD(reload) | DMA_CHANNEL_XFERCFG_CLRTRIG(clrTrig) | \
+        DMA_CHANNEL_XFERCFG_SETINTA(intA) | DMA_CHANNEL_XFERCFG_SETINTB(intB) |                                     \
+        DMA_CHANNEL_XFERCFG_WIDTH((width) == 4U ? 2U : ((width) - 1U)) |                                            \
+        DMA_CHANNEL_XFERCFG_SRCINC((srcInc) == 4U ? ((srcInc) - 1U) : (srcInc)) |                                   \
+        DMA_CHANNEL_XFERCFG_DSTINC((dstInc) == 4U ? ((dstInc) - 1U) : (dstInc)) |                                   \
+        DMA_CHANNEL_XFERCFG_XFERCOUNT((bytes) / (width) - 1U)
+
+struct _dma_handle;
+
+typedef void (*dma_callback)(struct _dma_handle *handle, void *userData, bool transferDone, uint32_t intmode);
+
+typedef struct _dma_handle
+{
+    dma_callback callback;
+    void *userData;
+    DMA_Type *base;
+    uint32_t channel;
+} dma_handle_t;
+
+#define DMA_ALLOCATE_LINK_DESCRIPTORS(name, number) \
+    SDK_ALIGN(dma_descriptor_t name[number], FSL_FEATURE_DMA_LINK_DESCRIPTOR_ALIGN_SIZE)
+
+void DMA_Init(DMA_Type *base);
+void DMA_EnableChannel(DMA_Type *base, uint32_t channel);
+void DMA_SetChannelPriority(DMA_Type *base, uint32_t channel, dma_priority_t priority);
+void DMA_CreateHandle(dma_handle_t *handle, DMA_Type *base, uint32_t channel);
+void DMA_EnableChannelPeriphRq(DMA_Type *base, uint32_t channel);
+void DMA_SetCallback(dma_handle_t *handle, dma_callback callback, void *userData);
+void DMA_SetupDescriptor(
+    dma_descriptor_t *desc, uint32_t xfercfg, void *srcStartAddr, void *dstStartAddr, void *nextDesc);
+void DMA_SubmitChannelDescriptor(dma_handle_t *handle, dma_descriptor_t *descriptor);
+void DMA_StartTransfer(dma_handle_t *handle);
+void DMA_AbortTransfer(dma_handle_t *handle);
+
+#endif /* __SIM_FSL_DMA_H__ */
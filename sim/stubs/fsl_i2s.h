@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_I2S_H__
+#define __SIM_FSL_I2S_H__ 1
+
+/**
+ * Host stub for the FLEXCOMM I2S driver.
+ */
+
+#include "fsl_device_registers.h"
+
+enum
+{
+    kStatus_I2S_BufferComplete = MAKE_STATUS(65, 0),
+    kStatus_I2S_Done = MAKE_STATUS(65, 1),
+    kStatus_I2S_Busy = MAKE_STATUS(65, 2),
+};
+
+typedef enum _i2s_master_slave
+{
+    kI2S_MasterSlaveNormalSlave = 0x0,
+    kI2S_MasterSlaveWsSyncMaster = 0x1,
+    kI2S_MasterSlaveExtSckMaster = 0x2,
+    kI2S_MasterSlaveNormalMaster = 0x3,
+} i2s_master_slave_t;
+
+typedef enum _i2s_mode
+{
+    kI2S_ModeI2sClassic = 0x0,
+    kI2S_ModeDspWs50 = 0x1,
+    kI2S_ModeDspWsShort = 0x2,
+    kI2S_ModeDspWsLong = 0x3,
+} i2s_mode_t;
+
+typedef enum _i2s_secondary_channel
+{
+    kI2S_SecondaryChannel1 = 0U,
+    kI2S_SecondaryChannel2 = 1U,
+    kI2S_SecondaryChannel3 = 2U,
+} i2s_secondary_channel_t;
+
+typedef struct _i2s_config
+{
+    i2s_master_slave_t masterSlave;
+    i2s_mode_t mode;
+    bool rightLow;
+    bool leftJust;
+    bool pdmData;
+    bool sckPol;
+    bool wsPol;
+    uint16_t divider;
+    bool oneChannel;
+    uint8_t dataLength;
+    uint16_t frameLength;
+    uint16_t position;
+    uint8_t watermark;
+    bool txEmptyZero;
+    bool pack48;
+} i2s_config_t;
+
+typedef struct _i2s_transfer
+{
+    uint8_t *data;
+    size_t dataSize;
+} i2s_transfer_t;
+
+void I2S_TxGetDefaultConfig(i2s_config_t *config);
+void I2S_RxGetDefaultConfig(i2s_config_t *config);
+void I2S_TxInit(I2S_Type *base, const i2s_config_t *config);
+void I2S_RxInit(I2S_Type *base, const i2s_config_t *config);
+void I2S_EnableSecondaryChannel(I2S_Type *base, uint32_t channel, bool oneChannel, uint32_t position);
+
+static inline void I2S_Enable(I2S_Type *base)
+{
+    base->CFG1 |= I2S_CFG1_MAINENABLE_MASK;
+}
+
+static inline void I2S_Disable(I2S_Type *base)
+{
+    base->CFG1 &= ~I2S_CFG1_MAINENABLE_MASK;
+}
+
+static inline void I2S_TxEnableDMA(I2S_Type *base, bool enable)
+{
+    if (enable)
+    {
+        base->FIFOCFG |= I2S_FIFOCFG_DMATX_MASK;
+    }
+    else
+    {
+        base->FIFOCFG &= ~I2S_FIFOCFG_DMATX_MASK;
+        base->FIFOCFG |= I2S_FIFOCFG_EMPTYTX_MASK;
+    }
+}
+
+static inline void I2S_RxEnableDMA(I2S_Type *base, bool enable)
+{
+    if (enable)
+    {
+        base->FIFOCFG |= I2S_FIFOCFG_DMARX_MASK;
+    }
+    else
+    {
+        base->FIFOCFG &= ~I2S_FIFOCFG_DMARX_MASK;
+        base->FIFOCFG |= I2S_FIFOCFG_EMPTYRX_MASK;
+    }
+}
+
+#endif /* __SIM_FSL_I2S_H__ */
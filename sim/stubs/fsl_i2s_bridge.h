@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_I2S_BRIDGE_H__
+#define __SIM_FSL_I2S_BRIDGE_H__ 1
+
+/**
+ * Host stub for the I2S bridge driver. Signal sharing has no meaning in the
+ * simulation, all the instances see the same virtual I2S clock.
+ */
+
+#include "fsl_common.h"
+
+typedef enum _i2s_bridge_share_set
+{
+    kI2S_BRIDGE_ShareSet0 = 0x0,
+    kI2S_BRIDGE_ShareSet1 = 0x1,
+    kI2S_BRIDGE_ShareSet2 = 0x2,
+} i2s_bridge_share_set_t;
+
+typedef enum _i2s_bridge_signal
+{
+    kI2S_BRIDGE_SignalSCK = 0x0,
+    kI2S_BRIDGE_SignalWS = 0x1,
+    kI2S_BRIDGE_SignalDataIn = 0x2,
+    kI2S_BRIDGE_SignalDataOut = 0x3,
+} i2s_bridge_signal_t;
+
+typedef enum _i2s_bridge_share_src
+{
+    kI2S_BRIDGE_Flexcomm0 = 0x0,
+    kI2S_BRIDGE_Flexcomm1 = 0x1,
+    kI2S_BRIDGE_Flexcomm2 = 0x2,
+    kI2S_BRIDGE_Flexcomm3 = 0x3,
+    kI2S_BRIDGE_Flexcomm4 = 0x4,
+    kI2S_BRIDGE_Flexcomm5 = 0x5,
+    kI2S_BRIDGE_Flexcomm6 = 0x6,
+    kI2S_BRIDGE_Flexcomm7 = 0x7,
+} i2s_bridge_share_src_t;
+
+static inline void I2S_BRIDGE_SetShareSignalSrc(uint32_t setIndex, uint32_t sharedSignal, uint32_t signalSrc)
+{
+    (void)setIndex;
+    (void)sharedSignal;
+    (void)signalSrc;
+}
+
+static inline void I2S_BRIDGE_SetFlexcommSignalShareSet(uint32_t flexCommIndex, uint32_t signal, uint32_t set)
+{
+    (void)flexCommIndex;
+    (void)signal;
+    (void)set;
+}
+
+#endif /* __SIM_FSL_I2S_BRIDGE_H__ */
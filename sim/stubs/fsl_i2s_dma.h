@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_FSL_I2S_DMA_H__
+#define __SIM_FSL_I2S_DMA_H__ 1
+
+/**
+ * Host stub for the FLEXCOMM I2S DMA driver. Same queue semantic as the real
+ * driver: I2S_NUM_BUFFERS transfers can be queued, a slot is released before
+ * the completion callback is called.
+ */
+
+#include "fsl_dma.h"
+#include "fsl_i2s.h"
+
+#define I2S_NUM_BUFFERS (4U)
+
+typedef struct _i2s_dma_handle i2s_dma_handle_t;
+
+typedef void (*i2s_dma_transfer_callback_t)(I2S_Type *base,
+                                            i2s_dma_handle_t *handle,
+                                            status_t completionStatus,
+                                            void *userData);
+
+struct _i2s_dma_handle
+{
+    uint32_t state;
+    i2s_dma_transfer_callback_t completionCallback;
+    void *userData;
+    dma_handle_t *dmaHandle;
+    volatile i2s_transfer_t i2sQueue[I2S_NUM_BUFFERS];
+    volatile uint8_t queueUser;
+    volatile uint8_t queueDriver;
+    volatile uint32_t transferCount;
+    size_t offset;
+};
+
+void I2S_TxTransferCreateHandleDMA(I2S_Type *base,
+                                   i2s_dma_handle_t *handle,
+                                   dma_handle_t *dmaHandle,
+                                   i2s_dma_transfer_callback_t callback,
+                                   void *userData);
+void I2S_RxTransferCreateHandleDMA(I2S_Type *base,
+                                   i2s_dma_handle_t *handle,
+                                   dma_handle_t *dmaHandle,
+                                   i2s_dma_transfer_callback_t callback,
+                                   void *userData);
+status_t I2S_TxTransferSendDMA(I2S_Type *base, i2s_dma_handle_t *handle, i2s_transfer_t transfer);
+status_t I2S_RxTransferReceiveDMA(I2S_Type *base, i2s_dma_handle_t *handle, i2s_transfer_t transfer);
+void I2S_TransferAbortDMA(I2S_Type *base, i2s_dma_handle_t *handle);
+
+#endif /* __SIM_FSL_I2S_DMA_H__ */
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_QUEUE_H__
+#define __SIM_QUEUE_H__ 1
+
+/* QueueHandle_t is in FreeRTOS.h */
+
+#endif /* __SIM_QUEUE_H__ */
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_SEMPHR_H__
+#define __SIM_SEMPHR_H__ 1
+
+typedef void *SemaphoreHandle_t;
+
+#endif /* __SIM_SEMPHR_H__ */
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_USB_H__
+#define __SIM_USB_H__ 1
+
+/**
+ * Host stub for the NXP USB stack common header. Only what is needed by the
+ * streaming cores (i2s_rx.c / i2s_tx.c) is provided.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+typedef enum _usb_status
+{
+    kStatus_USB_Success = 0x00U,
+    kStatus_USB_Error,
+    kStatus_USB_Busy,
+    kStatus_USB_InvalidHandle,
+    kStatus_USB_InvalidParameter,
+    kStatus_USB_InvalidRequest,
+    kStatus_USB_ControllerNotFound,
+    kStatus_USB_InvalidControllerInterface,
+    kStatus_USB_NotSupported,
+    kStatus_USB_Retry,
+    kStatus_USB_TransferStall,
+    kStatus_USB_TransferFailed,
+    kStatus_USB_AllocFail,
+    kStatus_USB_LackSwapBuffer,
+    kStatus_USB_TransferCancel,
+    kStatus_USB_BandwidthFail,
+    kStatus_USB_MSDStatusFail,
+    kStatus_USB_EHCIAttached,
+    kStatus_USB_EHCIDetached,
+    kStatus_USB_DataOverRun,
+    kStatus_USB_NotImplemented,
+} usb_status_t;
+
+typedef enum _usb_controller_index
+{
+    kUSB_ControllerKhci0 = 0U,
+    kUSB_ControllerKhci1 = 1U,
+    kUSB_ControllerEhci0 = 2U,
+    kUSB_ControllerEhci1 = 3U,
+    kUSB_ControllerLpcIp3511Fs0 = 4U,
+    kUSB_ControllerLpcIp3511Fs1 = 5U,
+    kUSB_ControllerLpcIp3511Hs0 = 6U,
+    kUSB_ControllerLpcIp3511Hs1 = 7U,
+} usb_controller_index_t;
+
+typedef void *usb_device_handle;
+
+#define USB_SPEED_FULL (0x00U)
+#define USB_SPEED_LOW (0x01U)
+#define USB_SPEED_HIGH (0x02U)
+#define USB_SPEED_SUPER (0x04U)
+
+#define USB_DATA_ALIGN_SIZE (4U)
+#define USB_DATA_ALIGN_SIZE_MULTIPLE(n) (((n) + USB_DATA_ALIGN_SIZE - 1U) & (~(USB_DATA_ALIGN_SIZE - 1U)))
+
+#define USB_GLOBAL
+#define USB_BDT
+#define USB_CONTROLLER_DATA
+#define USB_RAM_ADDRESS_ALIGNMENT(n) __attribute__((aligned(n)))
+#define USB_DMA_INIT_DATA_ALIGN(n) __attribute__((aligned(n)))
+#define USB_DMA_NONINIT_DATA_ALIGN(n) __attribute__((aligned(n)))
+
+#define STRUCT_PACKED
+#define STRUCT_UNPACKED __attribute__((__packed__))
+
+#define USB_SHORT_GET_LOW(x) (((uint16_t)x) & 0xFFU)
+#define USB_SHORT_GET_HIGH(x) ((uint8_t)(((uint16_t)x) >> 8U) & 0xFFU)
+
+void usb_echo(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif /* __SIM_USB_H__ */
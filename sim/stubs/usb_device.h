@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SIM_USB_DEVICE_H__
+#define __SIM_USB_DEVICE_H__ 1
+
+/**
+ * Host stub for the NXP USB device controller API.
+ */
+
+typedef usb_status_t (*usb_device_callback_t)(usb_device_handle handle, uint32_t callbackEvent, void *eventParam);
+
+typedef struct _usb_setup_struct
+{
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} usb_setup_struct_t;
+
+typedef struct _usb_device_endpoint_callback_message_struct
+{
+    uint8_t *buffer;
+    uint32_t length;
+    uint8_t isSetup;
+} usb_device_endpoint_callback_message_struct_t;
+
+typedef usb_status_t (*usb_device_endpoint_callback_t)(usb_device_handle handle,
+                                                       usb_device_endpoint_callback_message_struct_t *message,
+                                                       void *callbackParam);
+
+#endif /* __SIM_USB_DEVICE_H__ */
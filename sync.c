@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "usb_device_config.h"
+#include "usb.h"
+#include "usb_device.h"
+#include "usb_device_class.h"
+#include "usb_device_descriptor.h"
+#include "fsl_device_registers.h"
+
+#include "fsl_ctimer.h"
+
+#include "clock_config.h"
+#include "tdm2usb.h"
+#include "i2s.h"
+#include "sync.h"
+
+#if USB_AUDIO_SYNC_MODE
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SYNC_CTIMER (CTIMER0)
+#define SYNC_CTIMER_CLK_ATTACH (kAUDIO_PLL_to_CTIMER0)
+#define SYNC_CTIMER_IRQn (CTIMER0_IRQn)
+
+/* Below the USB and the DMA interrupts, nothing here is time critical */
+#define SYNC_CTIMER_PRIORITY (7U)
+
+/**
+ * Audio PLL clock cycles in a window, the clock is 512 fs of the base rate of
+ * the family [245760 at 48 kHz, 225792 at 44.1 kHz].
+ */
+#define SYNC_WINDOW_TICKS(rate) \
+    ((SYNC_WINDOW_UFRAMES * I2S_MASTER_CLK_FS * ((((rate) % 8000U) == 0U) ? 48000U : 44100U)) / 8000U)
+
+/**
+ * SOF counter masks: 11-bit frame number, plus 3 bits of microframe in HS.
+ */
+#define SYNC_SOF_MASK_HS (0x3FFFU)
+#define SYNC_SOF_MASK_FS (0x07FFU)
+
+/**
+ * The SOF counter only gives the phase to a microframe: once locked the phase
+ * sits on one side of a microframe boundary and flips to the other one now and
+ * then, in proportion to where it really is. The loop runs on the phase
+ * low-pass filtered over about 2^SYNC_PHASE_FILTER_SHIFT windows, in
+ * 1/2^SYNC_PHASE_FRAC microframes, so that a flip moves the trim by a few LSB
+ * instead of a whole microframe worth of KP [64 LSB, about 107 ppm].
+ */
+#define SYNC_PHASE_FRAC (8U)
+#define SYNC_PHASE_FILTER_SHIFT (4U)
+
+/**
+ * Loop gains: trim = phase * KP + (integrator >> KI_SHIFT), in numerator LSB
+ * per microframe of filtered phase. A window moves the phase by about 1.3e-4
+ * microframes per LSB of error, these give a loop close to critical damping
+ * (the filter adds some lag) that settles in about ten seconds with the phase
+ * within a few microframes. Once locked the trim wanders by a few LSB around
+ * the right value, as the filtered phase follows the flips.
+ */
+#define SYNC_KP (64)
+#define SYNC_KI_SHIFT (3U)
+
+/**
+ * Max trim [300 LSB, about 500 ppm], enough for the crystals on both sides.
+ */
+#define SYNC_TRIM_MAX (300)
+#define SYNC_INTEG_MAX (SYNC_TRIM_MAX << (SYNC_KI_SHIFT + SYNC_PHASE_FRAC))
+
+/**
+ * A phase further than this [microframes] means that we lost the SOF (suspend,
+ * bus reset not seen yet): start over from the current SOF.
+ */
+#define SYNC_PHASE_MAX (32)
+
+typedef enum _sync_state
+{
+    kSYNC_Stopped = 0U,
+    kSYNC_Restart,
+    kSYNC_Running,
+} sync_state_t;
+
+typedef struct _sync_ctx
+{
+    volatile sync_state_t state;
+    uint8_t speed;
+    uint32_t ticks;   /* Window [Audio PLL clock cycles] */
+    uint32_t lastSof; /* SOF counter at the end of the last window */
+    int32_t phase;    /* [microframes] */
+    int32_t filtered; /* [1/2^SYNC_PHASE_FRAC microframes] */
+    int32_t integ;    /* [1/2^SYNC_PHASE_FRAC microframes x windows] */
+    int32_t trim;     /* [numerator LSB] */
+    uint32_t windows;
+    uint32_t resets;
+} sync_ctx_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void SYNC_Window(uint32_t flags);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static sync_ctx_t s_sync;
+
+static ctimer_callback_t s_syncCallback[] = {SYNC_Window};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static inline int32_t SYNC_Clamp(int32_t value, int32_t max)
+{
+    if (value > max)
+    {
+        return max;
+    }
+    else if (value < -max)
+    {
+        return -max;
+    }
+
+    return value;
+}
+
+/*!
+ * @brief End of a window, CTIMER0 match interrupt.
+ *
+ * A positive phase means that more microframes than expected elapsed during
+ * the window: the Audio PLL is slow and the numerator goes up.
+ */
+static void SYNC_Window(uint32_t flags)
+{
+    uint32_t sof;
+    uint32_t elapsed;
+    int32_t trim;
+
+    (void)flags;
+
+    if ((kSYNC_Stopped == s_sync.state) ||
+        (kStatus_USB_Success != USB_DeviceClassGetCurrentFrameCount(CONTROLLER_ID, &sof)))
+    {
+        return;
+    }
+
+    if (kSYNC_Restart == s_sync.state)
+    {
+        s_sync.lastSof = sof;
+        s_sync.phase = 0;
+        s_sync.filtered = 0;
+        s_sync.state = kSYNC_Running;
+        return;
+    }
+
+    /* Elapsed time in microframes */
+    if (USB_SPEED_HIGH == s_sync.speed)
+    {
+        elapsed = (sof - s_sync.lastSof) & SYNC_SOF_MASK_HS;
+    }
+    else
+    {
+        elapsed = ((sof - s_sync.lastSof) & SYNC_SOF_MASK_FS) << 3U;
+    }
+
+    s_sync.lastSof = sof;
+    s_sync.phase += (int32_t)elapsed - (int32_t)SYNC_WINDOW_UFRAMES;
+    s_sync.windows++;
+
+    if (abs(s_sync.phase) > SYNC_PHASE_MAX)
+    {
+        s_sync.phase = 0;
+        s_sync.filtered = 0;
+        s_sync.resets++;
+        return;
+    }
+
+    s_sync.filtered += (((s_sync.phase << SYNC_PHASE_FRAC) - s_sync.filtered) + (1 << (SYNC_PHASE_FILTER_SHIFT - 1U))) >>
+                       SYNC_PHASE_FILTER_SHIFT;
+    s_sync.integ = SYNC_Clamp(s_sync.integ + s_sync.filtered, SYNC_INTEG_MAX);
+
+    trim = ((s_sync.filtered * SYNC_KP) + (s_sync.integ >> SYNC_KI_SHIFT)) >> SYNC_PHASE_FRAC;
+    s_sync.trim = SYNC_Clamp(trim, SYNC_TRIM_MAX);
+
+    BOARD_TrimAudioPll(s_sync.trim);
+}
+
+void SYNC_PrintInfo(void)
+{
+    usb_echo("[SYNC] trim: %" PRId32 ", phase: %" PRId32 ", integrator: %" PRId32 ", windows: %" PRIu32
+             ", resets: %" PRIu32 "\n\r",
+             s_sync.trim, s_sync.phase, s_sync.integ, s_sync.windows, s_sync.resets);
+}
+
+/*!
+ * @brief Move the Audio PLL to the family of a sampling rate [Hz].
+ *
+ * Replaces BOARD_SetAudioPllRate() in sync mode: the window is stopped while
+ * the PLL is reprogrammed, then it starts over from the current SOF. Within
+ * the same family the PLL is untouched and the loop keeps its trim.
+ */
+void SYNC_SetRate(uint32_t rate)
+{
+    ctimer_match_config_t match = {0};
+    uint32_t ticks = SYNC_WINDOW_TICKS(rate);
+    uint32_t primask;
+
+    CTIMER_StopTimer(SYNC_CTIMER);
+
+    BOARD_SetAudioPllRate(rate);
+
+    primask = DisableGlobalIRQ();
+    if (ticks != s_sync.ticks)
+    {
+        s_sync.ticks = ticks;
+        s_sync.integ = 0;
+        s_sync.trim = 0;
+    }
+    if (kSYNC_Stopped != s_sync.state)
+    {
+        s_sync.state = kSYNC_Restart;
+    }
+    EnableGlobalIRQ(primask);
+
+    match.matchValue = ticks - 1U;
+    match.enableCounterReset = true;
+    match.enableCounterStop = false;
+    match.outControl = kCTIMER_Output_NoAction;
+    match.enableInterrupt = true;
+    CTIMER_SetupMatch(SYNC_CTIMER, kCTIMER_Match_0, &match);
+
+    CTIMER_Reset(SYNC_CTIMER);
+    CTIMER_StartTimer(SYNC_CTIMER);
+}
+
+/*!
+ * @brief Start disciplining the Audio PLL, once the device is configured.
+ */
+void SYNC_Start(uint8_t speed)
+{
+    s_sync.speed = speed;
+    s_sync.state = kSYNC_Restart;
+}
+
+/*!
+ * @brief Stop disciplining the Audio PLL, the last trim is kept.
+ */
+void SYNC_Stop(void)
+{
+    s_sync.state = kSYNC_Stopped;
+}
+
+void SYNC_Init(void)
+{
+    ctimer_config_t config;
+
+    CLOCK_AttachClk(SYNC_CTIMER_CLK_ATTACH);
+
+    CTIMER_GetDefaultConfig(&config);
+    CTIMER_Init(SYNC_CTIMER, &config);
+    CTIMER_RegisterCallBack(SYNC_CTIMER, s_syncCallback, kCTIMER_SingleCallback);
+    NVIC_SetPriority(SYNC_CTIMER_IRQn, SYNC_CTIMER_PRIORITY);
+
+    SYNC_SetRate(AUDIO_SAMPLING_RATE_KHZ * 1000U);
+}
+
+#endif /* USB_AUDIO_SYNC_MODE */
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SYNC_H__
+#define __SYNC_H__ 1
+
+#include "fsl_common.h"
+#include "usb_device_descriptor.h"
+
+/**
+ * Audio PLL disciplined to the USB SOF (USB_AUDIO_SYNC_MODE).
+ *
+ * CTIMER0 counts the Audio PLL clock (512 fs) and interrupts every window of
+ * SYNC_WINDOW_UFRAMES nominal microframes. Every window is timestamped with
+ * the USB SOF counter, as the TX rate measurement does with the DMA callbacks
+ * (see I2S_TxMeasureRate()): the phase is the number of microframes elapsed
+ * minus the nominal ones, accumulated since the start so the quantization
+ * error of a window is compensated by the next one.
+ *
+ * A PI loop on the low-pass filtered phase trims the fractional numerator of
+ * the Audio PLL (see BOARD_TrimAudioPll()), one LSB is about 1.7 ppm. The integrator is kept
+ * across SYNC_Stop() / SYNC_Start() so that the PLL holds the last frequency
+ * while the host is away, and cleared when the PLL moves to the other family.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/* Window in microframes [80 microframes, 10 ms] */
+#define SYNC_WINDOW_UFRAMES (80U)
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+#if USB_AUDIO_SYNC_MODE
+void SYNC_Init(void);
+void SYNC_SetRate(uint32_t rate);
+void SYNC_Start(uint8_t speed);
+void SYNC_Stop(void);
+void SYNC_PrintInfo(void);
+#endif
+
+#endif /* __SYNC_H__ */
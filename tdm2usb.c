@@ -8,6 +8,7 @@
 
 // TODO: De-init endpoints on alternate settings 0
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -25,6 +26,9 @@
 #include "i2s.h"
 #include "i2s_rx.h"
 #include "i2s_tx.h"
+#include "prof.h"
+#include "trace.h"
+#include "sync.h"
 
 #include "fsl_device_registers.h"
 #include "fsl_debug_console.h"
@@ -45,6 +49,20 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+/* The USB channels are the first TDM slots, see I2S_GetPackKernel() */
+#if (AUDIO_FORMAT_CHANNELS > I2S_CH_NUM) || (AUDIO_FORMAT_SIZE > I2S_CH_LEN_DATA)
+#error "The USB frames must fit the TDM frames (AUDIO_FORMAT_CHANNELS / AUDIO_FORMAT_SIZE)"
+#endif
+
+/* With 4 instances per direction FLEXCOMM0 is the last TX instance, see i2s_tx.h */
+#if (I2S_INST_NUM > 2U) && (BOARD_DEBUG_UART_INSTANCE == 0U)
+#error "I2S_TDM_INST_NUM = 4 needs FLEXCOMM0, move the debug console (BOARD_DEBUG_UART_xxx) off it"
+#endif
+
+/* The Audio PLL can only follow the SOF when it clocks the TDM bus */
+#if USB_AUDIO_SYNC_MODE && !I2S_MASTER
+#error "USB_AUDIO_SYNC_MODE needs I2S_MASTER"
+#endif
 
 /*******************************************************************************
  * Prototypes
@@ -59,7 +77,36 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
 /*******************************************************************************
  * Variables
  ******************************************************************************/
+static QueueHandle_t s_appEventQueue;
+
+/**
+ * ISO servicing latency in DWT cycles, cleared on every statistics flush: the
+ * longest USB interrupt and the spread of the interval between two IN
+ * completions. A control request serviced in the interrupt delays the ISO
+ * completions queued behind it, with USB_DEVICE_CONFIG_CONTROL_TASK the
+ * interval should stay within a few microseconds of the endpoint bInterval.
+ */
+static struct
+{
+    uint32_t isrMax;
+    uint32_t inLast;
+    uint32_t inMin;
+    uint32_t inMax;
+} s_isoLatency = {
+    .inMin = UINT32_MAX,
+};
+
+#if !USB_AUDIO_SYNC_MODE
 USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE) static uint8_t usbAudioFeedBackBuffer[USB_DATA_ALIGN_SIZE_MULTIPLE(4)];
+#endif
+
+#if PROF_ENABLE
+/* Data stage of USB_VENDOR_REQUEST_PROF_GET */
+USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE) static prof_stats_t s_profSnapshot;
+#endif
+
+/* Data stage of USB_VENDOR_REQUEST_ROUTE_GET / USB_VENDOR_REQUEST_ROUTE_SET */
+USB_GLOBAL USB_RAM_ADDRESS_ALIGNMENT(USB_DATA_ALIGN_SIZE) static uint8_t s_routeMap[I2S_CH_NUM];
 
 extern usb_audio_device_struct_t g_audioDevice;
 extern usb_device_class_struct_t g_UsbDeviceAudioClass;
@@ -74,40 +121,20 @@ usb_audio_device_struct_t g_audioDevice = {
     .audioHandle = NULL,
     .applicationTaskHandle = NULL,
     .deviceTaskHandle = NULL,
-    .copyProtect = 0x01U,
-    .curMute = 0x01U,
-    .curVolume = {0x00U, 0x80U},
-    .minVolume = {0x00U, 0x80U},
-    .maxVolume = {0xFFU, 0x7FU},
-    .resVolume = {0x01U, 0x00U},
-    .curBass = 0x00U,
-    .minBass = 0x80U,
-    .maxBass = 0x7FU,
-    .resBass = 0x01U,
-    .curMid = 0x00U,
-    .minMid = 0x80U,
-    .maxMid = 0x7FU,
-    .resMid = 0x01U,
-    .curTreble = 0x01U,
-    .minTreble = 0x80U,
-    .maxTreble = 0x7FU,
-    .resTreble = 0x01U,
-    .curAutomaticGain = 0x01U,
-    .curDelay = {0x00U, 0x40U},
-    .minDelay = {0x00U, 0x00U},
-    .maxDelay = {0xFFU, 0xFFU},
-    .resDelay = {0x00U, 0x01U},
-    .curLoudness = 0x01U,
-    .curSamplingFrequency = {0x00U, 0x00U, 0x01U},
-    .minSamplingFrequency = {0x00U, 0x00U, 0x01U},
-    .maxSamplingFrequency = {0x00U, 0x00U, 0x01U},
-    .resSamplingFrequency = {0x00U, 0x00U, 0x01U},
-    .curMute20 = 0U,
     .curClockValid = 1U,
-    .curVolume20 = {0x00U, 0x1FU},
-    .curSampleFrequency = 48000U,
-    .freqControlRange = {1U, 48000U, 48000U, 0U},
-    .volumeControlRange = {1U, 0x8001U, 0x7FFFU, 1U},
+    .curSampleFrequency = AUDIO_SAMPLING_RATE_KHZ * 1000U,
+    .freqControlRange =
+        {
+            AUDIO_SAMPLING_RATE_COUNT,
+            {
+                {44100U, 44100U, 0U},
+                {48000U, 48000U, 0U},
+#if (AUDIO_SAMPLING_RATE_MAX_KHZ >= 96U)
+                {96000U, 96000U, 0U},
+#endif
+            },
+        },
+    .volumeControlRange = {1U, USB_AUDIO_VOLUME_MIN, USB_AUDIO_VOLUME_MAX, USB_AUDIO_VOLUME_RES},
     .currentConfiguration = 0,
     .currentInterfaceAlternateSetting = {0, 0, 0},
     .speed = USB_SPEED_FULL,
@@ -131,10 +158,133 @@ static usb_device_class_config_list_struct_t s_audioConfigList = {
 /*******************************************************************************
  * Code
  ******************************************************************************/
+/*!
+ * @brief Post an event to the application task.
+ *
+ * Safe from both the interrupt and the task context (the USB callbacks run in
+ * either one depending on USB_DEVICE_CONFIG_USE_TASK). Never blocks: the event
+ * is dropped when the queue is full.
+ */
+static bool APP_Post(const app_event_t *event)
+{
+    BaseType_t woken = pdFALSE;
+    BaseType_t ret;
+
+    if (NULL == s_appEventQueue)
+    {
+        return false;
+    }
+
+    if (0U != __get_IPSR())
+    {
+        ret = xQueueSendFromISR(s_appEventQueue, event, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        ret = xQueueSend(s_appEventQueue, event, 0);
+    }
+
+    return (pdPASS == ret);
+}
+
+bool APP_PostEvent(app_event_type_t type, uint32_t arg)
+{
+    app_event_t event = {
+        .type = type,
+        .arg = arg,
+        .work = NULL,
+    };
+
+    return APP_Post(&event);
+}
+
+/*!
+ * @brief Run work(arg) later from the application task.
+ *
+ * For anything that is not time critical and that we do not want to run in
+ * the interrupt context.
+ */
+bool APP_DeferWork(app_work_t work, uint32_t arg)
+{
+    app_event_t event = {
+        .type = kAPP_EventWork,
+        .arg = arg,
+        .work = work,
+    };
+
+    return APP_Post(&event);
+}
+
+/*!
+ * @brief Account for an IN completion in the ISO latency statistics.
+ */
+static inline void USB_IsoLatencyIn(void)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t interval = now - s_isoLatency.inLast;
+
+    if (0U != s_isoLatency.inLast)
+    {
+        if (interval < s_isoLatency.inMin)
+        {
+            s_isoLatency.inMin = interval;
+        }
+        if (interval > s_isoLatency.inMax)
+        {
+            s_isoLatency.inMax = interval;
+        }
+    }
+
+    s_isoLatency.inLast = now;
+}
+
+/*!
+ * @brief Print and clear the ISO latency statistics.
+ */
+static void USB_IsoLatencyFlush(void)
+{
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+    uint32_t isrMax;
+    uint32_t inMin;
+    uint32_t inMax;
+
+    taskENTER_CRITICAL();
+    isrMax = s_isoLatency.isrMax;
+    inMin = s_isoLatency.inMin;
+    inMax = s_isoLatency.inMax;
+    s_isoLatency.isrMax = 0U;
+    s_isoLatency.inMin = UINT32_MAX;
+    s_isoLatency.inMax = 0U;
+    taskEXIT_CRITICAL();
+
+    if (inMin > inMax)
+    {
+        inMin = inMax;
+    }
+
+    usb_echo("[USB] isr max: %" PRIu32 " us, IN interval: %" PRIu32 "..%" PRIu32 " us\r\n", isrMax / cyclesPerUs,
+             inMin / cyclesPerUs, inMax / cyclesPerUs);
+
+    if (NULL != g_audioDevice.deviceTaskHandle)
+    {
+        usb_echo("[USB] device task stack free: %" PRIu32 " bytes\r\n",
+                 (uint32_t)(uxTaskGetStackHighWaterMark(g_audioDevice.deviceTaskHandle) * sizeof(portSTACK_TYPE)));
+    }
+}
 
 void USB_IRQHandler(void)
 {
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles;
+
     USB_DeviceLpcIp3511IsrFunction(g_audioDevice.deviceHandle);
+
+    cycles = DWT->CYCCNT - start;
+    if (cycles > s_isoLatency.isrMax)
+    {
+        s_isoLatency.isrMax = cycles;
+    }
 }
 
 void USB_DeviceClockInit(void)
@@ -208,10 +358,320 @@ void USB_DeviceTaskFn(void *deviceHandle)
 }
 #endif
 
+#if I2S_MASTER
+/*!
+ * @brief Only advertise the sampling frequencies the I2S master can generate.
+ */
+static void USB_DeviceAudioTrimRates(void)
+{
+    usb_audio_freq_range_t *range = &g_audioDevice.freqControlRange;
+    uint16_t count = 0U;
+
+    for (uint32_t k = 0; k < range->wNumSubRanges; k++)
+    {
+        if (I2S_MasterDivider(range->subrange[k].wMIN) != 0U)
+        {
+            range->subrange[count++] = range->subrange[k];
+        }
+    }
+
+    range->wNumSubRanges = count;
+}
+#endif
+
+/*!
+ * @brief Check a sampling frequency against the advertised ones.
+ */
+static bool USB_DeviceAudioIsRateSupported(uint32_t rate)
+{
+    for (uint32_t k = 0; k < g_audioDevice.freqControlRange.wNumSubRanges; k++)
+    {
+        if (rate == g_audioDevice.freqControlRange.subrange[k].wMIN)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * @brief Move the streams to a new sampling frequency.
+ *
+ * The hosts send SET_CUR either before or after selecting the streaming
+ * alternate setting, the streams already running are restarted at the new
+ * rate (the queued transfers complete as usual). The Audio PLL is moved from
+ * the application task (kAPP_EventRateChange).
+ *
+ * With USB_DEVICE_CONFIG_CONTROL_TASK we are in the device task, the ISO
+ * completions and the DMA callbacks must not run on the rings and on the
+ * packet sizes while they are restarted.
+ */
+static void USB_DeviceAudioSetRate(uint32_t rate)
+{
+    uint8_t inAlternate = g_audioDevice.currentInterfaceAlternateSetting[USB_AUDIO_STREAM_IN_INTERFACE_INDEX];
+    uint8_t outAlternate = g_audioDevice.currentInterfaceAlternateSetting[USB_AUDIO_STREAM_OUT_INTERFACE_INDEX];
+    OSA_SR_ALLOC();
+
+    OSA_ENTER_CRITICAL();
+
+    g_audioDevice.curSampleFrequency = rate;
+
+    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 != inAlternate)
+    {
+        I2S_RxStop();
+    }
+    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 != outAlternate)
+    {
+        I2S_TxStop();
+    }
+
+    USB_AudioI2s2UsbSetRate(rate);
+    USB_AudioUsb2I2sSetRate(rate);
+
+    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 != inAlternate)
+    {
+        g_audioDevice.streamInPacketSize = USB_DeviceGetStreamPacketSize(g_audioDevice.speed, inAlternate, rate);
+        I2S_RxStart();
+    }
+    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 != outAlternate)
+    {
+        g_audioDevice.streamOutPacketSize = USB_DeviceGetStreamPacketSize(g_audioDevice.speed, outAlternate, rate);
+        I2S_TxStart();
+    }
+
+    OSA_EXIT_CRITICAL();
+}
+
+/*!
+ * @brief Data stage of SET_CUR on the sampling frequency control.
+ */
+static usb_status_t USB_DeviceAudioSetSampleFrequency(uint8_t channel)
+{
+    if (!USB_DeviceAudioIsRateSupported(g_audioDevice.setSampleFrequency))
+    {
+        return kStatus_USB_InvalidRequest;
+    }
+
+    if (g_audioDevice.setSampleFrequency != g_audioDevice.curSampleFrequency)
+    {
+        USB_DeviceAudioSetRate(g_audioDevice.setSampleFrequency);
+        APP_PostEvent(kAPP_EventRateChange, g_audioDevice.curSampleFrequency);
+    }
+
+    return kStatus_USB_Success;
+}
+
+/*!
+ * @brief Push the gains of a feature unit to its data path.
+ *
+ * Application task (the dB are converted with the FPU), deferred by the SET_CUR
+ * of the mute and volume controls. arg is the feature unit ID.
+ */
+static void USB_DeviceAudioApplyFeature(uint32_t arg)
+{
+    const usb_audio_feature_t *feature =
+        (USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID == arg) ? &g_audioDevice.inFeature : &g_audioDevice.outFeature;
+    int32_t gain[I2S_CH_NUM];
+
+    for (uint32_t n = 0U; n < I2S_CH_NUM; n++)
+    {
+        /* The TDM slots past the USB channels are never streamed */
+        uint32_t channel = MIN(n + 1U, USB_AUDIO_FEATURE_UNIT_CHANNELS);
+        int16_t master = feature->volume[0];
+        int16_t volume = feature->volume[channel];
+
+        if ((0U != feature->mute[0]) || (0U != feature->mute[channel]) || (INT16_MIN == master) || (INT16_MIN == volume))
+        {
+            gain[n] = 0;
+        }
+        else
+        {
+            gain[n] = I2S_GainFromDb(MIN(MAX((int32_t)master + volume, USB_AUDIO_VOLUME_MIN), USB_AUDIO_VOLUME_MAX));
+        }
+    }
+
+    if (USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID == arg)
+    {
+        USB_AudioI2s2UsbSetGain(gain);
+    }
+    else
+    {
+        USB_AudioUsb2I2sSetGain(gain);
+    }
+}
+
+/*!
+ * @brief Data stage of SET_CUR on a volume control.
+ *
+ * Out of range volumes are clamped, -inf (0x8000) is kept as is.
+ */
+static usb_status_t USB_DeviceAudioSetVolume(usb_audio_feature_t *feature, uint8_t channel, uint8_t entityId)
+{
+    int16_t volume = feature->volume[channel];
+
+    if (INT16_MIN != volume)
+    {
+        feature->volume[channel] = MIN(MAX(volume, USB_AUDIO_VOLUME_MIN), USB_AUDIO_VOLUME_MAX);
+    }
+
+    return APP_DeferWork(USB_DeviceAudioApplyFeature, entityId) ? kStatus_USB_Success : kStatus_USB_Busy;
+}
+
+/*!
+ * @brief Data stage of SET_CUR on a mute control.
+ */
+static usb_status_t USB_DeviceAudioSetMute(usb_audio_feature_t *feature, uint8_t channel, uint8_t entityId)
+{
+    feature->mute[channel] = (0U != feature->mute[channel]) ? 1U : 0U;
+
+    return APP_DeferWork(USB_DeviceAudioApplyFeature, entityId) ? kStatus_USB_Success : kStatus_USB_Busy;
+}
+
+/*!
+ * @brief Data stage of SET_CUR on the capture volume.
+ */
+static usb_status_t USB_DeviceAudioSetInVolume(uint8_t channel)
+{
+    return USB_DeviceAudioSetVolume(&g_audioDevice.inFeature, channel, USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID);
+}
+
+/*!
+ * @brief Data stage of SET_CUR on the playback volume.
+ */
+static usb_status_t USB_DeviceAudioSetOutVolume(uint8_t channel)
+{
+    return USB_DeviceAudioSetVolume(&g_audioDevice.outFeature, channel, USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID);
+}
+
+/*!
+ * @brief Data stage of SET_CUR on the capture mute.
+ */
+static usb_status_t USB_DeviceAudioSetInMute(uint8_t channel)
+{
+    return USB_DeviceAudioSetMute(&g_audioDevice.inFeature, channel, USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID);
+}
+
+/*!
+ * @brief Data stage of SET_CUR on the playback mute.
+ */
+static usb_status_t USB_DeviceAudioSetOutMute(uint8_t channel)
+{
+    return USB_DeviceAudioSetMute(&g_audioDevice.outFeature, channel, USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID);
+}
+
+/**
+ * Audio class controls, by entity and control selector (see
+ * usb_audio_control_t). The two clock sources are the same clock, the feature
+ * units have the master and all the channels.
+ */
+static const usb_audio_control_t s_audioControls[] = {
+    {
+        USB_AUDIO_IN_CONTROL_CLOCK_SOURCE_ENTITY_ID,
+        USB_DEVICE_AUDIO_CS_SAM_FREQ_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET | USB_AUDIO_CONTROL_SET,
+        1U,
+        sizeof(g_audioDevice.curSampleFrequency),
+        sizeof(g_audioDevice.freqControlRange.subrange[0]),
+        &g_audioDevice.curSampleFrequency,
+        &g_audioDevice.setSampleFrequency,
+        &g_audioDevice.freqControlRange,
+        USB_DeviceAudioSetSampleFrequency,
+    },
+    {
+        USB_AUDIO_OUT_CONTROL_CLOCK_SOURCE_ENTITY_ID,
+        USB_DEVICE_AUDIO_CS_SAM_FREQ_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET | USB_AUDIO_CONTROL_SET,
+        1U,
+        sizeof(g_audioDevice.curSampleFrequency),
+        sizeof(g_audioDevice.freqControlRange.subrange[0]),
+        &g_audioDevice.curSampleFrequency,
+        &g_audioDevice.setSampleFrequency,
+        &g_audioDevice.freqControlRange,
+        USB_DeviceAudioSetSampleFrequency,
+    },
+    {
+        USB_AUDIO_IN_CONTROL_CLOCK_SOURCE_ENTITY_ID,
+        USB_DEVICE_AUDIO_CS_CLOCK_VALID_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET,
+        1U,
+        sizeof(g_audioDevice.curClockValid),
+        0U,
+        &g_audioDevice.curClockValid,
+        NULL,
+        NULL,
+        NULL,
+    },
+    {
+        USB_AUDIO_OUT_CONTROL_CLOCK_SOURCE_ENTITY_ID,
+        USB_DEVICE_AUDIO_CS_CLOCK_VALID_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET,
+        1U,
+        sizeof(g_audioDevice.curClockValid),
+        0U,
+        &g_audioDevice.curClockValid,
+        NULL,
+        NULL,
+        NULL,
+    },
+    {
+        USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID,
+        USB_DEVICE_AUDIO_FU_MUTE_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET | USB_AUDIO_CONTROL_SET,
+        USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U,
+        sizeof(g_audioDevice.inFeature.mute[0]),
+        0U,
+        g_audioDevice.inFeature.mute,
+        NULL,
+        NULL,
+        USB_DeviceAudioSetInMute,
+    },
+    {
+        USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID,
+        USB_DEVICE_AUDIO_FU_VOLUME_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET | USB_AUDIO_CONTROL_SET,
+        USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U,
+        sizeof(g_audioDevice.inFeature.volume[0]),
+        sizeof(g_audioDevice.volumeControlRange) - sizeof(g_audioDevice.volumeControlRange.wNumSubRanges),
+        g_audioDevice.inFeature.volume,
+        NULL,
+        &g_audioDevice.volumeControlRange,
+        USB_DeviceAudioSetInVolume,
+    },
+    {
+        USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID,
+        USB_DEVICE_AUDIO_FU_MUTE_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET | USB_AUDIO_CONTROL_SET,
+        USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U,
+        sizeof(g_audioDevice.outFeature.mute[0]),
+        0U,
+        g_audioDevice.outFeature.mute,
+        NULL,
+        NULL,
+        USB_DeviceAudioSetOutMute,
+    },
+    {
+        USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID,
+        USB_DEVICE_AUDIO_FU_VOLUME_CONTROL_SELECTOR,
+        USB_AUDIO_CONTROL_GET | USB_AUDIO_CONTROL_SET,
+        USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U,
+        sizeof(g_audioDevice.outFeature.volume[0]),
+        sizeof(g_audioDevice.volumeControlRange) - sizeof(g_audioDevice.volumeControlRange.wNumSubRanges),
+        g_audioDevice.outFeature.volume,
+        NULL,
+        &g_audioDevice.volumeControlRange,
+        USB_DeviceAudioSetOutVolume,
+    },
+};
+
 /*!
  * @brief Audio class specific request function.
  *
- * This function handles the Audio class specific requests.
+ * This function handles the Audio class specific requests addressed to the
+ * entities: the control is looked up in s_audioControls and the request is
+ * checked against its permissions and channels. The class driver forwards all
+ * of them, this is the only table: anything else, the endpoint controls
+ * included, is stalled.
  *
  * @param handle           The Audio class handle.
  * @param event            The Audio class event type.
@@ -222,295 +682,76 @@ void USB_DeviceTaskFn(void *deviceHandle)
 usb_status_t USB_DeviceAudioRequest(class_handle_t handle, uint32_t event, void *param)
 {
     usb_device_control_request_struct_t *request = (usb_device_control_request_struct_t *)param;
-    usb_status_t error = kStatus_USB_Success;
+    const usb_audio_control_t *control = NULL;
+    uint8_t entityId = (uint8_t)(request->setup->wIndex >> 8U);
+    uint8_t controlSelector = (uint8_t)(request->setup->wValue >> 8U);
+    uint8_t channel = (uint8_t)(request->setup->wValue & 0xFFU);
 
-    switch (event)
+    if ((request->setup->bmRequestType & USB_REQUEST_TYPE_RECIPIENT_MASK) != USB_REQUEST_TYPE_RECIPIENT_INTERFACE)
     {
-    case USB_DEVICE_AUDIO_FU_GET_CUR_MUTE_CONTROL:
-        request->buffer = (uint8_t *)&g_audioDevice.curMute20;
-        request->length = sizeof(g_audioDevice.curMute20);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_CUR_VOLUME_CONTROL:
-        request->buffer = (uint8_t *)&g_audioDevice.curVolume20;
-        request->length = sizeof(g_audioDevice.curVolume20);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_CUR_BASS_CONTROL:
-        request->buffer = &g_audioDevice.curBass;
-        request->length = sizeof(g_audioDevice.curBass);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_CUR_MID_CONTROL:
-        request->buffer = &g_audioDevice.curMid;
-        request->length = sizeof(g_audioDevice.curMid);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_CUR_TREBLE_CONTROL:
-        request->buffer = &g_audioDevice.curTreble;
-        request->length = sizeof(g_audioDevice.curTreble);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_CUR_AUTOMATIC_GAIN_CONTROL:
-        request->buffer = &g_audioDevice.curAutomaticGain;
-        request->length = sizeof(g_audioDevice.curAutomaticGain);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_CUR_DELAY_CONTROL:
-        request->buffer = g_audioDevice.curDelay;
-        request->length = sizeof(g_audioDevice.curDelay);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MIN_VOLUME_CONTROL:
-        request->buffer = g_audioDevice.minVolume;
-        request->length = sizeof(g_audioDevice.minVolume);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MIN_BASS_CONTROL:
-        request->buffer = &g_audioDevice.minBass;
-        request->length = sizeof(g_audioDevice.minBass);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MIN_MID_CONTROL:
-        request->buffer = &g_audioDevice.minMid;
-        request->length = sizeof(g_audioDevice.minMid);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MIN_TREBLE_CONTROL:
-        request->buffer = &g_audioDevice.minTreble;
-        request->length = sizeof(g_audioDevice.minTreble);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MIN_DELAY_CONTROL:
-        request->buffer = g_audioDevice.minDelay;
-        request->length = sizeof(g_audioDevice.minDelay);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MAX_VOLUME_CONTROL:
-        request->buffer = g_audioDevice.maxVolume;
-        request->length = sizeof(g_audioDevice.maxVolume);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MAX_BASS_CONTROL:
-        request->buffer = &g_audioDevice.maxBass;
-        request->length = sizeof(g_audioDevice.maxBass);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MAX_MID_CONTROL:
-        request->buffer = &g_audioDevice.maxMid;
-        request->length = sizeof(g_audioDevice.maxMid);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MAX_TREBLE_CONTROL:
-        request->buffer = &g_audioDevice.maxTreble;
-        request->length = sizeof(g_audioDevice.maxTreble);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_MAX_DELAY_CONTROL:
-        request->buffer = g_audioDevice.maxDelay;
-        request->length = sizeof(g_audioDevice.maxDelay);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_RES_VOLUME_CONTROL:
-        request->buffer = g_audioDevice.resVolume;
-        request->length = sizeof(g_audioDevice.resVolume);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_RES_BASS_CONTROL:
-        request->buffer = &g_audioDevice.resBass;
-        request->length = sizeof(g_audioDevice.resBass);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_RES_MID_CONTROL:
-        request->buffer = &g_audioDevice.resMid;
-        request->length = sizeof(g_audioDevice.resMid);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_RES_TREBLE_CONTROL:
-        request->buffer = &g_audioDevice.resTreble;
-        request->length = sizeof(g_audioDevice.resTreble);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_RES_DELAY_CONTROL:
-        request->buffer = g_audioDevice.resDelay;
-        request->length = sizeof(g_audioDevice.resDelay);
-        break;
-    case USB_DEVICE_AUDIO_CS_GET_CUR_SAMPLING_FREQ_CONTROL:
-        request->buffer = (uint8_t *)&g_audioDevice.curSampleFrequency;
-        request->length = sizeof(g_audioDevice.curSampleFrequency);
-        break;
-    case USB_DEVICE_AUDIO_CS_SET_CUR_SAMPLING_FREQ_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = (uint8_t *)&g_audioDevice.curSampleFrequency;
-            request->length = sizeof(g_audioDevice.curSampleFrequency);
-        }
-        break;
-    case USB_DEVICE_AUDIO_CS_GET_CUR_CLOCK_VALID_CONTROL:
-        request->buffer = &g_audioDevice.curClockValid;
-        request->length = sizeof(g_audioDevice.curClockValid);
-        break;
-    case USB_DEVICE_AUDIO_CS_SET_CUR_CLOCK_VALID_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.curClockValid;
-            request->length = sizeof(g_audioDevice.curClockValid);
-        }
-        break;
-    case USB_DEVICE_AUDIO_CS_GET_RANGE_SAMPLING_FREQ_CONTROL:
-        request->buffer = (uint8_t *)&g_audioDevice.freqControlRange;
-        request->length = sizeof(g_audioDevice.freqControlRange);
-        break;
-    case USB_DEVICE_AUDIO_FU_GET_RANGE_VOLUME_CONTROL:
-        request->buffer = (uint8_t *)&g_audioDevice.volumeControlRange;
-        request->length = sizeof(g_audioDevice.volumeControlRange);
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_VOLUME_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.curVolume20;
-            request->length = sizeof(g_audioDevice.curVolume20);
-        }
-        else
-        {
-            uint16_t volume = (uint16_t)((uint16_t)g_audioDevice.curVolume20[1] << 8U);
-            volume |= (uint8_t)(g_audioDevice.curVolume20[0]);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_MUTE_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.curMute;
-            request->length = sizeof(g_audioDevice.curMute);
-        }
-        else
-        {
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_BASS_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.curBass;
-            request->length = sizeof(g_audioDevice.curBass);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_MID_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.curMid;
-            request->length = sizeof(g_audioDevice.curMid);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_TREBLE_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.curTreble;
-            request->length = sizeof(g_audioDevice.curTreble);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_AUTOMATIC_GAIN_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.curAutomaticGain;
-            request->length = sizeof(g_audioDevice.curAutomaticGain);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_CUR_DELAY_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.curDelay;
-            request->length = sizeof(g_audioDevice.curDelay);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MIN_VOLUME_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.minVolume;
-            request->length = sizeof(g_audioDevice.minVolume);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MIN_BASS_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.minBass;
-            request->length = sizeof(g_audioDevice.minBass);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MIN_MID_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.minMid;
-            request->length = sizeof(g_audioDevice.minMid);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MIN_TREBLE_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.minTreble;
-            request->length = sizeof(g_audioDevice.minTreble);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MIN_DELAY_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.minDelay;
-            request->length = sizeof(g_audioDevice.minDelay);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MAX_VOLUME_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.maxVolume;
-            request->length = sizeof(g_audioDevice.maxVolume);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MAX_BASS_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.maxBass;
-            request->length = sizeof(g_audioDevice.maxBass);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MAX_MID_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.maxMid;
-            request->length = sizeof(g_audioDevice.maxMid);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MAX_TREBLE_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.maxTreble;
-            request->length = sizeof(g_audioDevice.maxTreble);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_MAX_DELAY_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.maxDelay;
-            request->length = sizeof(g_audioDevice.maxDelay);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_RES_VOLUME_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = g_audioDevice.resVolume;
-            request->length = sizeof(g_audioDevice.resVolume);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_RES_BASS_CONTROL:
-        if (request->isSetup == 1U)
-        {
-            request->buffer = &g_audioDevice.resBass;
-            request->length = sizeof(g_audioDevice.resBass);
-        }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_RES_MID_CONTROL:
-        if (request->isSetup == 1U)
+        return kStatus_USB_InvalidRequest;
+    }
+
+    for (uint32_t k = 0; k < ARRAY_SIZE(s_audioControls); k++)
+    {
+        if ((entityId == s_audioControls[k].entityId) && (controlSelector == s_audioControls[k].controlSelector))
         {
-            request->buffer = &g_audioDevice.resMid;
-            request->length = sizeof(g_audioDevice.resMid);
+            control = &s_audioControls[k];
+            break;
         }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_RES_TREBLE_CONTROL:
-        if (request->isSetup == 1U)
+    }
+
+    if ((NULL == control) || (channel >= control->channels))
+    {
+        return kStatus_USB_InvalidRequest;
+    }
+
+    if (USB_DEVICE_AUDIO_RANGE_REQUEST == request->setup->bRequest)
+    {
+        if ((USB_DEVICE_AUDIO_GET_REQUEST_INTERFACE != request->setup->bmRequestType) || (NULL == control->range))
         {
-            request->buffer = &g_audioDevice.resTreble;
-            request->length = sizeof(g_audioDevice.resTreble);
+            return kStatus_USB_InvalidRequest;
         }
-        break;
-    case USB_DEVICE_AUDIO_FU_SET_RES_DELAY_CONTROL:
-        if (request->isSetup == 1U)
+
+        /* wNumSubRanges first, USB_DeviceAudioTrimRates() may have lowered it */
+        request->buffer = (uint8_t *)control->range;
+        request->length = (uint32_t)request->buffer[0] | ((uint32_t)request->buffer[1] << 8U);
+        request->length = sizeof(uint16_t) + (request->length * control->subrangeLength);
+        return kStatus_USB_Success;
+    }
+
+    if (USB_DEVICE_AUDIO_CUR_REQUEST != request->setup->bRequest)
+    {
+        return kStatus_USB_InvalidRequest;
+    }
+
+    if (USB_DEVICE_AUDIO_GET_REQUEST_INTERFACE == request->setup->bmRequestType)
+    {
+        if (0U == (control->access & USB_AUDIO_CONTROL_GET))
         {
-            request->buffer = g_audioDevice.resDelay;
-            request->length = sizeof(g_audioDevice.resDelay);
+            return kStatus_USB_InvalidRequest;
         }
-        break;
-    default:
-        error = kStatus_USB_InvalidRequest;
-        break;
+
+        request->buffer = (uint8_t *)control->cur + (channel * control->curLength);
+        request->length = control->curLength;
+        return kStatus_USB_Success;
     }
-    return error;
+
+    if (0U == (control->access & USB_AUDIO_CONTROL_SET))
+    {
+        return kStatus_USB_InvalidRequest;
+    }
+
+    /* Setup stage: where the data lands, data stage: apply it */
+    if (request->isSetup == 1U)
+    {
+        request->buffer = (uint8_t *)((NULL != control->setCur) ? control->setCur : control->cur);
+        request->buffer += channel * control->curLength;
+        request->length = control->curLength;
+        return kStatus_USB_Success;
+    }
+
+    return (NULL != control->set) ? control->set(channel) : kStatus_USB_Success;
 }
 
 /*!
@@ -530,12 +771,16 @@ usb_status_t USB_DeviceAudioCallback(class_handle_t handle, uint32_t event, void
     usb_device_endpoint_callback_message_struct_t *ep_cb_param;
     ep_cb_param = (usb_device_endpoint_callback_message_struct_t *)param;
     uint32_t length = 0U;
+    uint8_t *buffer;
+
+    PROF_BEGIN(kPROF_AudioCallback);
 
     switch (event)
     {
     case kUSB_DeviceAudioEventStreamSendResponse:
         if ((0U != g_audioDevice.attach) && (ep_cb_param->length != (USB_CANCELLED_TRANSFER_LENGTH)))
         {
+#if !USB_AUDIO_SYNC_MODE
             if (ep_cb_param->length == g_audioDevice.feedbackPacketSize)
             {
                 *((uint32_t *)&usbAudioFeedBackBuffer[0]) = USB_GetFeedback(g_audioDevice.speed);
@@ -545,10 +790,13 @@ usb_status_t USB_DeviceAudioCallback(class_handle_t handle, uint32_t event, void
                                     USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE);
             }
             else
+#endif
             {
-                length = USB_AudioI2s2UsbBuffer(g_usbBuffIn, g_audioDevice.streamInPacketSize);
+                USB_IsoLatencyIn();
+
+                length = USB_AudioI2s2UsbBuffer(&buffer, g_audioDevice.streamInPacketSize);
                 error = USB_DeviceAudioSend(handle, USB_AUDIO_STREAM_IN_ENDPOINT,
-                                            g_usbBuffIn, length,
+                                            buffer, length,
                                             USB_AUDIO_STREAM_IN_ENDPOINT_TYPE);
             }
         }
@@ -557,20 +805,122 @@ usb_status_t USB_DeviceAudioCallback(class_handle_t handle, uint32_t event, void
     case kUSB_DeviceAudioEventStreamRecvResponse:
         if ((0U != g_audioDevice.attach) && (ep_cb_param->length != (USB_CANCELLED_TRANSFER_LENGTH)))
         {
-            USB_AudioUsb2I2sBuffer(g_usbBuffOut, ep_cb_param->length);
-            error = USB_DeviceAudioRecv(handle, USB_AUDIO_STREAM_OUT_ENDPOINT,
-                                        g_usbBuffOut, g_audioDevice.streamOutPacketSize,
-                                        USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE);
+            USB_AudioUsb2I2sBuffer(ep_cb_param->buffer, ep_cb_param->length);
+            /* More than one once the I2S TX side is started (see USB_AudioUsb2I2sNextBuffer()) */
+            while (NULL != (buffer = USB_AudioUsb2I2sNextBuffer()))
+            {
+                error = USB_DeviceAudioRecv(handle, USB_AUDIO_STREAM_OUT_ENDPOINT,
+                                            buffer, g_audioDevice.streamOutPacketSize,
+                                            USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE);
+                if (kStatus_USB_Success != error)
+                {
+                    break;
+                }
+            }
         }
         break;
 
+    case kUSB_DeviceAudioEventControlRequest:
+        error = USB_DeviceAudioRequest(handle, event, param);
+        break;
+
     default:
-        if ((NULL != param) && (event > 0xFFU))
+        break;
+    }
+
+    PROF_END(kPROF_AudioCallback);
+
+    return error;
+}
+
+/*!
+ * @brief USB vendor requests.
+ *
+ * Called on the setup stage of the vendor requests, see USB_VENDOR_REQUEST_*,
+ * and again on the data stage of the OUT ones. The requests not handled here
+ * stall the control endpoint.
+ *
+ * @param request          The control request.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+static usb_status_t USB_DeviceVendorRequest(usb_device_control_request_struct_t *request)
+{
+    usb_status_t error = kStatus_USB_InvalidRequest;
+    bool in = ((request->setup->bmRequestType & USB_REQUEST_TYPE_DIR_MASK) == USB_REQUEST_TYPE_DIR_IN);
+
+    if (0U == request->isSetup)
+    {
+        /* Data stage of the OUT requests */
+        if ((USB_VENDOR_REQUEST_ROUTE_SET == request->setup->bRequest) && (sizeof(s_routeMap) == request->length))
         {
-            error = USB_DeviceAudioRequest(handle, event, param);
+            bool valid = (USB_VENDOR_ROUTE_IN == request->setup->wIndex) ? USB_AudioI2s2UsbSetRoute(s_routeMap)
+                                                                         : USB_AudioUsb2I2sSetRoute(s_routeMap);
+
+            error = valid ? kStatus_USB_Success : kStatus_USB_InvalidRequest;
         }
+
+        return error;
+    }
+
+    switch (request->setup->bRequest)
+    {
+    case USB_VENDOR_REQUEST_ROUTE_GET:
+        if (in && (request->setup->wIndex <= USB_VENDOR_ROUTE_OUT))
+        {
+            if (USB_VENDOR_ROUTE_IN == request->setup->wIndex)
+            {
+                USB_AudioI2s2UsbGetRoute(s_routeMap);
+            }
+            else
+            {
+                USB_AudioUsb2I2sGetRoute(s_routeMap);
+            }
+            request->buffer = s_routeMap;
+            request->length = sizeof(s_routeMap);
+            if (request->length > request->setup->wLength)
+            {
+                request->length = request->setup->wLength;
+            }
+            error = kStatus_USB_Success;
+        }
+        break;
+    case USB_VENDOR_REQUEST_ROUTE_SET:
+        if (!in && (request->setup->wIndex <= USB_VENDOR_ROUTE_OUT) && (sizeof(s_routeMap) == request->setup->wLength))
+        {
+            request->buffer = s_routeMap;
+            request->length = sizeof(s_routeMap);
+            error = kStatus_USB_Success;
+        }
+        break;
+#if PROF_ENABLE
+    case USB_VENDOR_REQUEST_PROF_GET:
+        if (in && (request->setup->wIndex < kPROF_Count))
+        {
+            PROF_Get((prof_probe_t)request->setup->wIndex, &s_profSnapshot);
+            request->buffer = (uint8_t *)&s_profSnapshot;
+            request->length = sizeof(s_profSnapshot);
+            if (request->length > request->setup->wLength)
+            {
+                request->length = request->setup->wLength;
+            }
+            error = kStatus_USB_Success;
+        }
+        break;
+    case USB_VENDOR_REQUEST_PROF_RESET:
+        if (0U == request->setup->wLength)
+        {
+            PROF_Reset();
+            request->length = 0U;
+            error = kStatus_USB_Success;
+        }
+        break;
+#endif
+    default:
+        /* no action */
         break;
     }
+
     return error;
 }
 
@@ -591,6 +941,7 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
     uint8_t *temp8 = (uint8_t *)param;
     uint16_t *temp16 = (uint16_t *)param;
     uint8_t count = 0U;
+    OSA_SR_ALLOC();
 
     switch (event)
     {
@@ -604,6 +955,9 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
         g_audioDevice.attach = 0U;
         g_audioDevice.currentConfiguration = 0U;
         error = kStatus_USB_Success;
+#if USB_AUDIO_SYNC_MODE
+        SYNC_Stop();
+#endif
 #if (defined(USB_DEVICE_CONFIG_EHCI) && (USB_DEVICE_CONFIG_EHCI > 0U)) || \
     (defined(USB_DEVICE_CONFIG_LPCIP3511HS) && (USB_DEVICE_CONFIG_LPCIP3511HS > 0U))
         /* Get USB speed to configure the device, including max packet size and interval of the endpoints. */
@@ -626,6 +980,9 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
             g_audioDevice.attach = 0U;
             g_audioDevice.currentConfiguration = 0U;
             error = kStatus_USB_Success;
+#if USB_AUDIO_SYNC_MODE
+            SYNC_Stop();
+#endif
         }
         else if (USB_AUDIO_CONFIGURE_INDEX == (*temp8))
         {
@@ -633,6 +990,10 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
             g_audioDevice.attach = 1U;
             g_audioDevice.currentConfiguration = *temp8;
             error = kStatus_USB_Success;
+#if USB_AUDIO_SYNC_MODE
+            /* The SOF is running from now on, lock the Audio PLL to it */
+            SYNC_Start(g_audioDevice.speed);
+#endif
         }
         else
         {
@@ -646,6 +1007,7 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
             uint8_t interface = (uint8_t)((*temp16 & 0xFF00U) >> 0x08U);
             uint8_t alternateSetting = (uint8_t)(*temp16 & 0x00FFU);
             uint32_t length = 0U;
+            uint8_t *buffer;
 
             if (USB_AUDIO_CONTROL_INTERFACE_INDEX == interface)
             {
@@ -661,17 +1023,48 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
                 {
                     g_audioDevice.currentInterfaceAlternateSetting[interface] = alternateSetting;
                     error = kStatus_USB_Success;
-                    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_1 == alternateSetting)
+                    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 != alternateSetting)
                     {
+                        /**
+                         * With USB_DEVICE_CONFIG_CONTROL_TASK we are in the device task: the DMA
+                         * callbacks must not run on the ring while it is set up and started, and
+                         * the first completion (interrupt) must not refill the class queue while
+                         * we are still filling it (one packet is refilled on each completion).
+                         */
+                        OSA_ENTER_CRITICAL();
+
+                        /* The I2S side always runs the full TDM frame, the alternate setting selects the USB format */
+                        g_audioDevice.streamInPacketSize =
+                            USB_DeviceGetStreamPacketSize(g_audioDevice.speed, alternateSetting, g_audioDevice.curSampleFrequency);
+                        USB_AudioI2s2UsbSetFormat(USB_DeviceGetStreamChannels(alternateSetting),
+                                                  USB_DeviceGetStreamSubslotSize(alternateSetting));
+                        USB_AudioI2s2UsbSetInterval(USB_DeviceGetStreamUframes(g_audioDevice.speed, alternateSetting));
+
                         I2S_RxStart();
 
-                        length = USB_AudioI2s2UsbBuffer(g_usbBuffIn, g_audioDevice.streamInPacketSize);
-                        error = USB_DeviceAudioSend(g_audioDevice.audioHandle, USB_AUDIO_STREAM_IN_ENDPOINT,
-                                                    g_usbBuffIn, length, USB_AUDIO_STREAM_IN_ENDPOINT_TYPE);
+                        s_isoLatency.inLast = 0U;
+
+                        for (uint32_t k = 0; k < USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH; k++)
+                        {
+                            length = USB_AudioI2s2UsbBuffer(&buffer, g_audioDevice.streamInPacketSize);
+                            error = USB_DeviceAudioSend(g_audioDevice.audioHandle, USB_AUDIO_STREAM_IN_ENDPOINT,
+                                                        buffer, length, USB_AUDIO_STREAM_IN_ENDPOINT_TYPE);
+                            if (kStatus_USB_Success != error)
+                            {
+                                break;
+                            }
+                        }
+                        OSA_EXIT_CRITICAL();
+
+                        APP_PostEvent(kAPP_EventStreamStart, *temp16);
                     }
                     else
                     {
+                        OSA_ENTER_CRITICAL();
                         I2S_RxStop();
+                        OSA_EXIT_CRITICAL();
+
+                        APP_PostEvent(kAPP_EventStreamStop, *temp16);
                     }
                 }
             }
@@ -681,22 +1074,48 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
                 {
                     g_audioDevice.currentInterfaceAlternateSetting[interface] = alternateSetting;
                     error = kStatus_USB_Success;
-                    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_1 == alternateSetting)
+                    if (USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 != alternateSetting)
                     {
+                        /* Set up, start and prime in one go (see above) */
+                        OSA_ENTER_CRITICAL();
+
+                        g_audioDevice.streamOutPacketSize =
+                            USB_DeviceGetStreamPacketSize(g_audioDevice.speed, alternateSetting, g_audioDevice.curSampleFrequency);
+                        USB_AudioUsb2I2sSetFormat(USB_DeviceGetStreamChannels(alternateSetting),
+                                                  USB_DeviceGetStreamSubslotSize(alternateSetting));
+                        USB_AudioUsb2I2sSetInterval(USB_DeviceGetStreamUframes(g_audioDevice.speed, alternateSetting));
+
                         I2S_TxStart();
 
-                        error = USB_DeviceAudioRecv(g_audioDevice.audioHandle, USB_AUDIO_STREAM_OUT_ENDPOINT,
-                                                    g_usbBuffOut, g_audioDevice.streamOutPacketSize,
-                                                    USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE);
+                        /* Queue as many receives as the I2S TX side has buffers for */
+                        while (NULL != (buffer = USB_AudioUsb2I2sNextBuffer()))
+                        {
+                            error = USB_DeviceAudioRecv(g_audioDevice.audioHandle, USB_AUDIO_STREAM_OUT_ENDPOINT,
+                                                        buffer, g_audioDevice.streamOutPacketSize,
+                                                        USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE);
+                            if (kStatus_USB_Success != error)
+                            {
+                                break;
+                            }
+                        }
 
+#if !USB_AUDIO_SYNC_MODE
                         *((uint32_t *)&usbAudioFeedBackBuffer[0]) = USB_GetFeedback(g_audioDevice.speed);
                         USB_DeviceAudioSend(g_audioDevice.audioHandle,
                                             USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT, usbAudioFeedBackBuffer,
                                             g_audioDevice.feedbackPacketSize, USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE);
+#endif
+                        OSA_EXIT_CRITICAL();
+
+                        APP_PostEvent(kAPP_EventStreamStart, *temp16);
                     }
                     else
                     {
+                        OSA_ENTER_CRITICAL();
                         I2S_TxStop();
+                        OSA_EXIT_CRITICAL();
+
+                        APP_PostEvent(kAPP_EventStreamStop, *temp16);
                     }
                 }
             }
@@ -747,6 +1166,12 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
             error = USB_DeviceGetStringDescriptor(handle, (usb_device_get_string_descriptor_struct_t *)param);
         }
         break;
+    case kUSB_DeviceEventVendorRequest:
+        if (NULL != param)
+        {
+            error = USB_DeviceVendorRequest((usb_device_control_request_struct_t *)param);
+        }
+        break;
     default:
         /* no action */
         break;
@@ -769,6 +1194,14 @@ void USB_DeviceApplicationInit(void)
     SYSMPU_Enable(SYSMPU, 0);
 #endif /* FSL_FEATURE_SOC_SYSMPU_COUNT */
 
+#if USB_DEVICE_CONFIG_CONTROL_TASK
+    if (kStatus_USB_Success != USB_DeviceControlTaskInit())
+    {
+        usb_echo("USB control task init failed\r\n");
+        return;
+    }
+#endif
+
     if (kStatus_USB_Success != USB_DeviceClassInit(CONTROLLER_ID, &s_audioConfigList, &g_audioDevice.deviceHandle))
     {
         usb_echo("USB device failed\r\n");
@@ -787,20 +1220,107 @@ void USB_DeviceApplicationInit(void)
     USB_DeviceRun(g_audioDevice.deviceHandle);
 }
 
-#if USB_DEVICE_CONFIG_USE_TASK
+#if USB_DEVICE_CONFIG_USE_TASK || USB_DEVICE_CONFIG_CONTROL_TASK
 void USBDeviceTask(void *handle)
 {
     while (1U)
     {
+#if USB_DEVICE_CONFIG_USE_TASK
         USB_DeviceTaskFn(handle);
+#else
+        USB_DeviceControlTaskFunction();
+#endif
     }
 }
 #endif
 
+#if TRACE_ENABLE
+/*!
+ * @brief Trace task function.
+ *
+ * Drains the trace on the debug console. The console is slow and blocking so
+ * this only runs when all the other tasks are idle.
+ */
+static void TraceTask(void *handle)
+{
+    while (1U)
+    {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_PERIOD_MS));
+        TRACE_Drain(SystemCoreClock);
+    }
+}
+#endif
+
+/*!
+ * @brief Application event handler.
+ *
+ * The streams are started / stopped (and the ISO queues primed) by the USB
+ * callbacks, in lock-step with the endpoints of the audio class. What is left
+ * here is everything that does not need to run in the interrupt context.
+ */
+static void APP_HandleEvent(const app_event_t *event)
+{
+    switch (event->type)
+    {
+    case kAPP_EventStreamStart:
+        TRACE(kTRACE_StreamStart, event->arg);
+        usb_echo("[APP] interface %" PRIu32 ": alternate setting %" PRIu32 "\r\n", (event->arg >> 8U) & 0xFFU,
+                 event->arg & 0xFFU);
+        break;
+    case kAPP_EventStreamStop:
+        TRACE(kTRACE_StreamStop, event->arg);
+        usb_echo("[APP] interface %" PRIu32 ": stopped\r\n", (event->arg >> 8U) & 0xFFU);
+        break;
+    case kAPP_EventRateChange:
+        /* Only the 44.1 kHz / 48 kHz family switches move the PLL */
+#if USB_AUDIO_SYNC_MODE
+        SYNC_SetRate(event->arg);
+#else
+        BOARD_SetAudioPllRate(event->arg);
+#endif
+        usb_echo("[APP] sampling frequency %" PRIu32 " Hz\r\n", event->arg);
+        break;
+    case kAPP_EventStats:
+#if !TRACE_ENABLE
+        /* Otherwise the levels are in the trace */
+        USB_OutPrintInfo();
+        USB_InPrintInfo();
+#endif
+#if USB_AUDIO_SYNC_MODE
+        SYNC_PrintInfo();
+#endif
+        USB_IsoLatencyFlush();
+#if PROF_ENABLE
+        PROF_Print();
+#endif
+        break;
+    case kAPP_EventWork:
+        if (NULL != event->work)
+        {
+            event->work(event->arg);
+        }
+        break;
+    default:
+        /* no action */
+        break;
+    }
+}
+
+/*!
+ * @brief Idle hook.
+ *
+ * Nothing to do until the next interrupt: sleep instead of spinning.
+ */
+void vApplicationIdleHook(void)
+{
+    __WFI();
+}
+
 /*!
  * @brief Application task function.
  *
- * This function runs the task for application.
+ * This function runs the task for application: an event loop blocked on the
+ * application queue, the CPU goes idle when nothing is pending.
  *
  * @return None.
  */
@@ -808,15 +1328,15 @@ void APPTask(void *handle)
 {
     USB_DeviceApplicationInit();
 
-#if USB_DEVICE_CONFIG_USE_TASK
+#if USB_DEVICE_CONFIG_USE_TASK || USB_DEVICE_CONFIG_CONTROL_TASK
     if (g_audioDevice.deviceHandle)
     {
-        if (xTaskCreate(USBDeviceTask,                  /* pointer to the task */
-                        "usb device task",              /* task name for kernel awareness debugging */
-                        5000L / sizeof(portSTACK_TYPE), /* task stack size */
-                        g_audioDevice.deviceHandle,     /* optional task startup argument */
-                        5,                              /* initial priority */
-                        &g_audioDevice.deviceTaskHandle /* optional task handle to create */
+        if (xTaskCreate(USBDeviceTask,                                       /* pointer to the task */
+                        "usb device task",                                   /* task name for kernel awareness debugging */
+                        USB_DEVICE_TASK_STACK_SIZE / sizeof(portSTACK_TYPE), /* task stack size */
+                        g_audioDevice.deviceHandle,                          /* optional task startup argument */
+                        USB_DEVICE_TASK_PRIORITY,                            /* initial priority */
+                        &g_audioDevice.deviceTaskHandle                      /* optional task handle to create */
                         ) != pdPASS)
         {
             usb_echo("usb device task create failed!\r\n");
@@ -827,6 +1347,12 @@ void APPTask(void *handle)
 
     while (1)
     {
+        app_event_t event;
+
+        if (pdPASS == xQueueReceive(s_appEventQueue, &event, portMAX_DELAY))
+        {
+            APP_HandleEvent(&event);
+        }
     }
 }
 
@@ -837,8 +1363,7 @@ void APPTask(void *handle)
 
 static void SwTimerCallback(TimerHandle_t xTimer)
 {
-    USB_OutPrintInfo();
-    USB_InPrintInfo();
+    APP_PostEvent(kAPP_EventStats, 0U);
 }
 #endif /* ENABLE_DEBUG_TIMER */
 
@@ -853,8 +1378,24 @@ void main(void)
     BOARD_InitDebugConsole();
     SystemCoreClockUpdate();
 
+    /* Cycle counter for the ISO latency statistics, the profiler and the trace */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     CLOCK_EnableClock(kCLOCK_InputMux);
 
+    s_appEventQueue = xQueueCreate(APP_EVENT_QUEUE_LENGTH, sizeof(app_event_t));
+    if (NULL == s_appEventQueue)
+    {
+        usb_echo("app queue create failed!\r\n");
+#if (defined(__CC_ARM) || (defined(__ARMCC_VERSION)) || defined(__GNUC__))
+        return 1U;
+#else
+        return;
+#endif
+    }
+
 #if defined(ENABLE_DEBUG_TIMER) && (ENABLE_DEBUG_TIMER > 0U)
     TimerHandle_t SwTimerHandle = NULL;
 
@@ -867,6 +1408,12 @@ void main(void)
 #endif
 
     BOARD_I2S_Init();
+#if I2S_MASTER
+    USB_DeviceAudioTrimRates();
+#endif
+#if USB_AUDIO_SYNC_MODE
+    SYNC_Init();
+#endif
 
     BOARD_I2S_RxInit();
     BOARD_I2S_TxInit();
@@ -886,6 +1433,20 @@ void main(void)
         return;
 #endif
     }
+
+#if TRACE_ENABLE
+    if (xTaskCreate(TraceTask,                                      /* pointer to the task */
+                    "trace task",                                   /* task name for kernel awareness debugging */
+                    TRACE_TASK_STACK_SIZE / sizeof(portSTACK_TYPE), /* task stack size */
+                    NULL,                                           /* optional task startup argument */
+                    TRACE_TASK_PRIORITY,                            /* initial priority */
+                    NULL                                            /* optional task handle to create */
+                    ) != pdPASS)
+    {
+        usb_echo("trace task create failed!\r\n");
+    }
+#endif
+
     vTaskStartScheduler();
 
 #if (defined(__CC_ARM) || (defined(__ARMCC_VERSION)) || defined(__GNUC__))
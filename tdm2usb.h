@@ -10,6 +10,7 @@
 
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "queue.h"
 #include "event_groups.h"
 
 /*******************************************************************************
@@ -49,6 +50,151 @@
 
 #define DATA_BUFF_SIZE (AUDIO_ENDPOINT_PACKET_SIZE)
 
+/**
+ * Device task (USB_DEVICE_CONFIG_USE_TASK or USB_DEVICE_CONFIG_CONTROL_TASK).
+ *
+ * Above the application task so that the control requests are never held back
+ * by the application work. Servicing only the control pipe needs much less
+ * stack than the whole notification path (see the high-water mark printed with
+ * the statistics).
+ */
+#define USB_DEVICE_TASK_PRIORITY (5U)
+#if defined(USB_DEVICE_CONFIG_CONTROL_TASK) && (USB_DEVICE_CONFIG_CONTROL_TASK > 0U)
+#define USB_DEVICE_TASK_STACK_SIZE (2048U)
+#else
+#define USB_DEVICE_TASK_STACK_SIZE (5000U)
+#endif
+
+/**
+ * Trace task (TRACE_ENABLE), right above the idle task so that draining the
+ * trace on the console never delays anything else.
+ */
+#define TRACE_TASK_PRIORITY (1U)
+#define TRACE_TASK_STACK_SIZE (1024U)
+
+/**
+ * Vendor requests, recipient device.
+ *
+ * PROF_GET     (bmRequestType 0xC0) wIndex is the probe (prof_probe_t), the
+ *              data stage is its prof_stats_t.
+ * PROF_RESET   (bmRequestType 0x40) no data stage, clear all the probes.
+ *
+ * Only with PROF_ENABLE, stalled otherwise.
+ *
+ * ROUTE_GET    (bmRequestType 0xC0) wIndex is the direction
+ *              (USB_VENDOR_ROUTE_*), the data stage is its routing map.
+ * ROUTE_SET    (bmRequestType 0x40) wIndex is the direction, the data stage
+ *              is the new routing map. Stalled when the map is not valid.
+ *
+ * The routing map is I2S_CH_NUM bytes, one per destination with the index of
+ * its source or 0xFF for silence: the TDM slot of each USB channel for
+ * USB_VENDOR_ROUTE_IN, the USB channel of each TDM slot for
+ * USB_VENDOR_ROUTE_OUT.
+ */
+#define USB_VENDOR_REQUEST_PROF_GET (0x01U)
+#define USB_VENDOR_REQUEST_PROF_RESET (0x02U)
+#define USB_VENDOR_REQUEST_ROUTE_GET (0x03U)
+#define USB_VENDOR_REQUEST_ROUTE_SET (0x04U)
+
+#define USB_VENDOR_ROUTE_IN (0U)
+#define USB_VENDOR_ROUTE_OUT (1U)
+
+/**
+ * Depth of the application event queue [16 events]
+ */
+#define APP_EVENT_QUEUE_LENGTH (16U)
+
+/* Events handled by the application task */
+typedef enum _app_event_type
+{
+    kAPP_EventStreamStart = 0U, /* arg: (interface << 8) | alternate setting */
+    kAPP_EventStreamStop,       /* arg: (interface << 8) */
+    kAPP_EventRateChange,       /* arg: sampling frequency [Hz] */
+    kAPP_EventStats,            /* Flush the statistics on the console */
+    kAPP_EventWork,             /* Run work(arg) in the application task */
+} app_event_type_t;
+
+typedef void (*app_work_t)(uint32_t arg);
+
+/**
+ * GET RANGE of the sampling frequency control (layout 3), one discrete rate
+ * per subrange.
+ */
+STRUCT_PACKED
+struct _usb_audio_freq_subrange
+{
+    uint32_t wMIN;
+    uint32_t wMAX;
+    uint32_t wRES;
+} STRUCT_UNPACKED;
+typedef struct _usb_audio_freq_subrange usb_audio_freq_subrange_t;
+
+STRUCT_PACKED
+struct _usb_audio_freq_range
+{
+    uint16_t wNumSubRanges;
+    usb_audio_freq_subrange_t subrange[AUDIO_SAMPLING_RATE_COUNT];
+} STRUCT_UNPACKED;
+typedef struct _usb_audio_freq_range usb_audio_freq_range_t;
+
+/**
+ * GET RANGE of the volume control (layout 2), a single subrange.
+ */
+STRUCT_PACKED
+struct _usb_audio_volume_range
+{
+    uint16_t wNumSubRanges;
+    int16_t wMIN;
+    int16_t wMAX;
+    int16_t wRES;
+} STRUCT_UNPACKED;
+typedef struct _usb_audio_volume_range usb_audio_volume_range_t;
+
+/**
+ * Controls of a feature unit, the master (0) and then one per channel. The
+ * volume is in 1/256 dB, the master adds up with the channel.
+ */
+typedef struct _usb_audio_feature
+{
+    int16_t volume[USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U];
+    uint8_t mute[USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U];
+} usb_audio_feature_t;
+
+/* Permissions of an audio class control (GET RANGE is allowed when it has a range) */
+#define USB_AUDIO_CONTROL_GET (0x01U)
+#define USB_AUDIO_CONTROL_SET (0x02U)
+
+/**
+ * Audio class control, one per entity ID and control selector. GET CUR reads
+ * cur, GET RANGE reads range. SET CUR lands in setCur (cur when NULL) and
+ * set() is called on the data stage, to validate and apply it.
+ *
+ * A control with more than one channel has an array of channels values for
+ * cur and setCur (curLength each), indexed by the channel number. The range is
+ * the same for all of them: wNumSubRanges and as many subranges of
+ * subrangeLength bytes, only the ones in use are returned.
+ */
+typedef struct _usb_audio_control
+{
+    uint8_t entityId;
+    uint8_t controlSelector;
+    uint8_t access;   /* USB_AUDIO_CONTROL_GET / USB_AUDIO_CONTROL_SET */
+    uint8_t channels; /* Master only: 1 */
+    uint8_t curLength;
+    uint8_t subrangeLength;
+    void *cur;
+    void *setCur;
+    const void *range;
+    usb_status_t (*set)(uint8_t channel);
+} usb_audio_control_t;
+
+typedef struct _app_event
+{
+    app_event_type_t type;
+    uint32_t arg;
+    app_work_t work;
+} app_event_t;
+
 /* Define the types for application */
 typedef struct _usb_audio_device_struct
 {
@@ -59,44 +205,23 @@ typedef struct _usb_audio_device_struct
     uint32_t streamInPacketSize;
     uint32_t streamOutPacketSize;
     uint32_t feedbackPacketSize;
-    uint8_t copyProtect;
-    uint8_t curMute;
-    uint8_t curVolume[2]; /* need to consider the endians */
-    uint8_t minVolume[2]; /* need to consider the endians */
-    uint8_t maxVolume[2]; /* need to consider the endians */
-    uint8_t resVolume[2]; /* need to consider the endians */
-    uint8_t curBass;
-    uint8_t minBass;
-    uint8_t maxBass;
-    uint8_t resBass;
-    uint8_t curMid;
-    uint8_t minMid;
-    uint8_t maxMid;
-    uint8_t resMid;
-    uint8_t curTreble;
-    uint8_t minTreble;
-    uint8_t maxTreble;
-    uint8_t resTreble;
-    uint8_t curAutomaticGain;
-    uint8_t curDelay[4]; /* need to consider the endians */
-    uint8_t minDelay[4]; /* need to consider the endians */
-    uint8_t maxDelay[4]; /* need to consider the endians */
-    uint8_t resDelay[4]; /* need to consider the endians */
-    uint8_t curLoudness;
-    uint8_t curSamplingFrequency[3]; /* need to consider the endians */
-    uint8_t minSamplingFrequency[3]; /* need to consider the endians */
-    uint8_t maxSamplingFrequency[3]; /* need to consider the endians */
-    uint8_t resSamplingFrequency[3]; /* need to consider the endians */
-    uint8_t curMute20;
     uint8_t curClockValid;
-    uint8_t curVolume20[2];
     uint32_t curSampleFrequency;
-    usb_device_control_range_layout3_struct_t freqControlRange;
-    usb_device_control_range_layout2_struct_t volumeControlRange;
+    uint32_t setSampleFrequency; /* Data stage of SET_CUR, validated before use */
+    usb_audio_freq_range_t freqControlRange;
+    usb_audio_feature_t inFeature;  /* Capture, TDM -> USB */
+    usb_audio_feature_t outFeature; /* Playback, USB -> TDM */
+    usb_audio_volume_range_t volumeControlRange;
     uint8_t currentConfiguration;
     uint8_t currentInterfaceAlternateSetting[USB_AUDIO_INTERFACE_COUNT];
     uint8_t speed;
     uint8_t attach;
 } usb_audio_device_struct_t;
 
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+bool APP_PostEvent(app_event_type_t type, uint32_t arg);
+bool APP_DeferWork(app_work_t work, uint32_t arg);
+
 #endif /* __USB_AUDIO_H__ */
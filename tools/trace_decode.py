@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+# All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Decoder of the binary trace drained on the debug console (see trace.h).
+#
+#   ./tools/trace_decode.py console.log > trace.csv
+#   ./tools/trace_decode.py --plot console.log
+#
+# Every "[TRC] " line carries up to 8 records of 24 hex digits each:
+# time (8), seq (4), event (4), value (8). Everything else in the log is
+# ignored, as are the lines garbled by another task printing at the same time.
+
+import argparse
+import csv
+import re
+import sys
+
+# Keep in sync with trace_event_t
+EVENTS = [
+    "clock",
+    "dropped",
+    "stream_start",
+    "stream_stop",
+    "rx_level",
+    "tx_level",
+    "rx_underrun",
+    "rx_overrun",
+    "tx_underrun",
+    "tx_overrun",
+    "rx_feedback",
+    "tx_feedback",
+    "rx_reset",
+]
+
+SIGNED = {
+    "rx_level",
+    "tx_level",
+    "rx_underrun",
+    "rx_overrun",
+    "tx_underrun",
+    "tx_overrun",
+    "rx_feedback",
+}
+
+LINE = re.compile(r"\[TRC\] ((?:[0-9a-f]{24})+)\s*$")
+
+
+def parse(lines):
+    for line in lines:
+        m = LINE.search(line)
+        if not m:
+            continue
+        data = m.group(1)
+        for i in range(0, len(data), 24):
+            rec = data[i : i + 24]
+            yield (int(rec[0:8], 16), int(rec[8:12], 16), int(rec[12:16], 16), int(rec[16:24], 16))
+
+
+def decode(records):
+    records = list(records)
+
+    # The clock is traced at every drain, the first one also covers the
+    # records drained with it.
+    clock = next((value for _, _, event, value in records if event == 0), 0) or 1
+
+    out = []
+    lost = 0
+    last_seq = None
+    last_time = None
+    time = 0
+
+    for stamp, seq, event, value in records:
+        if last_seq is not None and seq != ((last_seq + 1) & 0xFFFF):
+            lost += (seq - last_seq - 1) & 0xFFFF
+        last_seq = seq
+
+        # Unwrap the 32-bit timestamps, the drain period keeps them close.
+        # The writers race with each other so small steps back are expected.
+        if last_time is not None:
+            delta = (stamp - last_time) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            time += delta
+        last_time = stamp
+
+        name = EVENTS[event] if event < len(EVENTS) else "event_%u" % event
+        if name == "clock":
+            clock = value or clock
+        if name in SIGNED and value >= 0x80000000:
+            value -= 0x100000000
+        if name == "tx_feedback":
+            value = value / 65536.0
+
+        out.append((time / clock, seq, name, value))
+
+    return out, lost
+
+
+def plot(rows):
+    import matplotlib.pyplot as plt
+
+    series = {}
+    for t, _, name, value in rows:
+        if name in ("rx_level", "tx_level", "rx_feedback", "tx_feedback"):
+            series.setdefault(name, ([], []))
+            series[name][0].append(t)
+            series[name][1].append(value)
+
+    fig, axes = plt.subplots(len(series), 1, sharex=True, squeeze=False)
+    for ax, (name, (t, v)) in zip(axes[:, 0], sorted(series.items())):
+        ax.step(t, v, where="post")
+        ax.set_ylabel(name)
+        for t2, _, event, _ in rows:
+            if event.endswith("run") or event == "rx_reset":
+                ax.axvline(t2, color="r", alpha=0.3)
+    axes[-1, 0].set_xlabel("time [s]")
+    plt.show()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the tdm2usb console trace into CSV")
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin)
+    parser.add_argument("-o", "--output", type=argparse.FileType("w"), default=sys.stdout)
+    parser.add_argument("-p", "--plot", action="store_true", help="plot the levels and the feedback")
+    args = parser.parse_args()
+
+    rows, lost = decode(parse(args.log))
+
+    writer = csv.writer(args.output)
+    writer.writerow(["time", "seq", "event", "value"])
+    for t, seq, name, value in rows:
+        writer.writerow(["%.6f" % t, seq, name, value])
+
+    if lost:
+        print("%u records lost" % lost, file=sys.stderr)
+
+    if args.plot:
+        plot(rows)
+
+
+if __name__ == "__main__":
+    main()
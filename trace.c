@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "usb_device_config.h"
+#include "usb.h"
+
+#include "trace.h"
+
+#if TRACE_ENABLE
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TRACE_LINE_PREFIX "[TRC] "
+
+/* Records per console line, 24 hex digits each */
+#define TRACE_LINE_RECORDS (8U)
+#define TRACE_RECORD_DIGITS (24U)
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+trace_ring_t g_trace;
+
+static char s_traceLine[sizeof(TRACE_LINE_PREFIX) + (TRACE_LINE_RECORDS * TRACE_RECORD_DIGITS)];
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static char *TRACE_Hex(char *p, uint32_t value, uint32_t digits)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    for (uint32_t i = digits; i > 0U; i--)
+    {
+        p[i - 1U] = hex[value & 0xFU];
+        value >>= 4U;
+    }
+
+    return p + digits;
+}
+
+/*!
+ * @brief Copy the oldest record out of the ring.
+ *
+ * A record can be overwritten while we copy it: the slot is reused as soon as
+ * a writer reserves the record TRACE_RING_LEN ahead, so we check head again
+ * once the copy is done.
+ *
+ * @return false when there is nothing to read, or the oldest record is still
+ *         being written.
+ */
+static bool TRACE_Read(trace_record_t *record)
+{
+    uint32_t head = g_trace.head;
+    const trace_record_t *slot;
+
+    if ((head - g_trace.tail) > TRACE_RING_LEN)
+    {
+        TRACE_Write(kTRACE_Dropped, head - g_trace.tail - TRACE_RING_LEN);
+        g_trace.tail = head - TRACE_RING_LEN;
+    }
+
+    if (g_trace.tail == head)
+    {
+        return false;
+    }
+
+    slot = &g_trace.records[g_trace.tail & (TRACE_RING_LEN - 1U)];
+
+    if (slot->seq != (uint16_t)(g_trace.tail + 1U))
+    {
+        return false;
+    }
+
+    __DMB();
+    *record = *slot;
+    __DMB();
+
+    if ((g_trace.head - g_trace.tail) > TRACE_RING_LEN)
+    {
+        return false;
+    }
+
+    g_trace.tail++;
+
+    return true;
+}
+
+/*!
+ * @brief Drain the ring on the debug console.
+ *
+ * Blocks on the console, only from a low priority task. clockHz is the rate
+ * of the timestamps, traced first so that the decoder can convert them.
+ */
+void TRACE_Drain(uint32_t clockHz)
+{
+    char *start = &s_traceLine[sizeof(TRACE_LINE_PREFIX) - 1U];
+    char *p = start;
+    trace_record_t record;
+
+    TRACE_Write(kTRACE_Clock, clockHz);
+
+    memcpy(s_traceLine, TRACE_LINE_PREFIX, sizeof(TRACE_LINE_PREFIX) - 1U);
+
+    while (TRACE_Read(&record))
+    {
+        p = TRACE_Hex(p, record.time, 8U);
+        p = TRACE_Hex(p, record.seq, 4U);
+        p = TRACE_Hex(p, record.event, 4U);
+        p = TRACE_Hex(p, record.value, 8U);
+
+        if (p == &start[TRACE_LINE_RECORDS * TRACE_RECORD_DIGITS])
+        {
+            *p = '\0';
+            usb_echo("%s\r\n", s_traceLine);
+            p = start;
+        }
+    }
+
+    if (p != start)
+    {
+        *p = '\0';
+        usb_echo("%s\r\n", s_traceLine);
+    }
+}
+
+#endif /* TRACE_ENABLE */
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023, Carlo Caione <ccaione@baylibre.com>
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__ 1
+
+#include "fsl_common.h"
+#include "fsl_device_registers.h"
+
+/**
+ * Binary trace of the streaming events.
+ *
+ * Every event is a fixed-size record (DWT timestamp, event, value) written in
+ * a RAM ring with TRACE_Write(), from any context. The writers reserve their
+ * record by incrementing head with an exclusive load / store, then fill it in
+ * and write seq last: a record is only valid once seq matches its index (the
+ * low bits of index + 1, so that the zeroed ring is not valid). Nothing is
+ * ever blocked: when the reader is too slow the oldest records are overwritten.
+ *
+ * The ring is drained by TRACE_Drain() from a low priority task, that prints
+ * the records in hex on the debug console ("[TRC] " lines, see
+ * tools/trace_decode.py to turn them into CSV).
+ *
+ * Set TRACE_ENABLE to (0) to compile the trace out and go back to the
+ * statistics printed by the debug timer.
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE (1)
+#endif
+
+/* Records in the ring, power of two [1024 records, 12 KB] */
+#define TRACE_RING_LEN (1024U)
+
+/**
+ * The sampled events (fill levels, feedback) are traced once every
+ * TRACE_SAMPLE_PERIOD_MS on the DMA buffer callbacks, whatever the sampling
+ * rate [20 ms, 200 records per second for the four of them]. The debug console
+ * at 115200 baud drains about 400 records per second, all the other events are
+ * traced every time.
+ */
+#define TRACE_SAMPLE_PERIOD_MS (20U)
+
+/* Drain period of the trace task [ms] */
+#define TRACE_DRAIN_PERIOD_MS (100U)
+
+/* Events, keep in sync with tools/trace_decode.py */
+typedef enum _trace_event
+{
+    kTRACE_Clock = 0U,   /* value: timestamp clock [Hz], once per drain */
+    kTRACE_Dropped,      /* value: records overwritten before being drained */
+    kTRACE_StreamStart,  /* value: (interface << 8) | alternate setting */
+    kTRACE_StreamStop,   /* value: (interface << 8) */
+    kTRACE_RxLevel,      /* value: RX fill level [frames], sampled */
+    kTRACE_TxLevel,      /* value: TX fill level [frames], sampled */
+    kTRACE_RxUnderrun,   /* value: RX fill level [frames] */
+    kTRACE_RxOverrun,    /* value: RX fill level [frames] */
+    kTRACE_TxUnderrun,   /* value: TX fill level [frames] */
+    kTRACE_TxOverrun,    /* value: TX fill level [frames] */
+    kTRACE_RxFeedback,   /* value: implicit feedback integrator, sampled */
+    kTRACE_TxFeedback,   /* value: explicit feedback [16.16 frames], sampled */
+    kTRACE_RxReset,      /* value: I2S instance with the frame error */
+    kTRACE_Count,
+} trace_event_t;
+
+typedef struct _trace_record
+{
+    uint32_t time;  /* DWT cycles */
+    uint16_t seq;   /* Low 16 bits of (record index + 1), written last */
+    uint16_t event; /* trace_event_t */
+    uint32_t value;
+} trace_record_t;
+
+typedef struct _trace_ring
+{
+    volatile uint32_t head; /* Records reserved by the writers */
+    uint32_t tail;          /* Records drained, reader only */
+    trace_record_t records[TRACE_RING_LEN];
+} trace_ring_t;
+
+#if TRACE_ENABLE
+#define TRACE(event, value) TRACE_Write((event), (uint32_t)(value))
+#else
+#define TRACE(event, value)
+#endif
+
+/*!
+ * @brief Time to trace the sampled events.
+ *
+ * last is the DWT timestamp of the previous sample, one per sampling point.
+ */
+static inline bool TRACE_Sample(uint32_t *last)
+{
+#if TRACE_ENABLE
+    uint32_t now = DWT->CYCCNT;
+
+    if ((now - *last) < ((SystemCoreClock / 1000U) * TRACE_SAMPLE_PERIOD_MS))
+    {
+        return false;
+    }
+
+    *last = now;
+
+    return true;
+#else
+    (void)last;
+
+    return false;
+#endif
+}
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+#if TRACE_ENABLE
+extern trace_ring_t g_trace;
+
+void TRACE_Drain(uint32_t clockHz);
+
+/*!
+ * @brief Write a record.
+ *
+ * Safe from any context, including the interrupts preempting another writer.
+ */
+static inline void TRACE_Write(trace_event_t event, uint32_t value)
+{
+    trace_record_t *record;
+    uint32_t index;
+
+    do
+    {
+        index = __LDREXW(&g_trace.head);
+    } while (__STREXW(index + 1U, &g_trace.head) != 0U);
+
+    record = &g_trace.records[index & (TRACE_RING_LEN - 1U)];
+    record->time = DWT->CYCCNT;
+    record->event = (uint16_t)event;
+    record->value = value;
+
+    __DMB();
+    record->seq = (uint16_t)(index + 1U);
+}
+#endif
+
+#endif /* __TRACE_H__ */
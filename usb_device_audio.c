@@ -37,34 +37,8 @@ usb_status_t USB_DeviceAudioStreamEndpointsInit(usb_device_audio_struct_t *audio
 usb_status_t USB_DeviceAudioStreamEndpointsDeinit(usb_device_audio_struct_t *audioHandle, uint8_t type);
 usb_status_t USB_DeviceAudioControlEndpointsInit(usb_device_audio_struct_t *audioHandle);
 usb_status_t USB_DeviceAudioControlEndpointsDeinit(usb_device_audio_struct_t *audioHandle);
-usb_status_t USB_DeviceAudioGetCurAudioFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                                   usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioSetCurAudioFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                                   usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioGetRangeAudioFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                                     usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioGetClockSource(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioSetClockSource(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioSetFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioSetRequestEndpoint(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioGetRequestEndpoint(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioSetControlTerminal(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest,
-                                               uint8_t terminal_type);
-usb_status_t USB_DeviceAudioGetControlTerminal(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest,
-                                               uint8_t terminal_type);
-usb_status_t USB_DeviceAudioGetFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioSetRequestInterface(usb_device_audio_struct_t *audioHandle,
-                                                usb_device_control_request_struct_t *controlRequest);
-usb_status_t USB_DeviceAudioGetRequestInterface(usb_device_audio_struct_t *audioHandle,
-                                                usb_device_control_request_struct_t *controlRequest);
+static usb_status_t USB_DeviceAudioControlRequest(usb_device_audio_struct_t *audioHandle,
+                                                  usb_device_control_request_struct_t *controlRequest);
 
 /*******************************************************************************
  * Variables
@@ -170,6 +144,93 @@ usb_status_t USB_DeviceAudioInterruptIn(usb_device_handle handle,
     return error;
 }
 
+/*!
+ * @brief Reset the transfer queue of an endpoint.
+ *
+ * @param queue           The transfer queue.
+ */
+static void USB_DeviceAudioQueueReset(usb_device_audio_queue_struct_t *queue)
+{
+    uint8_t slot;
+
+    for (slot = 0U; slot < USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH; slot++)
+    {
+        queue->isBusy[slot] = 0U;
+    }
+    queue->head = 0U;
+    queue->count = 0U;
+}
+
+/*!
+ * @brief Submit the transfer at the head of the queue to the controller.
+ *
+ * @param audioHandle     The device audio class handle.
+ * @param queue           The transfer queue.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+static usb_status_t USB_DeviceAudioQueueSubmit(usb_device_audio_struct_t *audioHandle,
+                                               usb_device_audio_queue_struct_t *queue)
+{
+    usb_device_audio_transfer_struct_t *transfer = &queue->transfer[queue->head];
+
+    if (USB_IN == ((queue->endpointAddress & USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_MASK) >>
+                   USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT))
+    {
+        return USB_DeviceSendRequest(audioHandle->handle, queue->endpointAddress, transfer->buffer, transfer->length);
+    }
+
+    return USB_DeviceRecvRequest(audioHandle->handle, queue->endpointAddress, transfer->buffer, transfer->length);
+}
+
+/*!
+ * @brief Queue a transfer on an endpoint.
+ *
+ * The transfer is submitted to the controller right away when the endpoint is idle, otherwise it is kept in the
+ * queue and submitted when the previous one is done.
+ *
+ * @param audioHandle     The device audio class handle.
+ * @param endpointAddress Endpoint address (number and direction).
+ * @param buffer          The transfer buffer.
+ * @param length          The transfer length.
+ * @param epType          Endpoint type.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+static usb_status_t USB_DeviceAudioQueueTransfer(usb_device_audio_struct_t *audioHandle,
+                                                 uint8_t endpointAddress,
+                                                 uint8_t *buffer,
+                                                 uint32_t length,
+                                                 uint8_t epType)
+{
+    usb_device_audio_queue_struct_t *queue = &audioHandle->queue[epType];
+    usb_status_t error = kStatus_USB_Success;
+    uint8_t slot;
+
+    if (queue->count >= USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH)
+    {
+        return kStatus_USB_Busy;
+    }
+
+    slot = (uint8_t)((queue->head + queue->count) % USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH);
+    queue->transfer[slot].buffer = buffer;
+    queue->transfer[slot].length = length;
+    queue->isBusy[slot] = 1U;
+    queue->endpointAddress = endpointAddress;
+    queue->count++;
+
+    if (1U == queue->count)
+    {
+        error = USB_DeviceAudioQueueSubmit(audioHandle, queue);
+        if (kStatus_USB_Success != error)
+        {
+            queue->isBusy[slot] = 0U;
+            queue->count--;
+        }
+    }
+    return error;
+}
+
 /*!
  * @brief ISO endpoint callback function.
  *
@@ -190,6 +251,7 @@ static usb_status_t USB_DeviceAudioIsochronous(usb_device_handle handle,
                                                uint8_t epType)
 {
     usb_device_audio_struct_t *audioHandle;
+    usb_device_audio_queue_struct_t *queue;
     usb_status_t status = kStatus_USB_Error;
     uint32_t callbackEvent;
 
@@ -199,7 +261,24 @@ static usb_status_t USB_DeviceAudioIsochronous(usb_device_handle handle,
     {
         return kStatus_USB_InvalidHandle;
     }
-    audioHandle->isBusy[epType] = 0U;
+    queue = &audioHandle->queue[epType];
+
+    /* The completed transfer is always the one at the head of the queue */
+    if (0U != queue->count)
+    {
+        queue->isBusy[queue->head] = 0U;
+        queue->head = (uint8_t)((queue->head + 1U) % USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH);
+        queue->count--;
+    }
+
+    /* Keep the endpoint busy: submit the next queued transfer before notifying the application */
+    if ((0U != queue->count) && (USB_CANCELLED_TRANSFER_LENGTH != message->length))
+    {
+        if (kStatus_USB_Success != USB_DeviceAudioQueueSubmit(audioHandle, queue))
+        {
+            USB_DeviceAudioQueueReset(queue);
+        }
+    }
 
     if (epType == USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE)
     {
@@ -392,6 +471,7 @@ usb_status_t USB_DeviceAudioStreamEndpointsDeinit(usb_device_audio_struct_t *aud
 {
     usb_status_t status = kStatus_USB_Error;
     usb_device_endpoint_callback_message_struct_t message;
+    usb_device_audio_queue_struct_t *queue;
     uint8_t count;
 
     if (NULL == audioHandle->streamInterfaceHandle[type])
@@ -414,8 +494,10 @@ usb_status_t USB_DeviceAudioStreamEndpointsDeinit(usb_device_audio_struct_t *aud
         {
             if (audioHandle->streamInterfaceHandle[type]->endpointList.endpoint[count].type == USB_AUDIO_STREAM_IN_ENDPOINT_TYPE)
             {
-                if (0U != audioHandle->isBusy[USB_AUDIO_STREAM_IN_ENDPOINT_TYPE])
+                queue = &audioHandle->queue[USB_AUDIO_STREAM_IN_ENDPOINT_TYPE];
+                while (0U != queue->count)
                 {
+                    message.buffer = queue->transfer[queue->head].buffer;
                     message.length = USB_CANCELLED_TRANSFER_LENGTH;
 #if (defined(USB_DEVICE_CONFIG_RETURN_VALUE_CHECK) && (USB_DEVICE_CONFIG_RETURN_VALUE_CHECK > 0U))
                     status = USB_DeviceAudioIsochronousIn(audioHandle->handle, &message, audioHandle);
@@ -426,8 +508,10 @@ usb_status_t USB_DeviceAudioStreamEndpointsDeinit(usb_device_audio_struct_t *aud
             }
             else
             {
-                if (0U != audioHandle->isBusy[USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE])
+                queue = &audioHandle->queue[USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE];
+                while (0U != queue->count)
                 {
+                    message.buffer = queue->transfer[queue->head].buffer;
                     message.length = USB_CANCELLED_TRANSFER_LENGTH;
 #if (defined(USB_DEVICE_CONFIG_RETURN_VALUE_CHECK) && (USB_DEVICE_CONFIG_RETURN_VALUE_CHECK > 0U))
                     status = USB_DeviceAudioIsochronousInFeedback(audioHandle->handle, &message, audioHandle);
@@ -439,8 +523,10 @@ usb_status_t USB_DeviceAudioStreamEndpointsDeinit(usb_device_audio_struct_t *aud
         }
         else
         {
-            if (0U != audioHandle->isBusy[USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE])
+            queue = &audioHandle->queue[USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE];
+            while (0U != queue->count)
             {
+                message.buffer = queue->transfer[queue->head].buffer;
                 message.length = USB_CANCELLED_TRANSFER_LENGTH;
 #if (defined(USB_DEVICE_CONFIG_RETURN_VALUE_CHECK) && (USB_DEVICE_CONFIG_RETURN_VALUE_CHECK > 0U))
                 status = USB_DeviceAudioIsochronousOut(audioHandle->handle, &message, audioHandle);
@@ -576,671 +662,30 @@ usb_status_t USB_DeviceAudioControlEndpointsDeinit(usb_device_audio_struct_t *au
 }
 
 /*!
- * @brief Handle the audio device GET CUR control feature unit request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetCurAudioFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                                   usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0U;
-
-    /* Select GET CUR request Control Feature Unit Module */
-    switch (controlSelector)
-    {
-    case USB_DEVICE_AUDIO_FU_MUTE_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_MUTE_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_VOLUME_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_VOLUME_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_BASS_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_BASS_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_MID_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_MID_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_TREBLE_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_TREBLE_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_GRAPHIC_EQUALIZER_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_GRAPHIC_EQUALIZER_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_AUTOMATIC_GAIN_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_AUTOMATIC_GAIN_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_DELAY_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_DELAY_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_BASS_BOOST_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_BASS_BOOST_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_LOUDNESS_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_CUR_LOUDNESS_CONTROL;
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-
-    return status;
-}
-
-/*!
- * @brief Handle the audio device SET CUR control feature unit request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioSetCurAudioFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                                   usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08U) & 0xFFU);
-    uint32_t audioCommand = 0;
-
-    /* Select SET CUR request Control Feature Unit Module */
-    switch (controlSelector)
-    {
-    case USB_DEVICE_AUDIO_FU_MUTE_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_MUTE_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_VOLUME_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_VOLUME_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_BASS_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_BASS_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_MID_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_MID_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_TREBLE_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_TREBLE_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_GRAPHIC_EQUALIZER_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_GRAPHIC_EQUALIZER_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_AUTOMATIC_GAIN_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_AUTOMATIC_GAIN_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_DELAY_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_DELAY_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_BASS_BOOST_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_BASS_BOOST_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_LOUDNESS_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_SET_CUR_LOUDNESS_CONTROL;
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device GET feature unit request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-
-    /* Select GET request Control Feature Unit Module */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        status = USB_DeviceAudioGetCurAudioFeatureUnit(audioHandle, controlRequest);
-        break;
-    case USB_DEVICE_AUDIO_RANGE_REQUEST:
-        status = USB_DeviceAudioGetRangeAudioFeatureUnit(audioHandle, controlRequest);
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device SET feature unit request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioSetFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    /* Select SET request Control Feature Unit Module */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        status = USB_DeviceAudioSetCurAudioFeatureUnit(audioHandle, controlRequest);
-        break;
-    case USB_DEVICE_AUDIO_RANGE_REQUEST:
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device GET RANGE control feature unit request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetRangeAudioFeatureUnit(usb_device_audio_struct_t *audioHandle,
-                                                     usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0U;
-
-    /* Select GET RANGE request Control Feature Unit Module */
-    switch (controlSelector)
-    {
-    case USB_DEVICE_AUDIO_FU_VOLUME_CONTROL_SELECTOR:
-        audioCommand = USB_DEVICE_AUDIO_FU_GET_RANGE_VOLUME_CONTROL;
-        break;
-    case USB_DEVICE_AUDIO_FU_BASS_CONTROL_SELECTOR:
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-
-    return status;
-}
-
-/*!
- * @brief Handle the audio device GET Clock Source control feature unit request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetClockSource(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0;
-    /* Select GET request Control Clock Source Module */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_CS_SAM_FREQ_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_CS_GET_CUR_SAMPLING_FREQ_CONTROL;
-            break;
-        case USB_DEVICE_AUDIO_CS_CLOCK_VALID_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_CS_GET_CUR_CLOCK_VALID_CONTROL;
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    case USB_DEVICE_AUDIO_RANGE_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_CS_SAM_FREQ_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_CS_GET_RANGE_SAMPLING_FREQ_CONTROL;
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device SET Clock Source control feature unit request.
+ * @brief Forward a class specific request to the application.
  *
- * This callback function provides flexibility to add class and vendor specific requests
+ * The caller has checked the recipient (an entity of the audio control
+ * interface or an endpoint of the function), the application looks the control
+ * up and stalls what it does not implement.
  *
  * @param audioHandle          The device audio class handle. It equals the value returned from
  * usb_device_class_config_struct_t::classHandle.
  * @param controlRequest       The pointer of the control request structure.
  *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioSetClockSource(usb_device_audio_struct_t *audioHandle,
-                                           usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0;
-    /* Select SET request Control Clock Source Module */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_CS_SAM_FREQ_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_CS_SET_CUR_SAMPLING_FREQ_CONTROL;
-            break;
-        case USB_DEVICE_AUDIO_CS_CLOCK_VALID_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_CS_SET_CUR_CLOCK_VALID_CONTROL;
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    case USB_DEVICE_AUDIO_RANGE_REQUEST:
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device SET request endpoint.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioSetRequestEndpoint(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0;
-
-    /* Select SET request Control for endpoint */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_EP_PITCH_CONTROL_SELECTOR_AUDIO20:
-            audioCommand = USB_DEVICE_AUDIO_EP_SET_CUR_PITCH_CONTROL_AUDIO20;
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device GET request endpoint.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetRequestEndpoint(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0;
-    /* Select GET request Control for endpoint */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_EP_DATA_OVERRUN_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_EP_GET_CUR_DATA_OVERRUN_CONTROL;
-            break;
-        case USB_DEVICE_AUDIO_EP_DATA_UNDERRUN_CONTROL_SELECTOR:
-            audioCommand = USB_DEVICE_AUDIO_EP_GET_CUR_DATA_UNDERRUN_CONTROL;
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device GET control terminal request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetControlTerminal(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest,
-                                               uint8_t terminal_type)
-{
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0;
-    /* Select GET request Control for endpoint */
-    switch (controlRequest->setup->bRequest)
-    {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_TE_COPY_PROTECT_CONTROL:
-            if (USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_INPUT_TERMINAL == terminal_type)
-            {
-                audioCommand = USB_DEVICE_AUDIO_TE_GET_CUR_COPY_PROTECT_CONTROL;
-            }
-            else
-            {
-                /* Input Terminals only support the Get Terminal Copy Protect Control request */
-            }
-            break;
-        case USB_DEVICE_AUDIO_TE_CONNECTOR_CONTROL:
-            audioCommand = USB_DEVICE_AUDIO_TE_GET_CUR_CONNECTOR_CONTROL;
-            break;
-        case USB_DEVICE_AUDIO_TE_OVERLOAD_CONTROL:
-            audioCommand = USB_DEVICE_AUDIO_TE_GET_CUR_OVERLOAD_CONTROL;
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
-    }
-
-    return status;
-}
-
-/*!
- * @brief Handle the audio device SET control terminal request.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- * @param terminal_type        The terminal type:: input terminal or output terminal
- *
  * @return A USB error code, kStatus_USB_Success or kStatus_USB_InvalidRequest.
  */
-usb_status_t USB_DeviceAudioSetControlTerminal(usb_device_audio_struct_t *audioHandle,
-                                               usb_device_control_request_struct_t *controlRequest,
-                                               uint8_t terminal_type)
+static usb_status_t USB_DeviceAudioControlRequest(usb_device_audio_struct_t *audioHandle,
+                                                  usb_device_control_request_struct_t *controlRequest)
 {
-    usb_status_t status = kStatus_USB_InvalidRequest;
-    uint8_t controlSelector = (uint8_t)((controlRequest->setup->wValue >> 0x08) & 0xFFU);
-    uint32_t audioCommand = 0;
-    /* Select GET request Control for endpoint */
-    switch (controlRequest->setup->bRequest)
+    if ((NULL == audioHandle->configStruct) || (NULL == audioHandle->configStruct->classCallback))
     {
-    case USB_DEVICE_AUDIO_CUR_REQUEST:
-        switch (controlSelector)
-        {
-        case USB_DEVICE_AUDIO_TE_COPY_PROTECT_CONTROL:
-            if (USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_OUTPUT_TERMINAL == terminal_type)
-            {
-                audioCommand = USB_DEVICE_AUDIO_TE_SET_CUR_COPY_PROTECT_CONTROL;
-            }
-            else
-            {
-                /* Output Terminals only support the Set Terminal Copy Protect Control request */
-            }
-            break;
-        default:
-            /*no action*/
-            break;
-        }
-        break;
-    default:
-        /*no action*/
-        break;
-    }
-
-    if ((0U != audioCommand) && (NULL != audioHandle->configStruct) &&
-        (NULL != audioHandle->configStruct->classCallback))
-    {
-        /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
-        it is from the second parameter of classInit */
-        status = audioHandle->configStruct->classCallback((class_handle_t)audioHandle, audioCommand, controlRequest);
+        return kStatus_USB_InvalidRequest;
     }
 
-    return status;
-}
-
-/*!
- * @brief Handle the audio device set request interface.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioSetRequestInterface(usb_device_audio_struct_t *audioHandle,
-                                                usb_device_control_request_struct_t *controlRequest)
-{
-    uint32_t i;
-    usb_device_audio_entities_struct_t *entity_list;
-    usb_status_t status = kStatus_USB_Error;
-    uint8_t entityId = (uint8_t)(controlRequest->setup->wIndex >> 0x08);
-
-    entity_list = (usb_device_audio_entities_struct_t *)audioHandle->controlInterfaceHandle->classSpecific;
-    for (i = 0; i < entity_list->count; i++)
-    {
-        if (entityId == entity_list->entity[i].entityId)
-        {
-            switch (entity_list->entity[i].entityType)
-            {
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_OUTPUT_TERMINAL:
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_INPUT_TERMINAL:
-                /*Select SET Request Control Input Terminal Module */
-                status = USB_DeviceAudioSetControlTerminal(audioHandle, controlRequest,
-                                                           entity_list->entity[i].entityType);
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_FEATURE_UNIT:
-                /* Select SET request Control Feature Unit Module */
-                status = USB_DeviceAudioSetFeatureUnit(audioHandle, controlRequest);
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_SOURCE_UNIT:
-                /* Select SET request Control Clock Source Module */
-                status = USB_DeviceAudioSetClockSource(audioHandle, controlRequest);
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_SELECTOR_UNIT:
-                /* Select SET request Control Clock Selector Module */
-                status = kStatus_USB_InvalidRequest;
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_MULTIPLIER_UNIT:
-                /* Select SET request Control Clock multiplier Module */
-                status = kStatus_USB_InvalidRequest;
-                break;
-            default:
-                status = kStatus_USB_InvalidRequest;
-                break;
-            }
-        }
-    }
-    return status;
-}
-
-/*!
- * @brief Handle the audio device get request interface.
- *
- * This callback function provides flexibility to add class and vendor specific requests
- *
- * @param audioHandle          The device audio class handle. It equals the value returned from
- * usb_device_class_config_struct_t::classHandle.
- * @param controlRequest       The pointer of the control request structure.
- *
- * @return A USB error code or kStatus_USB_Success.
- */
-usb_status_t USB_DeviceAudioGetRequestInterface(usb_device_audio_struct_t *audioHandle,
-                                                usb_device_control_request_struct_t *controlRequest)
-{
-    uint32_t i;
-    usb_device_audio_entities_struct_t *entity_list;
-    usb_status_t status = kStatus_USB_Error;
-    uint8_t entityId = (uint8_t)(controlRequest->setup->wIndex >> 0x08);
-
-    entity_list = (usb_device_audio_entities_struct_t *)audioHandle->controlInterfaceHandle->classSpecific;
-    for (i = 0; i < entity_list->count; i++)
-    {
-        if (entityId == entity_list->entity[i].entityId)
-        {
-            switch (entity_list->entity[i].entityType)
-            {
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_INPUT_TERMINAL:
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_OUTPUT_TERMINAL:
-                status = USB_DeviceAudioGetControlTerminal(audioHandle, controlRequest,
-                                                           entity_list->entity[i].entityType);
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_FEATURE_UNIT:
-                status = USB_DeviceAudioGetFeatureUnit(audioHandle, controlRequest);
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_SOURCE_UNIT:
-                /* Select SET request Control Clock Source Module */
-                status = USB_DeviceAudioGetClockSource(audioHandle, controlRequest);
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_SELECTOR_UNIT:
-                /* Select SET request Control Clock Select Module */
-                status = kStatus_USB_InvalidRequest;
-                break;
-            case USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_MULTIPLIER_UNIT:
-                /* Select SET request Control Clock Multiplier Module */
-                status = kStatus_USB_InvalidRequest;
-                break;
-            default:
-                status = kStatus_USB_InvalidRequest;
-                break;
-            }
-        }
-    }
-    return status;
+    /* classCallback is initialized in classInit of s_UsbDeviceClassInterfaceMap,
+    it is from the second parameter of classInit */
+    return audioHandle->configStruct->classCallback((class_handle_t)audioHandle,
+                                                    kUSB_DeviceAudioEventControlRequest, controlRequest);
 }
 
 /*!
@@ -1279,9 +724,9 @@ usb_status_t USB_DeviceAudioEvent(void *handle, uint32_t event, void *param)
     case kUSB_DeviceClassEventDeviceReset:
         /* Bus reset, clear the configuration. */
         audioHandle->configuration = 0U;
-        audioHandle->isBusy[USB_AUDIO_STREAM_IN_ENDPOINT_TYPE] = 0U;
-        audioHandle->isBusy[USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE] = 0U;
-        audioHandle->isBusy[USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE] = 0U;
+        USB_DeviceAudioQueueReset(&audioHandle->queue[USB_AUDIO_STREAM_IN_ENDPOINT_TYPE]);
+        USB_DeviceAudioQueueReset(&audioHandle->queue[USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE]);
+        USB_DeviceAudioQueueReset(&audioHandle->queue[USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE]);
         error = kStatus_USB_Success;
         break;
     case kUSB_DeviceClassEventSetConfiguration:
@@ -1483,37 +928,25 @@ usb_status_t USB_DeviceAudioEvent(void *handle, uint32_t event, void *param)
                 }
             }
 
-            error = kStatus_USB_InvalidRequest;
-            switch (controlRequest->setup->bmRequestType)
-            {
-            case USB_DEVICE_AUDIO_SET_REQUEST_ENDPOINT:
-                error = USB_DeviceAudioSetRequestEndpoint(audioHandle, controlRequest);
-                break;
-            case USB_DEVICE_AUDIO_GET_REQUEST_ENDPOINT:
-                error = USB_DeviceAudioGetRequestEndpoint(audioHandle, controlRequest);
-                break;
-            default:
-                /*no action*/
-                break;
-            }
+            error = USB_DeviceAudioControlRequest(audioHandle, controlRequest);
         }
         else if ((controlRequest->setup->bmRequestType & USB_REQUEST_TYPE_RECIPIENT_MASK) ==
                  USB_REQUEST_TYPE_RECIPIENT_INTERFACE)
         {
-            if (audioHandle->controlInterfaceNumber == interfaceOrEndpoint)
+            if ((audioHandle->controlInterfaceNumber == interfaceOrEndpoint) &&
+                (NULL != audioHandle->controlInterfaceHandle))
             {
-                error = kStatus_USB_InvalidRequest;
-                switch (controlRequest->setup->bmRequestType)
+                usb_device_audio_entities_struct_t *entityList =
+                    (usb_device_audio_entities_struct_t *)audioHandle->controlInterfaceHandle->classSpecific;
+                uint8_t entityId = (uint8_t)(controlRequest->setup->wIndex >> 0x08U);
+
+                for (count = 0U; count < entityList->count; count++)
                 {
-                case USB_DEVICE_AUDIO_SET_REQUEST_INTERFACE:
-                    error = USB_DeviceAudioSetRequestInterface(audioHandle, controlRequest);
-                    break;
-                case USB_DEVICE_AUDIO_GET_REQUEST_INTERFACE:
-                    error = USB_DeviceAudioGetRequestInterface(audioHandle, controlRequest);
-                    break;
-                default:
-                    /*no action*/
-                    break;
+                    if (entityId == entityList->entity[count].entityId)
+                    {
+                        error = USB_DeviceAudioControlRequest(audioHandle, controlRequest);
+                        break;
+                    }
                 }
             }
         }
@@ -1609,7 +1042,7 @@ usb_status_t USB_DeviceAudioDeinit(class_handle_t handle)
  * @brief Send data through a specified endpoint.
  *
  * The function is used to send data through a specified endpoint.
- * The function calls USB_DeviceSendRequest internally.
+ * The function calls USB_DeviceSendRequest internally (possibly deferred, see the note).
  *
  * @param handle The audio class handle got from usb_device_class_config_struct_t::classHandle.
  * @param endpointAddress Endpoint index.
@@ -1621,11 +1054,10 @@ usb_status_t USB_DeviceAudioDeinit(class_handle_t handle)
  *
  * @note The return value just means if the sending request is successful or not; the transfer done is notified by
  * usb_device_audio_stream_in or usb_device_audio_control_in.
- * Currently, only one transfer request can be supported for one specific endpoint.
- * If there is a specific requirement to support multiple transfer requests for one specific endpoint, the application
- * should implement a queue in the application level.
- * The subsequent transfer could begin only when the previous transfer is done (get notification through the endpoint
- * callback).
+ * Up to USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH transfer requests can be queued for one specific endpoint, the
+ * function returns kStatus_USB_Busy when the queue is full.
+ * The controller gets one transfer at a time: the next queued transfer is submitted as soon as the previous one is
+ * done, before the application is notified through the endpoint callback.
  */
 usb_status_t USB_DeviceAudioSend(class_handle_t handle, uint8_t ep, uint8_t *buffer, uint32_t length, uint8_t epType)
 {
@@ -1638,17 +1070,8 @@ usb_status_t USB_DeviceAudioSend(class_handle_t handle, uint8_t ep, uint8_t *buf
     }
     audioHandle = (usb_device_audio_struct_t *)handle;
 
-    if (0U != audioHandle->isBusy[epType])
-    {
-        return kStatus_USB_Busy;
-    }
-    audioHandle->isBusy[epType] = 1U;
-
-    error = USB_DeviceSendRequest(audioHandle->handle, ep, buffer, length);
-    if (kStatus_USB_Success != error)
-    {
-        audioHandle->isBusy[epType] = 0U;
-    }
+    error = USB_DeviceAudioQueueTransfer(
+        audioHandle, (uint8_t)(ep | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT)), buffer, length, epType);
     return error;
 }
 
@@ -1656,7 +1079,7 @@ usb_status_t USB_DeviceAudioSend(class_handle_t handle, uint8_t ep, uint8_t *buf
  * @brief Receive data through a specified endpoint.
  *
  * The function is used to receive data through a specified endpoint.
- * The function calls USB_DeviceRecvRequest internally.
+ * The function calls USB_DeviceRecvRequest internally (possibly deferred, see the note).
  *
  * @param handle The audio class handle got from usb_device_class_config_struct_t::classHandle.
  * @param endpointAddress Endpoint index.
@@ -1668,11 +1091,10 @@ usb_status_t USB_DeviceAudioSend(class_handle_t handle, uint8_t ep, uint8_t *buf
  *
  * @note The return value just means if the receiving request is successful or not; the transfer done is notified by
  * usb_device_audio_stream_out.
- * Currently, only one transfer request can be supported for one specific endpoint.
- * If there is a specific requirement to support multiple transfer requests for one specific endpoint, the application
- * should implement a queue in the application level.
- * The subsequent transfer could begin only when the previous transfer is done (get notification through the endpoint
- * callback).
+ * Up to USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH transfer requests can be queued for one specific endpoint, the
+ * function returns kStatus_USB_Busy when the queue is full.
+ * The controller gets one transfer at a time: the next queued transfer is submitted as soon as the previous one is
+ * done, before the application is notified through the endpoint callback.
  */
 usb_status_t USB_DeviceAudioRecv(class_handle_t handle, uint8_t ep, uint8_t *buffer, uint32_t length, uint8_t epType)
 {
@@ -1685,17 +1107,8 @@ usb_status_t USB_DeviceAudioRecv(class_handle_t handle, uint8_t ep, uint8_t *buf
     }
     audioHandle = (usb_device_audio_struct_t *)handle;
 
-    if (0U != audioHandle->isBusy[epType])
-    {
-        return kStatus_USB_Busy;
-    }
-    audioHandle->isBusy[epType] = 1U;
-
-    error = USB_DeviceRecvRequest(audioHandle->handle, ep, buffer, length);
-    if (kStatus_USB_Success != error)
-    {
-        audioHandle->isBusy[epType] = 0U;
-    }
+    error = USB_DeviceAudioQueueTransfer(
+        audioHandle, (uint8_t)(ep | (USB_OUT << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT)), buffer, length, epType);
     return error;
 }
 
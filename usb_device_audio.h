@@ -391,12 +391,18 @@
 #define USB_AUDIO_CONTROL_ENDPOINT_TYPE (3U)
 #define USB_AUDIO_ENDPOINT_TYPE_COUNT (4U)
 
+#ifndef USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH
+#define USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH (1U)
+#endif
+
 /*! @brief Available common EVENT types in audio class callback */
 typedef enum
 {
     kUSB_DeviceAudioEventStreamSendResponse = 0x01U, /*!< Send data completed or cancelled etc in stream pipe */
     kUSB_DeviceAudioEventStreamRecvResponse,         /*!< Data received or cancelled etc in stream pipe */
     kUSB_DeviceAudioEventControlSendResponse,        /*!< Send data completed or cancelled etc in audio control pipe */
+    kUSB_DeviceAudioEventControlRequest = 0x100U,    /*!< Class specific request to an entity or endpoint, the
+                                                          parameter is the usb_device_control_request_struct_t */
 } usb_device_audio_event_t;
 
 /*!
@@ -428,6 +434,28 @@ typedef struct _usb_device_audio_entities_struct
     uint8_t count;
 } usb_device_audio_entities_struct_t;
 
+/*! @brief A transfer queued on an audio endpoint */
+typedef struct _usb_device_audio_transfer_struct
+{
+    uint8_t *buffer; /*!< Transfer buffer */
+    uint32_t length; /*!< Transfer length */
+} usb_device_audio_transfer_struct_t;
+
+/*!
+ * @brief The transfer queue of an audio endpoint
+ *
+ * The controller driver takes one transfer at a time per endpoint, so the class keeps the following ones and
+ * submits the next one as soon as the previous one is completed, before notifying the application.
+ */
+typedef struct _usb_device_audio_queue_struct
+{
+    usb_device_audio_transfer_struct_t transfer[USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH]; /*!< Ring of queued transfers */
+    uint8_t isBusy[USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH];                              /*!< Slot busy flag */
+    uint8_t endpointAddress;                                                               /*!< Endpoint of the queue */
+    uint8_t head;                                                                          /*!< Slot submitted to the controller */
+    uint8_t count;                                                                         /*!< Number of busy slots */
+} usb_device_audio_queue_struct_t;
+
 /*! @brief The audio device class status structure */
 typedef struct _usb_device_audio_struct
 {
@@ -440,7 +468,7 @@ typedef struct _usb_device_audio_struct
     uint8_t controlAlternate;                                                               /*!< Current alternate setting of the control interface */
     uint8_t streamInterfaceNumber[USB_AUDIO_INTERFACE_STREAM_COUNT];                        /*!< The stream interface number of the class */
     uint8_t streamAlternate[USB_AUDIO_INTERFACE_STREAM_COUNT];                              /*!< Current alternate setting of the stream interface */
-    uint8_t isBusy[USB_AUDIO_ENDPOINT_TYPE_COUNT];                                          /*!< Stream IN pipe busy flag */
+    usb_device_audio_queue_struct_t queue[USB_AUDIO_ENDPOINT_TYPE_COUNT];                   /*!< Transfer queue of each endpoint */
 } usb_device_audio_struct_t;
 
 STRUCT_PACKED
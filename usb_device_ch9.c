@@ -35,6 +35,24 @@ typedef usb_status_t (*usb_standard_request_callback_t)(usb_device_common_class_
                                                         uint8_t **buffer,
                                                         uint32_t *length);
 
+#if (defined(USB_DEVICE_CONFIG_CONTROL_TASK) && (USB_DEVICE_CONFIG_CONTROL_TASK > 0U))
+/*!
+ * @brief Control pipe message deferred to the control task.
+ *
+ * The setup packet is copied: the controller buffer is reused by the next setup.
+ */
+typedef struct _usb_device_control_message_struct
+{
+    usb_device_handle handle;
+    void *callbackParam;
+    uint8_t *buffer;
+    uint32_t length;
+    uint8_t isSetup;
+    uint8_t generation;
+    uint8_t setup[USB_SETUP_PACKET_SIZE];
+} usb_device_control_message_struct_t;
+#endif
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -80,6 +98,16 @@ static usb_status_t USB_DeviceCh9SynchFrame(usb_device_common_class_struct_t *cl
 /*******************************************************************************
  * Variables
  ******************************************************************************/
+#if (defined(USB_DEVICE_CONFIG_CONTROL_TASK) && (USB_DEVICE_CONFIG_CONTROL_TASK > 0U))
+OSA_MSGQ_HANDLE_DEFINE(s_UsbDeviceControlQueueBuffer,
+                       USB_DEVICE_CONFIG_CONTROL_MESSAGES,
+                       sizeof(usb_device_control_message_struct_t));
+static osa_msgq_handle_t s_UsbDeviceControlQueue;
+
+/* Bumped on every bus reset, the messages queued before are dropped */
+static volatile uint8_t s_UsbDeviceControlGeneration;
+#endif
+
 
 /* The function list to handle the standard request. */
 static const usb_standard_request_callback_t s_UsbDeviceStandardRequest[] = {
@@ -1219,6 +1247,104 @@ static usb_status_t USB_DeviceControlCallback(usb_device_handle handle,
     return status;
 }
 
+#if (defined(USB_DEVICE_CONFIG_CONTROL_TASK) && (USB_DEVICE_CONFIG_CONTROL_TASK > 0U))
+/*!
+ * @brief Control endpoint callback function, deferred mode.
+ *
+ * Runs in the interrupt context: the message is queued for the control task that runs the actual
+ * USB_DeviceControlCallback(). The interrupt only spends time on the ISO endpoints.
+ *
+ * @param handle          The device handle. It equals the value returned from USB_DeviceInit.
+ * @param message         The result of a transfer, includes transfer buffer, transfer length and whether is in setup
+ * phase for control pipe.
+ * @param callbackParam  The parameter for this callback. It is same with
+ * usb_device_endpoint_callback_struct_t::callbackParam.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+static usb_status_t USB_DeviceControlCallbackDefer(usb_device_handle handle,
+                                                   usb_device_endpoint_callback_message_struct_t *message,
+                                                   void *callbackParam)
+{
+    usb_device_control_message_struct_t controlMessage;
+
+    /* endpoint callback length is USB_CANCELLED_TRANSFER_LENGTH (0xFFFFFFFFU) when transfer is canceled */
+    if (USB_CANCELLED_TRANSFER_LENGTH == message->length)
+    {
+        return kStatus_USB_Success;
+    }
+
+    controlMessage.handle = handle;
+    controlMessage.callbackParam = callbackParam;
+    controlMessage.buffer = message->buffer;
+    controlMessage.length = message->length;
+    controlMessage.isSetup = message->isSetup;
+    controlMessage.generation = s_UsbDeviceControlGeneration;
+
+    if ((0U != message->isSetup) && (USB_SETUP_PACKET_SIZE == message->length) && (NULL != message->buffer))
+    {
+        (void)memcpy(controlMessage.setup, message->buffer, USB_SETUP_PACKET_SIZE);
+    }
+
+    if (KOSA_StatusSuccess != OSA_MsgQPut(s_UsbDeviceControlQueue, (osa_msg_handle_t)&controlMessage))
+    {
+        return kStatus_USB_Busy;
+    }
+
+    return kStatus_USB_Success;
+}
+
+/*!
+ * @brief Initialize the control task queue.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+usb_status_t USB_DeviceControlTaskInit(void)
+{
+    s_UsbDeviceControlQueue = (osa_msgq_handle_t)s_UsbDeviceControlQueueBuffer;
+
+    if (KOSA_StatusSuccess != OSA_MsgQCreate(s_UsbDeviceControlQueue, USB_DEVICE_CONFIG_CONTROL_MESSAGES,
+                                             sizeof(usb_device_control_message_struct_t)))
+    {
+        return kStatus_USB_Error;
+    }
+
+    return kStatus_USB_Success;
+}
+
+/*!
+ * @brief Service one control pipe message.
+ *
+ * Blocks until a message is queued by USB_DeviceControlCallbackDefer().
+ */
+void USB_DeviceControlTaskFunction(void)
+{
+    usb_device_control_message_struct_t controlMessage;
+    usb_device_endpoint_callback_message_struct_t message;
+
+    if (KOSA_StatusSuccess != OSA_MsgQGet(s_UsbDeviceControlQueue, (osa_msg_handle_t)&controlMessage, osaWaitForever_c))
+    {
+        return;
+    }
+
+    /* A bus reset happened after the message was queued */
+    if (controlMessage.generation != s_UsbDeviceControlGeneration)
+    {
+        return;
+    }
+
+    message.buffer = controlMessage.buffer;
+    if ((0U != controlMessage.isSetup) && (NULL != controlMessage.buffer))
+    {
+        message.buffer = controlMessage.setup;
+    }
+    message.length = controlMessage.length;
+    message.isSetup = controlMessage.isSetup;
+
+    (void)USB_DeviceControlCallback(controlMessage.handle, &message, controlMessage.callbackParam);
+}
+#endif
+
 /*!
  * @brief Control endpoint initialization function.
  *
@@ -1235,7 +1361,12 @@ usb_status_t USB_DeviceControlPipeInit(usb_device_handle handle, void *param)
     usb_device_endpoint_callback_struct_t epCallback;
     usb_status_t status;
 
+#if (defined(USB_DEVICE_CONFIG_CONTROL_TASK) && (USB_DEVICE_CONFIG_CONTROL_TASK > 0U))
+    s_UsbDeviceControlGeneration++;
+    epCallback.callbackFn = USB_DeviceControlCallbackDefer;
+#else
     epCallback.callbackFn = USB_DeviceControlCallback;
+#endif
     epCallback.callbackParam = param;
 
     epInitStruct.zlt = 1U;
@@ -71,6 +71,25 @@ extern "C"
      */
     extern usb_status_t USB_DeviceControlPipeInit(usb_device_handle handle, void *param);
 
+#if (defined(USB_DEVICE_CONFIG_CONTROL_TASK) && (USB_DEVICE_CONFIG_CONTROL_TASK > 0U))
+    /*!
+     * @brief Initializes the control task queue.
+     *
+     * The function must be called once before the device is started.
+     *
+     * @return A USB error code or kStatus_USB_Success.
+     */
+    extern usb_status_t USB_DeviceControlTaskInit(void);
+
+    /*!
+     * @brief Services the control pipe.
+     *
+     * The function blocks until a control pipe message is pending and handles it. It should be called in
+     * an infinite loop from the device task.
+     */
+    extern void USB_DeviceControlTaskFunction(void);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
@@ -96,6 +96,34 @@
 /*! @brief How many the notification message are supported when the device task is enabled. */
 #define USB_DEVICE_CONFIG_MAX_MESSAGES (8U)
 
+/*!
+ * @brief Whether the control pipe is serviced by the device task.
+ *
+ * USB_DEVICE_CONFIG_USE_TASK moves all the notifications (ISO included) to the
+ * device task. With this one instead the interrupt keeps servicing the ISO
+ * endpoints (the time-critical audio packet hand-off) and only the control pipe
+ * (standard / class requests, descriptors, set interface) is deferred to the
+ * device task. The two are mutually exclusive.
+ *
+ * Experimental: it has not been run on the EVK yet, so there are no figures
+ * showing the ISO jitter going down. Compare the "[USB] isr max / IN interval"
+ * prints with it off and on before relying on it.
+ */
+#define USB_DEVICE_CONFIG_CONTROL_TASK (0U)
+
+/*! @brief How many control pipe messages can be pending when the control task is enabled. */
+#define USB_DEVICE_CONFIG_CONTROL_MESSAGES (4U)
+
+#if (USB_DEVICE_CONFIG_CONTROL_TASK > 0U) && (USB_DEVICE_CONFIG_USE_TASK > 0U)
+#error "USB_DEVICE_CONFIG_CONTROL_TASK and USB_DEVICE_CONFIG_USE_TASK are mutually exclusive"
+#endif
+
+/*! @brief Whether the SOF count can be retrieved (used to measure the I2S rate for the explicit feedback). */
+#define USB_DEVICE_CONFIG_GET_SOF_COUNT (1U)
+
+/*! @brief How many transfers can be queued on each audio ISO endpoint (in flight + pending in the class). */
+#define USB_DEVICE_CONFIG_AUDIO_ISO_QUEUE_DEPTH (2U)
+
 /*! @brief Whether test mode enabled. */
 #define USB_DEVICE_CONFIG_USB20_TEST_MODE (0U)
 
@@ -66,13 +66,15 @@
  * |              |                              |                              |
  * +--------------+------------------------------+------------------------------+
  *
- * GENERATOR [source]: - Synch EP
- *                     - USB_DEVICE_AUDIO_USE_SYNC_MODE not set
+ * GENERATOR [source]: - Asynch EP, implicit feedback
+ *                     - Synch EP with USB_AUDIO_SYNC_MODE
  *                     - No feedback EP
  *
- * SPEAKER [sink]: - Asynch EP
- *                 - USB_DEVICE_AUDIO_USE_SYNC_MODE set by default
- *                 - Feedback EP only when USB_DEVICE_AUDIO_USE_SYNC_MODE is NOT set
+ * SPEAKER [sink]: - Asynch EP, feedback EP
+ *                 - Synch EP with USB_AUDIO_SYNC_MODE, no feedback EP
+ *
+ * USB_AUDIO_SYNC_MODE is the synchronous row: the device is the I2S master
+ * (I2S_MASTER) and the Audio PLL is locked to SOF (see sync.h).
  */
 
 /*******************************************************************************
@@ -107,6 +109,103 @@ usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceOutEndpoints[USB_AUDIO_STREAM
         FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE),
         FS_ISO_OUT_ENDP_INTERVAL,
     },
+#if !USB_AUDIO_SYNC_MODE
+    {
+        USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE,
+        FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,
+    },
+#endif
+};
+
+/* Audio device stream endpoint information, packed 24-bit alternate setting */
+usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceIn24Endpoints[USB_AUDIO_STREAM_IN_ENDPOINT_COUNT] = {
+    /* Audio device ISO IN pipe */
+    {
+        USB_AUDIO_STREAM_IN_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_IN_ENDP_PACKET_SIZE_24 + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24),
+        FS_ISO_IN_ENDP_INTERVAL,
+    },
+};
+
+usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceOut24Endpoints[USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT] = {
+    /* Audio device ISO OUT pipe */
+    {
+        USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_OUT_ENDP_PACKET_SIZE_24 + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24),
+        FS_ISO_OUT_ENDP_INTERVAL,
+    },
+#if !USB_AUDIO_SYNC_MODE
+    {
+        USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE,
+        FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,
+    },
+#endif
+};
+
+/* Audio device stream endpoint information, 8 channels alternate setting */
+usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceIn8chEndpoints[USB_AUDIO_STREAM_IN_ENDPOINT_COUNT] = {
+    /* Audio device ISO IN pipe */
+    {
+        USB_AUDIO_STREAM_IN_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_IN_ENDP_PACKET_SIZE_8CH + (AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE),
+        FS_ISO_IN_ENDP_INTERVAL,
+    },
+};
+
+usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceOut8chEndpoints[USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT] = {
+    /* Audio device ISO OUT pipe */
+    {
+        USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_OUT_ENDP_PACKET_SIZE_8CH + (AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE),
+        FS_ISO_OUT_ENDP_INTERVAL,
+    },
+#if !USB_AUDIO_SYNC_MODE
+    {
+        USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE,
+        FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,
+    },
+#endif
+};
+
+/* Audio device stream endpoint information, 2 channels alternate setting */
+usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceIn2chEndpoints[USB_AUDIO_STREAM_IN_ENDPOINT_COUNT] = {
+    /* Audio device ISO IN pipe */
+    {
+        USB_AUDIO_STREAM_IN_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_IN_ENDP_PACKET_SIZE_2CH + (AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE),
+        FS_ISO_IN_ENDP_INTERVAL,
+    },
+};
+
+usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceOut2chEndpoints[USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT] = {
+    /* Audio device ISO OUT pipe */
+    {
+        USB_AUDIO_STREAM_OUT_ENDPOINT_TYPE,
+        USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
+        USB_ENDPOINT_ISOCHRONOUS,
+        FS_ISO_OUT_ENDP_PACKET_SIZE_2CH + (AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE),
+        FS_ISO_OUT_ENDP_INTERVAL,
+    },
+#if !USB_AUDIO_SYNC_MODE
     {
         USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT_TYPE,
         USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT | (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT),
@@ -114,6 +213,25 @@ usb_device_endpoint_struct_t g_UsbDeviceAudiodeviceOutEndpoints[USB_AUDIO_STREAM
         FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE,
         FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,
     },
+#endif
+};
+
+/**
+ * USB format and HS bInterval of each streaming alternate setting, the same
+ * for IN and OUT. Alternate 0 has no endpoints, it is listed with the full
+ * format.
+ */
+static const struct
+{
+    uint8_t channels;
+    uint8_t subslotSize;
+    uint8_t interval;
+} s_UsbDeviceAudioStreamFormat[USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT] = {
+    {AUDIO_FORMAT_CHANNELS, AUDIO_FORMAT_SIZE, 0x01U},                         /* Alternate 0 */
+    {AUDIO_FORMAT_CHANNELS, AUDIO_FORMAT_SIZE, HS_ISO_ENDP_INTERVAL_ALT_1},    /* Alternate 1: 16 channels, 32-bit */
+    {AUDIO_FORMAT_CHANNELS, AUDIO_FORMAT_SIZE_24, HS_ISO_ENDP_INTERVAL_ALT_2}, /* Alternate 2: 16 channels, packed 24-bit */
+    {AUDIO_FORMAT_CHANNELS_8, AUDIO_FORMAT_SIZE, HS_ISO_ENDP_INTERVAL_ALT_3},  /* Alternate 3: 8 channels, 32-bit */
+    {AUDIO_FORMAT_CHANNELS_2, AUDIO_FORMAT_SIZE, HS_ISO_ENDP_INTERVAL_ALT_4},  /* Alternate 4: 2 channels, 32-bit */
 };
 
 /* Audio device control endpoint information */
@@ -159,6 +277,16 @@ usb_device_audio_entity_struct_t g_UsbDeviceAudioEntity[] = {
         USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_OUTPUT_TERMINAL,
         0U,
     },
+    {
+        USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID,
+        USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_FEATURE_UNIT,
+        0U,
+    },
+    {
+        USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID,
+        USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_FEATURE_UNIT,
+        0U,
+    },
 };
 
 /* Audio device entity information */
@@ -195,6 +323,30 @@ usb_device_interface_struct_t g_UsbDeviceAudioStreamInInterface[] = {
         },
         NULL,
     },
+    {
+        USB_AUDIO_STREAM_INTERFACE_ALTERNATE_2,
+        {
+            USB_AUDIO_STREAM_IN_ENDPOINT_COUNT,
+            g_UsbDeviceAudiodeviceIn24Endpoints,
+        },
+        NULL,
+    },
+    {
+        USB_AUDIO_STREAM_INTERFACE_ALTERNATE_3,
+        {
+            USB_AUDIO_STREAM_IN_ENDPOINT_COUNT,
+            g_UsbDeviceAudiodeviceIn8chEndpoints,
+        },
+        NULL,
+    },
+    {
+        USB_AUDIO_STREAM_INTERFACE_ALTERNATE_4,
+        {
+            USB_AUDIO_STREAM_IN_ENDPOINT_COUNT,
+            g_UsbDeviceAudiodeviceIn2chEndpoints,
+        },
+        NULL,
+    },
 };
 
 /* Audio device stream interface information */
@@ -215,6 +367,30 @@ usb_device_interface_struct_t g_UsbDeviceAudioStreamOutInterface[] = {
         },
         NULL,
     },
+    {
+        USB_AUDIO_STREAM_INTERFACE_ALTERNATE_2,
+        {
+            USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,
+            g_UsbDeviceAudiodeviceOut24Endpoints,
+        },
+        NULL,
+    },
+    {
+        USB_AUDIO_STREAM_INTERFACE_ALTERNATE_3,
+        {
+            USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,
+            g_UsbDeviceAudiodeviceOut8chEndpoints,
+        },
+        NULL,
+    },
+    {
+        USB_AUDIO_STREAM_INTERFACE_ALTERNATE_4,
+        {
+            USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,
+            g_UsbDeviceAudiodeviceOut2chEndpoints,
+        },
+        NULL,
+    },
 };
 
 /* Define interfaces for audio device */
@@ -304,26 +480,56 @@ uint8_t g_UsbDeviceDescriptor[] = {
     USB_DEVICE_CONFIGURATION_COUNT,                  /* Number of possible configurations */
 };
 
-#define TOTAL_LENGHT (USB_DESCRIPTOR_LENGTH_CONFIGURE +                \
-                      USB_AUDIO_INTERFACE_ASSOCIATION_DESC_LENGTH +    \
-                      USB_DESCRIPTOR_LENGTH_INTERFACE +                \
-                      USB_AUDIO_CONTROL_INTERFACE_HEADER_LENGTH +      \
-                      (2 * USB_AUDIO_CLOCK_SOURCE_DESC_LENGTH) +       \
-                      (2 * USB_AUDIO_INPUT_TERMINAL_DESC_LENGTH) +     \
-                      (2 * USB_AUDIO_OUTPUT_TERMINAL_DESC_LENGTH) +    \
-                      USB_DESCRIPTOR_LENGTH_INTERFACE +                \
-                      USB_DESCRIPTOR_LENGTH_INTERFACE +                \
-                      USB_AUDIO_AS_INTERFACE_DESC_LENGTH +             \
-                      USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH +       \
-                      USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH + \
-                      USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH +       \
-                      USB_DESCRIPTOR_LENGTH_INTERFACE +                \
-                      USB_DESCRIPTOR_LENGTH_INTERFACE +                \
-                      USB_AUDIO_AS_INTERFACE_DESC_LENGTH +             \
-                      USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH +       \
-                      USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH + \
-                      USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH + \
-                      USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH)
+/**
+ * Class-specific AudioControl interface: header, clock sources, terminals and
+ * feature units.
+ */
+#define USB_AUDIO_CONTROL_TOTAL_LENGTH (USB_AUDIO_CONTROL_INTERFACE_HEADER_LENGTH +     \
+                                        (2 * USB_AUDIO_CLOCK_SOURCE_DESC_LENGTH) +      \
+                                        (2 * USB_AUDIO_INPUT_TERMINAL_DESC_LENGTH) +    \
+                                        (2 * USB_AUDIO_FEATURE_UNIT_DESC_LENGTH) +      \
+                                        (2 * USB_AUDIO_OUTPUT_TERMINAL_DESC_LENGTH))
+
+/**
+ * bmaControls of each channel of the feature units (master first): Mute and
+ * Volume Controls, host programmable.
+ */
+#if USB_AUDIO_FEATURE_UNIT_CHANNELS != 16U
+#error "USB_AUDIO_FEATURE_UNIT_BMA_CONTROLS lists 16 channels"
+#endif
+
+#define USB_AUDIO_FEATURE_UNIT_CONTROLS 0x0FU, 0x00U, 0x00U, 0x00U
+#define USB_AUDIO_FEATURE_UNIT_BMA_CONTROLS                                                                           \
+    USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS,                \
+    USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS,                \
+    USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS,                \
+    USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS,                \
+    USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS,                \
+    USB_AUDIO_FEATURE_UNIT_CONTROLS, USB_AUDIO_FEATURE_UNIT_CONTROLS
+
+#define TOTAL_LENGHT (USB_DESCRIPTOR_LENGTH_CONFIGURE +                   \
+                      USB_AUDIO_INTERFACE_ASSOCIATION_DESC_LENGTH +       \
+                      USB_DESCRIPTOR_LENGTH_INTERFACE +                   \
+                      USB_AUDIO_CONTROL_INTERFACE_HEADER_LENGTH +         \
+                      (2 * USB_AUDIO_CLOCK_SOURCE_DESC_LENGTH) +          \
+                      (2 * USB_AUDIO_INPUT_TERMINAL_DESC_LENGTH) +        \
+                      (2 * USB_AUDIO_FEATURE_UNIT_DESC_LENGTH) +          \
+                      (2 * USB_AUDIO_OUTPUT_TERMINAL_DESC_LENGTH) +       \
+                      USB_DESCRIPTOR_LENGTH_INTERFACE +                   \
+                      ((USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT - 1) * \
+                       (USB_DESCRIPTOR_LENGTH_INTERFACE +                 \
+                        USB_AUDIO_AS_INTERFACE_DESC_LENGTH +              \
+                        USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH +        \
+                        USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH +  \
+                        USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH)) +      \
+                      USB_DESCRIPTOR_LENGTH_INTERFACE +                   \
+                      ((USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT - 1) * \
+                       (USB_DESCRIPTOR_LENGTH_INTERFACE +                 \
+                        USB_AUDIO_AS_INTERFACE_DESC_LENGTH +              \
+                        USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH +        \
+                        USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH +  \
+                        USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH +  \
+                        USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH)))
 
 USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 uint8_t g_UsbDeviceConfigurationDescriptor[] = {
@@ -332,7 +538,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * Configuration Descriptor:
      * bLength                 9
      * bDescriptorType         2
-     * wTotalLength       0x00e9
+     * wTotalLength       0x020b
      * bNumInterfaces          3
      * bConfigurationValue     1
      * iConfiguration          0
@@ -412,7 +618,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * bDescriptorSubtype      1 (HEADER)
      * bcdADC               2.00
      * bCategory               8
-     * wTotalLength       0x0061
+     * wTotalLength       0x00e7
      * bmControls           0x00
      */
     USB_AUDIO_CONTROL_INTERFACE_HEADER_LENGTH,   /* Size of the descriptor, in bytes  */
@@ -421,8 +627,8 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     0x00U,
     0x02U, /* Audio Device compliant to the USB Audio specification version 2.00  */
     0x08U, /* IO_BOX(0x08) : Indicating the primary use of this audio function   */
-    0x61U,
-    0x00U, /* Total number of bytes returned for the class-specific AudioControl interface descriptor. Includes
+    USB_SHORT_GET_LOW(USB_AUDIO_CONTROL_TOTAL_LENGTH),
+    USB_SHORT_GET_HIGH(USB_AUDIO_CONTROL_TOTAL_LENGTH), /* Total number of bytes returned for the class-specific AudioControl interface descriptor. Includes
               the combined length of this descriptor header and all Unit and Terminal descriptors.   */
     0x00U, /* D1..0: Latency Control  */
 
@@ -432,7 +638,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * bDescriptorType        36
      * bDescriptorSubtype     10 (CLOCK_SOURCE)
      * bClockID               16
-     * bmAttributes            1 Internal fixed clock
+     * bmAttributes            3 Internal programmable clock
      * bmControls           0x07
      *   Clock Frequency Control (read/write)
      *   Clock Validity Control (read-only)
@@ -444,8 +650,9 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_SOURCE_UNIT, /* CLOCK_SOURCE descriptor subtype  */
     USB_AUDIO_IN_CONTROL_CLOCK_SOURCE_ENTITY_ID,            /* Constant uniquely identifying the Clock Source Entity within
                                                                      the audio funcion */
-    0x01U,                                                  /* D1..0: 01: Internal Fixed Clock
+    USB_AUDIO_CLOCK_SOURCE_ATTRIBUTES,                      /* D1..0: 11: Internal Programmable Clock
                                                                D2: 0 Clock is not synchronized to SOF
+                                                                   (1 with USB_AUDIO_SYNC_MODE)
                                                                D7..3: Reserved, should set to 0   */
     0x07U,                                                  /* D1..0: Clock Frequency Control is present and Host programmable
                                                                D3..2: Clock Validity Control is present but read-only
@@ -459,7 +666,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * bDescriptorType        36
      * bDescriptorSubtype     10 (CLOCK_SOURCE)
      * bClockID               17
-     * bmAttributes            1 Internal fixed clock
+     * bmAttributes            3 Internal programmable clock
      * bmControls           0x07
      *   Clock Frequency Control (read/write)
      *   Clock Validity Control (read-only)
@@ -471,8 +678,9 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_CLOCK_SOURCE_UNIT, /* CLOCK_SOURCE descriptor subtype  */
     USB_AUDIO_OUT_CONTROL_CLOCK_SOURCE_ENTITY_ID,           /* Constant uniquely identifying the Clock Source Entity within
                                                                     the audio funcion */
-    0x01U,                                                  /* D1..0: 01: Internal Fixed Clock
+    USB_AUDIO_CLOCK_SOURCE_ATTRIBUTES,                      /* D1..0: 11: Internal Programmable Clock
                                                                D2: 0 Clock is not synchronized to SOF
+                                                                   (1 with USB_AUDIO_SYNC_MODE)
                                                                D7..3: Reserved, should set to 0   */
     0x07U,                                                  /* D1..0: Clock Frequency Control is present and Host programmable
                                                                D3..2: Clock Validity Control is present but read-only
@@ -562,6 +770,46 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
               D15..12: Reserved, should set to 0*/
     0x07U, /* Index of a string descriptor, describing the Input Terminal.  */
 
+    /**
+     * AudioControl Interface Descriptor:
+     * bLength                74
+     * bDescriptorType        36
+     * bDescriptorSubtype      6 (FEATURE_UNIT)
+     * bUnitID                 7
+     * bSourceID               2
+     * bmaControls(0..16)   0x0000000f
+     *   Mute Control (read/write)
+     *   Volume Control (read/write)
+     * iFeature                0
+     */
+    USB_AUDIO_FEATURE_UNIT_DESC_LENGTH,                /* Size of the descriptor, in bytes  */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_FEATURE_UNIT, /* FEATURE_UNIT descriptor subtype   */
+    USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID,              /* Constant uniquely identifying the Unit */
+    USB_AUDIO_IN_CONTROL_INPUT_TERMINAL_ID,            /* ID of the Terminal this Unit is connected to */
+    USB_AUDIO_FEATURE_UNIT_BMA_CONTROLS,               /* Master and per-channel Mute and Volume Controls */
+    0x00U,                                             /* No string descriptor for the Feature Unit */
+
+    /**
+     * AudioControl Interface Descriptor:
+     * bLength                74
+     * bDescriptorType        36
+     * bDescriptorSubtype      6 (FEATURE_UNIT)
+     * bUnitID                 8
+     * bSourceID               1
+     * bmaControls(0..16)   0x0000000f
+     *   Mute Control (read/write)
+     *   Volume Control (read/write)
+     * iFeature                0
+     */
+    USB_AUDIO_FEATURE_UNIT_DESC_LENGTH,                /* Size of the descriptor, in bytes  */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_CONTROL_FEATURE_UNIT, /* FEATURE_UNIT descriptor subtype   */
+    USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID,             /* Constant uniquely identifying the Unit */
+    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,           /* ID of the Terminal this Unit is connected to */
+    USB_AUDIO_FEATURE_UNIT_BMA_CONTROLS,               /* Master and per-channel Mute and Volume Controls */
+    0x00U,                                             /* No string descriptor for the Feature Unit */
+
     /**
      * AudioControl Interface Descriptor:
      * bLength                12
@@ -570,7 +818,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * bTerminalID             3
      * wTerminalType      0x0101 USB Streaming
      * bAssocTerminal          0
-     * bSourceID               2
+     * bSourceID               7
      * bCSourceID             16
      * bmControls         0x0000
      * iTerminal               8
@@ -584,7 +832,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     0x01U,                                       /* A Terminal dealing with a signal carried over an endpoint in an AudioStreaming interface. The
                                                AudioStreaming interface descriptor points to the associated Terminal through the bTerminalLink field.  */
     0x00U,                                       /* This Output Terminal has no association  */
-    USB_AUDIO_IN_CONTROL_INPUT_TERMINAL_ID,      /* ID of the Unit or Terminal to which this Terminal is connected.  */
+    USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID,        /* ID of the Unit or Terminal to which this Terminal is connected.  */
     USB_AUDIO_IN_CONTROL_CLOCK_SOURCE_ENTITY_ID, /* ID of the Clock Entity to which this Output Terminal is
                                                           connected  */
     0x00U,
@@ -604,7 +852,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * bTerminalID             6
      * wTerminalType      0x0301 Speaker
      * bAssocTerminal          0
-     * bSourceID               4
+     * bSourceID               8
      * bCSourceID             17
      * bmControls         0x0000
      * iTerminal              10
@@ -617,7 +865,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     0x01U,
     0x03U,                                        /* Speaker */
     0x00U,                                        /* This Output Terminal has no association  */
-    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,      /* ID of the Unit or Terminal to which this Terminal is connected.  */
+    USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID,        /* ID of the Unit or Terminal to which this Terminal is connected.  */
     USB_AUDIO_OUT_CONTROL_CLOCK_SOURCE_ENTITY_ID, /* ID of the Clock Entity to which this Output Terminal is
                                                           connected  */
     0x00U,
@@ -739,9 +987,9 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
     USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
     USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << 7),   /* This is an IN endpoint with endpoint number 2   */
-    0x05U,                                          /* Types -
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
                                                        Transfer: ISOCHRONOUS
-                                                       Sync: Async
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
                                                        Usage: Data EP  */
     USB_SHORT_GET_LOW(FS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)),
     USB_SHORT_GET_HIGH(FS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
@@ -770,52 +1018,30 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * Interface Descriptor:
      * bLength                 9
      * bDescriptorType         4
-     * bInterfaceNumber        2
-     * bAlternateSetting       0
-     * bNumEndpoints           0
-     * bInterfaceClass         1 Audio
-     * bInterfaceSubClass      2 Streaming
-     * bInterfaceProtocol     32
-     * iInterface             11
-     */
-    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
-    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type   */
-    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /* The number of this interface is 2.  */
-    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0, /* The value used to select the alternate setting for this interface is 0   */
-    0x00U,                                  /* The number of endpoints used by this interface is 0 (excluding endpoint zero)   */
-    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
-    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
-    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
-    0x0BU,                                  /* Index of a string descriptor */
-
-    /**
-     * Interface Descriptor:
-     * bLength                 9
-     * bDescriptorType         4
-     * bInterfaceNumber        2
-     * bAlternateSetting       1
-     * bNumEndpoints           2
+     * bInterfaceNumber        1
+     * bAlternateSetting       2
+     * bNumEndpoints           1
      * bInterfaceClass         1 Audio
      * bInterfaceSubClass      2 Streaming
      * bInterfaceProtocol     32
-     * iInterface             12
+     * iInterface             14
      */
     USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
     USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
-    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /*The number of this interface is 2.  */
-    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_1, /* The value used to select the alternate setting for this interface is 1  */
-    USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,    /* The number of endpoints used by this interface */
+    USB_AUDIO_STREAM_IN_INTERFACE_INDEX,    /*The number of this interface is 1.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_2, /* The value used to select the alternate setting for this interface is 2  */
+    USB_AUDIO_STREAM_IN_ENDPOINT_COUNT,     /* The number of endpoints used by this interface is 1 (excluding endpoint zero)    */
     USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
     USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
     USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
-    0x0CU,                                  /* Index of a string descriptor */
+    0x0EU,                                  /* Index of a string descriptor */
 
     /**
      * AudioStreaming Interface Descriptor:
      * bLength                16
      * bDescriptorType        36
      * bDescriptorSubtype      1 (AS_GENERAL)
-     * bTerminalLink           4
+     * bTerminalLink           3
      * bmControls           0x00
      * bFormatType             1
      * bmFormats          0x00000001
@@ -827,7 +1053,7 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
     USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
     USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
-    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+    USB_AUDIO_IN_CONTROL_OUTPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
                                                                 connected   */
     0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
                                                           D3..2: Valid Alternate Settings Control is not present
@@ -850,63 +1076,39 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
      * bDescriptorType        36
      * bDescriptorSubtype      2 (FORMAT_TYPE)
      * bFormatType             1 (FORMAT_TYPE_I)
-     * bSubslotSize            4
-     * bBitResolution         32
+     * bSubslotSize            3
+     * bBitResolution         24
      */
     USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
     USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
     USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
     USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
-    0x04U,                                              /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
-    0x20U,                                              /* The number of effectively used bits from the available bits in an audio subslot   */
+    AUDIO_FORMAT_SIZE_24,                               /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    AUDIO_FORMAT_BITS_24,                               /* The number of effectively used bits from the available bits in an audio subslot   */
 
     /**
      * Endpoint Descriptor:
      * bLength                 7
      * bDescriptorType         5
-     * bEndpointAddress     0x01  EP 1 OUT
+     * bEndpointAddress     0x82  EP 2 IN
      * bmAttributes            5
      *   Transfer Type            Isochronous
      *   Synch Type               Asynchronous
      *   Usage Type               Data
-     * wMaxPacketSize     0x01C0  1x 448 bytes
+     * wMaxPacketSize     0x0150  1x 336 bytes
      * bInterval               1
      */
     /* ENDPOINT Descriptor */
     USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
     USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
-    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << 7), /* This is an IN endpoint with endpoint number 2   */
-    0x05U,                                          /* Types -
-                                                       Transfer: ISOCHRONOUS
-                                                       Sync: Async
-                                                       Usage: Data EP  */
-    USB_SHORT_GET_LOW(FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)),
-    USB_SHORT_GET_HIGH(FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
-    FS_ISO_OUT_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
-
-    /**
-     * Endpoint Descriptor:
-     * bLength                 7
-     * bDescriptorType         5
-     * bEndpointAddress     0x81  EP 1 IN
-     * bmAttributes           15
-     *   Transfer Type            Isochronous
-     *   Synch Type               Asynchronous
-     *   Usage Type               Feedback
-     * wMaxPacketSize     0x0004  1x 4 bytes
-     * bInterval               4
-     */
-    /* ENDPOINT Descriptor */
-    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
-    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
-    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_IN << 7),  /* This is an IN endpoint with endpoint number 2   */
-    0x15U,                                          /* Types -
+    USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << 7),   /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
                                                        Transfer: ISOCHRONOUS
-                                                       Sync: Async
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
                                                        Usage: Data EP  */
-    USB_SHORT_GET_LOW(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE),
-    USB_SHORT_GET_HIGH(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE), /* Maximum packet size for this endpoint */
-    FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,                        /* The polling interval value */
+    USB_SHORT_GET_LOW(FS_ISO_IN_ENDP_PACKET_SIZE_24 + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24)),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_ENDP_PACKET_SIZE_24 + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24)), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
 
     /**
      * AudioStreaming Endpoint Descriptor:
@@ -926,26 +1128,842 @@ uint8_t g_UsbDeviceConfigurationDescriptor[] = {
     0x00U,
     0x00U,
     0x00U,
-};
-
-/* Define string descriptor */
-USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
-uint8_t g_UsbDeviceStringNull0[] = {
-    2U + 2U,
-    USB_DESCRIPTOR_TYPE_STRING,
-    0x09U,
-    0x04U,
-};
-
-USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
-uint8_t g_UsbDeviceStringManufacturer1[] = {
-    USB_STRING_MANUFACTURER};
 
-USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
-uint8_t g_UsbDeviceStringProduct2[] = {
-    USB_STRING_PRODUCT};
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        1
+     * bAlternateSetting       3
+     * bNumEndpoints           1
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             14
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
+    USB_AUDIO_STREAM_IN_INTERFACE_INDEX,    /*The number of this interface is 1.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_3, /* The value used to select the alternate setting for this interface is 3  */
+    USB_AUDIO_STREAM_IN_ENDPOINT_COUNT,     /* The number of endpoints used by this interface is 1 (excluding endpoint zero)    */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0EU,                                  /* Index of a string descriptor */
 
-USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                16
+     * bDescriptorType        36
+     * bDescriptorSubtype      1 (AS_GENERAL)
+     * bTerminalLink           3
+     * bmControls           0x00
+     * bFormatType             1
+     * bmFormats          0x00000001
+     *   PCM
+     * bNrChannels             8
+     * bmChannelConfig    0x00000000
+     * iChannelNames           0
+     */
+    USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
+    USB_AUDIO_IN_CONTROL_OUTPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+                                                                connected   */
+    0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
+                                                          D3..2: Valid Alternate Settings Control is not present
+                                                          D7..4: Reserved, should set to 0   */
+    USB_AUDIO_FORMAT_TYPE_I,                           /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x01U,
+    0x00U,
+    0x00U,
+    0x00U,                   /* The Audio Data Format that can be Used to communicate with this interface */
+    AUDIO_FORMAT_CHANNELS_8, /* Number of physical channels in the AS Interface audio channel cluster */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U, /* Describes the spatial location of the logical channels: */
+    0x00U, /* Index of a string descriptor, describing the name of the first physical channel   */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                 6
+     * bDescriptorType        36
+     * bDescriptorSubtype      2 (FORMAT_TYPE)
+     * bFormatType             1 (FORMAT_TYPE_I)
+     * bSubslotSize            4
+     * bBitResolution         32
+     */
+    USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
+    USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    AUDIO_FORMAT_SIZE,                                  /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    AUDIO_FORMAT_BITS,                                  /* The number of effectively used bits from the available bits in an audio subslot   */
+
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x82  EP 2 IN
+     * bmAttributes            5
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Data
+     * wMaxPacketSize     0x00e0  1x 224 bytes
+     * bInterval               1
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << 7),   /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_IN_ENDP_PACKET_SIZE_8CH + (AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE)),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_ENDP_PACKET_SIZE_8CH + (AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
+
+    /**
+     * AudioStreaming Endpoint Descriptor:
+     * bLength                 8
+     * bDescriptorType        37
+     * bDescriptorSubtype      1 (EP_GENERAL)
+     * bmAttributes         0x00
+     * bmControls           0x00
+     * bLockDelayUnits         0 Undefined
+     * wLockDelay         0x0000
+     */
+    USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH, /*  Size of the descriptor, in bytes  */
+    USB_AUDIO_STREAM_ENDPOINT_DESCRIPTOR,     /* CS_ENDPOINT Descriptor Type  */
+    USB_AUDIO_EP_GENERAL_DESCRIPTOR_SUBTYPE,  /* AUDIO_EP_GENERAL descriptor subtype  */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        1
+     * bAlternateSetting       4
+     * bNumEndpoints           1
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             14
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
+    USB_AUDIO_STREAM_IN_INTERFACE_INDEX,    /*The number of this interface is 1.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_4, /* The value used to select the alternate setting for this interface is 4  */
+    USB_AUDIO_STREAM_IN_ENDPOINT_COUNT,     /* The number of endpoints used by this interface is 1 (excluding endpoint zero)    */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0EU,                                  /* Index of a string descriptor */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                16
+     * bDescriptorType        36
+     * bDescriptorSubtype      1 (AS_GENERAL)
+     * bTerminalLink           3
+     * bmControls           0x00
+     * bFormatType             1
+     * bmFormats          0x00000001
+     *   PCM
+     * bNrChannels             2
+     * bmChannelConfig    0x00000000
+     * iChannelNames           0
+     */
+    USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
+    USB_AUDIO_IN_CONTROL_OUTPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+                                                                connected   */
+    0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
+                                                          D3..2: Valid Alternate Settings Control is not present
+                                                          D7..4: Reserved, should set to 0   */
+    USB_AUDIO_FORMAT_TYPE_I,                           /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x01U,
+    0x00U,
+    0x00U,
+    0x00U,                   /* The Audio Data Format that can be Used to communicate with this interface */
+    AUDIO_FORMAT_CHANNELS_2, /* Number of physical channels in the AS Interface audio channel cluster */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U, /* Describes the spatial location of the logical channels: */
+    0x00U, /* Index of a string descriptor, describing the name of the first physical channel   */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                 6
+     * bDescriptorType        36
+     * bDescriptorSubtype      2 (FORMAT_TYPE)
+     * bFormatType             1 (FORMAT_TYPE_I)
+     * bSubslotSize            4
+     * bBitResolution         32
+     */
+    USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
+    USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    AUDIO_FORMAT_SIZE,                                  /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    AUDIO_FORMAT_BITS,                                  /* The number of effectively used bits from the available bits in an audio subslot   */
+
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x82  EP 2 IN
+     * bmAttributes            5
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Data
+     * wMaxPacketSize     0x0038  1x 56 bytes
+     * bInterval               1
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_IN_ENDPOINT | (USB_IN << 7),   /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_IN_ENDP_PACKET_SIZE_2CH + (AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE)),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_ENDP_PACKET_SIZE_2CH + (AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
+
+    /**
+     * AudioStreaming Endpoint Descriptor:
+     * bLength                 8
+     * bDescriptorType        37
+     * bDescriptorSubtype      1 (EP_GENERAL)
+     * bmAttributes         0x00
+     * bmControls           0x00
+     * bLockDelayUnits         0 Undefined
+     * wLockDelay         0x0000
+     */
+    USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH, /*  Size of the descriptor, in bytes  */
+    USB_AUDIO_STREAM_ENDPOINT_DESCRIPTOR,     /* CS_ENDPOINT Descriptor Type  */
+    USB_AUDIO_EP_GENERAL_DESCRIPTOR_SUBTYPE,  /* AUDIO_EP_GENERAL descriptor subtype  */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        2
+     * bAlternateSetting       0
+     * bNumEndpoints           0
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             11
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /* The number of this interface is 2.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0, /* The value used to select the alternate setting for this interface is 0   */
+    0x00U,                                  /* The number of endpoints used by this interface is 0 (excluding endpoint zero)   */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0BU,                                  /* Index of a string descriptor */
+
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        2
+     * bAlternateSetting       1
+     * bNumEndpoints           2
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             12
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
+    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /*The number of this interface is 2.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_1, /* The value used to select the alternate setting for this interface is 1  */
+    USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,    /* The number of endpoints used by this interface */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0CU,                                  /* Index of a string descriptor */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                16
+     * bDescriptorType        36
+     * bDescriptorSubtype      1 (AS_GENERAL)
+     * bTerminalLink           4
+     * bmControls           0x00
+     * bFormatType             1
+     * bmFormats          0x00000001
+     *   PCM
+     * bNrChannels            16
+     * bmChannelConfig    0x00000000
+     * iChannelNames           0
+     */
+    USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
+    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+                                                                connected   */
+    0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
+                                                          D3..2: Valid Alternate Settings Control is not present
+                                                          D7..4: Reserved, should set to 0   */
+    USB_AUDIO_FORMAT_TYPE_I,                           /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x01U,
+    0x00U,
+    0x00U,
+    0x00U,                 /* The Audio Data Format that can be Used to communicate with this interface */
+    AUDIO_FORMAT_CHANNELS, /* Number of physical channels in the AS Interface audio channel cluster */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U, /* Describes the spatial location of the logical channels: */
+    0x00U, /* Index of a string descriptor, describing the name of the first physical channel   */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                 6
+     * bDescriptorType        36
+     * bDescriptorSubtype      2 (FORMAT_TYPE)
+     * bFormatType             1 (FORMAT_TYPE_I)
+     * bSubslotSize            4
+     * bBitResolution         32
+     */
+    USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
+    USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x04U,                                              /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    0x20U,                                              /* The number of effectively used bits from the available bits in an audio subslot   */
+
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x01  EP 1 OUT
+     * bmAttributes            5
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Data
+     * wMaxPacketSize     0x01C0  1x 448 bytes
+     * bInterval               1
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << 7), /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)),
+    USB_SHORT_GET_HIGH(FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
+    FS_ISO_OUT_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
+
+#if !USB_AUDIO_SYNC_MODE
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x81  EP 1 IN
+     * bmAttributes           15
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Feedback
+     * wMaxPacketSize     0x0004  1x 4 bytes
+     * bInterval               4
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_IN << 7),  /* This is an IN endpoint with endpoint number 2   */
+    0x15U,                                          /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,                        /* The polling interval value */
+#endif
+
+    /**
+     * AudioStreaming Endpoint Descriptor:
+     * bLength                 8
+     * bDescriptorType        37
+     * bDescriptorSubtype      1 (EP_GENERAL)
+     * bmAttributes         0x00
+     * bmControls           0x00
+     * bLockDelayUnits         0 Undefined
+     * wLockDelay         0x0000
+     */
+    USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH, /*  Size of the descriptor, in bytes  */
+    USB_AUDIO_STREAM_ENDPOINT_DESCRIPTOR,     /* CS_ENDPOINT Descriptor Type  */
+    USB_AUDIO_EP_GENERAL_DESCRIPTOR_SUBTYPE,  /* AUDIO_EP_GENERAL descriptor subtype  */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        2
+     * bAlternateSetting       2
+     * bNumEndpoints           2
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             12
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
+    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /*The number of this interface is 2.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_2, /* The value used to select the alternate setting for this interface is 2  */
+    USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,    /* The number of endpoints used by this interface */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0CU,                                  /* Index of a string descriptor */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                16
+     * bDescriptorType        36
+     * bDescriptorSubtype      1 (AS_GENERAL)
+     * bTerminalLink           4
+     * bmControls           0x00
+     * bFormatType             1
+     * bmFormats          0x00000001
+     *   PCM
+     * bNrChannels            16
+     * bmChannelConfig    0x00000000
+     * iChannelNames           0
+     */
+    USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
+    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+                                                                connected   */
+    0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
+                                                          D3..2: Valid Alternate Settings Control is not present
+                                                          D7..4: Reserved, should set to 0   */
+    USB_AUDIO_FORMAT_TYPE_I,                           /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x01U,
+    0x00U,
+    0x00U,
+    0x00U,                 /* The Audio Data Format that can be Used to communicate with this interface */
+    AUDIO_FORMAT_CHANNELS, /* Number of physical channels in the AS Interface audio channel cluster */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U, /* Describes the spatial location of the logical channels: */
+    0x00U, /* Index of a string descriptor, describing the name of the first physical channel   */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                 6
+     * bDescriptorType        36
+     * bDescriptorSubtype      2 (FORMAT_TYPE)
+     * bFormatType             1 (FORMAT_TYPE_I)
+     * bSubslotSize            3
+     * bBitResolution         24
+     */
+    USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
+    USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    AUDIO_FORMAT_SIZE_24,                               /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    AUDIO_FORMAT_BITS_24,                               /* The number of effectively used bits from the available bits in an audio subslot   */
+
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x01  EP 1 OUT
+     * bmAttributes            5
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Data
+     * wMaxPacketSize     0x0150  1x 336 bytes
+     * bInterval               1
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << 7), /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_OUT_ENDP_PACKET_SIZE_24 + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24)),
+    USB_SHORT_GET_HIGH(FS_ISO_OUT_ENDP_PACKET_SIZE_24 + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24)), /* Maximum packet size for this endpoint */
+    FS_ISO_OUT_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
+
+#if !USB_AUDIO_SYNC_MODE
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x81  EP 1 IN
+     * bmAttributes           15
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Feedback
+     * wMaxPacketSize     0x0004  1x 4 bytes
+     * bInterval               4
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_IN << 7),  /* This is an IN endpoint with endpoint number 2   */
+    0x15U,                                          /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,                        /* The polling interval value */
+#endif
+
+    /**
+     * AudioStreaming Endpoint Descriptor:
+     * bLength                 8
+     * bDescriptorType        37
+     * bDescriptorSubtype      1 (EP_GENERAL)
+     * bmAttributes         0x00
+     * bmControls           0x00
+     * bLockDelayUnits         0 Undefined
+     * wLockDelay         0x0000
+     */
+    USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH, /*  Size of the descriptor, in bytes  */
+    USB_AUDIO_STREAM_ENDPOINT_DESCRIPTOR,     /* CS_ENDPOINT Descriptor Type  */
+    USB_AUDIO_EP_GENERAL_DESCRIPTOR_SUBTYPE,  /* AUDIO_EP_GENERAL descriptor subtype  */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        2
+     * bAlternateSetting       3
+     * bNumEndpoints           2
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             12
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
+    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /*The number of this interface is 2.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_3, /* The value used to select the alternate setting for this interface is 3  */
+    USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,    /* The number of endpoints used by this interface */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0CU,                                  /* Index of a string descriptor */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                16
+     * bDescriptorType        36
+     * bDescriptorSubtype      1 (AS_GENERAL)
+     * bTerminalLink           4
+     * bmControls           0x00
+     * bFormatType             1
+     * bmFormats          0x00000001
+     *   PCM
+     * bNrChannels             8
+     * bmChannelConfig    0x00000000
+     * iChannelNames           0
+     */
+    USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
+    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+                                                                connected   */
+    0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
+                                                          D3..2: Valid Alternate Settings Control is not present
+                                                          D7..4: Reserved, should set to 0   */
+    USB_AUDIO_FORMAT_TYPE_I,                           /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x01U,
+    0x00U,
+    0x00U,
+    0x00U,                   /* The Audio Data Format that can be Used to communicate with this interface */
+    AUDIO_FORMAT_CHANNELS_8, /* Number of physical channels in the AS Interface audio channel cluster */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U, /* Describes the spatial location of the logical channels: */
+    0x00U, /* Index of a string descriptor, describing the name of the first physical channel   */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                 6
+     * bDescriptorType        36
+     * bDescriptorSubtype      2 (FORMAT_TYPE)
+     * bFormatType             1 (FORMAT_TYPE_I)
+     * bSubslotSize            4
+     * bBitResolution         32
+     */
+    USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
+    USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    AUDIO_FORMAT_SIZE,                                  /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    AUDIO_FORMAT_BITS,                                  /* The number of effectively used bits from the available bits in an audio subslot   */
+
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x01  EP 1 OUT
+     * bmAttributes            5
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Data
+     * wMaxPacketSize     0x00e0  1x 224 bytes
+     * bInterval               1
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << 7), /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_OUT_ENDP_PACKET_SIZE_8CH + (AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE)),
+    USB_SHORT_GET_HIGH(FS_ISO_OUT_ENDP_PACKET_SIZE_8CH + (AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
+    FS_ISO_OUT_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
+
+#if !USB_AUDIO_SYNC_MODE
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x81  EP 1 IN
+     * bmAttributes           15
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Feedback
+     * wMaxPacketSize     0x0004  1x 4 bytes
+     * bInterval               4
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_IN << 7),  /* This is an IN endpoint with endpoint number 2   */
+    0x15U,                                          /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,                        /* The polling interval value */
+#endif
+
+    /**
+     * AudioStreaming Endpoint Descriptor:
+     * bLength                 8
+     * bDescriptorType        37
+     * bDescriptorSubtype      1 (EP_GENERAL)
+     * bmAttributes         0x00
+     * bmControls           0x00
+     * bLockDelayUnits         0 Undefined
+     * wLockDelay         0x0000
+     */
+    USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH, /*  Size of the descriptor, in bytes  */
+    USB_AUDIO_STREAM_ENDPOINT_DESCRIPTOR,     /* CS_ENDPOINT Descriptor Type  */
+    USB_AUDIO_EP_GENERAL_DESCRIPTOR_SUBTYPE,  /* AUDIO_EP_GENERAL descriptor subtype  */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+
+    /**
+     * Interface Descriptor:
+     * bLength                 9
+     * bDescriptorType         4
+     * bInterfaceNumber        2
+     * bAlternateSetting       4
+     * bNumEndpoints           2
+     * bInterfaceClass         1 Audio
+     * bInterfaceSubClass      2 Streaming
+     * bInterfaceProtocol     32
+     * iInterface             12
+     */
+    USB_DESCRIPTOR_LENGTH_INTERFACE,        /* Descriptor size is 9 bytes  */
+    USB_DESCRIPTOR_TYPE_INTERFACE,          /* INTERFACE Descriptor Type  */
+    USB_AUDIO_STREAM_OUT_INTERFACE_INDEX,   /*The number of this interface is 2.  */
+    USB_AUDIO_STREAM_INTERFACE_ALTERNATE_4, /* The value used to select the alternate setting for this interface is 4  */
+    USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT,    /* The number of endpoints used by this interface */
+    USB_AUDIO_CLASS,                        /* The interface implements the Audio Interface class  */
+    USB_SUBCLASS_AUDIOSTREAM,               /* The interface implements the AUDIOSTREAMING Subclass  */
+    USB_AUDIO_PROTOCOL,                     /* The Protocol code is 32   */
+    0x0CU,                                  /* Index of a string descriptor */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                16
+     * bDescriptorType        36
+     * bDescriptorSubtype      1 (AS_GENERAL)
+     * bTerminalLink           4
+     * bmControls           0x00
+     * bFormatType             1
+     * bmFormats          0x00000001
+     *   PCM
+     * bNrChannels             2
+     * bmChannelConfig    0x00000000
+     * iChannelNames           0
+     */
+    USB_AUDIO_AS_INTERFACE_DESC_LENGTH,                /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,            /* CS_INTERFACE Descriptor Type  */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_AS_GENERAL, /* AS_GENERAL descriptor subtype   */
+    USB_AUDIO_OUT_CONTROL_INPUT_TERMINAL_ID,           /* The Terminal ID of the terminal to which this interface is
+                                                                connected   */
+    0x00U,                                             /* bmControls : D1..0: Active Alternate Setting Control is not present
+                                                          D3..2: Valid Alternate Settings Control is not present
+                                                          D7..4: Reserved, should set to 0   */
+    USB_AUDIO_FORMAT_TYPE_I,                           /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    0x01U,
+    0x00U,
+    0x00U,
+    0x00U,                   /* The Audio Data Format that can be Used to communicate with this interface */
+    AUDIO_FORMAT_CHANNELS_2, /* Number of physical channels in the AS Interface audio channel cluster */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U, /* Describes the spatial location of the logical channels: */
+    0x00U, /* Index of a string descriptor, describing the name of the first physical channel   */
+
+    /**
+     * AudioStreaming Interface Descriptor:
+     * bLength                 6
+     * bDescriptorType        36
+     * bDescriptorSubtype      2 (FORMAT_TYPE)
+     * bFormatType             1 (FORMAT_TYPE_I)
+     * bSubslotSize            4
+     * bBitResolution         32
+     */
+    USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH,           /* Size of the descriptor, in bytes   */
+    USB_DESCRIPTOR_TYPE_AUDIO_CS_INTERFACE,             /* CS_INTERFACE Descriptor Type   */
+    USB_DESCRIPTOR_SUBTYPE_AUDIO_STREAMING_FORMAT_TYPE, /* FORMAT_TYPE descriptor subtype   */
+    USB_AUDIO_FORMAT_TYPE_I,                            /* The format type AudioStreaming interfae using is FORMAT_TYPE_I (0x01)   */
+    AUDIO_FORMAT_SIZE,                                  /* The number of bytes occupied by one audio subslot. Can be 1, 2, 3 or 4.  */
+    AUDIO_FORMAT_BITS,                                  /* The number of effectively used bits from the available bits in an audio subslot   */
+
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x01  EP 1 OUT
+     * bmAttributes            5
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Data
+     * wMaxPacketSize     0x0038  1x 56 bytes
+     * bInterval               1
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_OUT << 7), /* This is an IN endpoint with endpoint number 2   */
+    USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES,           /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async (Sync with USB_AUDIO_SYNC_MODE)
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_OUT_ENDP_PACKET_SIZE_2CH + (AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE)),
+    USB_SHORT_GET_HIGH(FS_ISO_OUT_ENDP_PACKET_SIZE_2CH + (AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE)), /* Maximum packet size for this endpoint */
+    FS_ISO_OUT_ENDP_INTERVAL,                                                                      /* The polling interval value is every 1 Frames. If Hi-Speed, every 1 uFrames   */
+
+#if !USB_AUDIO_SYNC_MODE
+    /**
+     * Endpoint Descriptor:
+     * bLength                 7
+     * bDescriptorType         5
+     * bEndpointAddress     0x81  EP 1 IN
+     * bmAttributes           15
+     *   Transfer Type            Isochronous
+     *   Synch Type               Asynchronous
+     *   Usage Type               Feedback
+     * wMaxPacketSize     0x0004  1x 4 bytes
+     * bInterval               4
+     */
+    /* ENDPOINT Descriptor */
+    USB_AUDIO_STANDARD_AS_ISO_DATA_ENDPOINT_LENGTH, /* Descriptor size is 7 bytes  */
+    USB_DESCRIPTOR_TYPE_ENDPOINT,                   /* ENDPOINT Descriptor Type   */
+    USB_AUDIO_STREAM_OUT_ENDPOINT | (USB_IN << 7),  /* This is an IN endpoint with endpoint number 2   */
+    0x15U,                                          /* Types -
+                                                       Transfer: ISOCHRONOUS
+                                                       Sync: Async
+                                                       Usage: Data EP  */
+    USB_SHORT_GET_LOW(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE),
+    USB_SHORT_GET_HIGH(FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE), /* Maximum packet size for this endpoint */
+    FS_ISO_IN_FEEDBACK_ENDP_INTERVAL,                        /* The polling interval value */
+#endif
+
+    /**
+     * AudioStreaming Endpoint Descriptor:
+     * bLength                 8
+     * bDescriptorType        37
+     * bDescriptorSubtype      1 (EP_GENERAL)
+     * bmAttributes         0x00
+     * bmControls           0x00
+     * bLockDelayUnits         0 Undefined
+     * wLockDelay         0x0000
+     */
+    USB_AUDIO_CLASS_SPECIFIC_ENDPOINT_LENGTH, /*  Size of the descriptor, in bytes  */
+    USB_AUDIO_STREAM_ENDPOINT_DESCRIPTOR,     /* CS_ENDPOINT Descriptor Type  */
+    USB_AUDIO_EP_GENERAL_DESCRIPTOR_SUBTYPE,  /* AUDIO_EP_GENERAL descriptor subtype  */
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+    0x00U,
+};
+
+/* Define string descriptor */
+USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
+uint8_t g_UsbDeviceStringNull0[] = {
+    2U + 2U,
+    USB_DESCRIPTOR_TYPE_STRING,
+    0x09U,
+    0x04U,
+};
+
+USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
+uint8_t g_UsbDeviceStringManufacturer1[] = {
+    USB_STRING_MANUFACTURER};
+
+USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
+uint8_t g_UsbDeviceStringProduct2[] = {
+    USB_STRING_PRODUCT};
+
+USB_DMA_INIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 uint8_t g_UsbDeviceStringSerial3[] = {
     USB_STRING_SERIAL};
 
@@ -1130,6 +2148,84 @@ usb_status_t USB_DeviceGetStringDescriptor(usb_device_handle handle,
     return kStatus_USB_Success;
 }
 
+/*!
+ * @brief Number of channels of a streaming alternate setting.
+ *
+ * The channels are the first TDM slots, the I2S side always runs the full
+ * frame.
+ */
+uint8_t USB_DeviceGetStreamChannels(uint8_t alternate)
+{
+    if (alternate >= USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT)
+    {
+        return AUDIO_FORMAT_CHANNELS;
+    }
+
+    return s_UsbDeviceAudioStreamFormat[alternate].channels;
+}
+
+/*!
+ * @brief Subslot size of a streaming alternate setting.
+ */
+uint8_t USB_DeviceGetStreamSubslotSize(uint8_t alternate)
+{
+    if (alternate >= USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT)
+    {
+        return AUDIO_FORMAT_SIZE;
+    }
+
+    return s_UsbDeviceAudioStreamFormat[alternate].subslotSize;
+}
+
+/*!
+ * @brief bInterval of the streaming data endpoints.
+ */
+uint8_t USB_DeviceGetStreamInterval(uint8_t speed, uint8_t alternate)
+{
+    if ((USB_SPEED_HIGH != speed) || (alternate >= USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT))
+    {
+        return FS_ISO_IN_ENDP_INTERVAL;
+    }
+
+    return s_UsbDeviceAudioStreamFormat[alternate].interval;
+}
+
+/*!
+ * @brief Microframes between two packets of the streaming data endpoints.
+ */
+uint32_t USB_DeviceGetStreamUframes(uint8_t speed, uint8_t alternate)
+{
+    if (USB_SPEED_HIGH != speed)
+    {
+        return 1U;
+    }
+
+    return 1U << (USB_DeviceGetStreamInterval(speed, alternate) - 1U);
+}
+
+/*!
+ * @brief Max packet size of the streaming data endpoints.
+ *
+ * One frame more than the nominal packet (rounded up for the 44.1 kHz family),
+ * to leave room for the rate adaptation. Never more than what a single
+ * isochronous transaction can carry, the build checks that it fits at the max
+ * rate (see HS_ISO_ENDP_PACKET_SIZE_AT_MAX).
+ */
+uint32_t USB_DeviceGetStreamPacketSize(uint8_t speed, uint8_t alternate, uint32_t rate)
+{
+    uint32_t frameSize = USB_DeviceGetStreamChannels(alternate) * USB_DeviceGetStreamSubslotSize(alternate);
+    uint32_t size;
+
+    if (USB_SPEED_HIGH == speed)
+    {
+        size = ((((rate * USB_DeviceGetStreamUframes(speed, alternate)) + 7999U) / 8000U) + 1U) * frameSize;
+        return (size > HS_ISO_MAX_PACKET_SIZE) ? HS_ISO_MAX_PACKET_SIZE : size;
+    }
+
+    size = (((rate + 999U) / 1000U) + 1U) * frameSize;
+    return (size > FS_ISO_MAX_PACKET_SIZE) ? FS_ISO_MAX_PACKET_SIZE : size;
+}
+
 /** Due to the difference of HS and FS descriptors, the device descriptors and configurations need to be updated to match
  * current speed.
  * As the default, the device descriptors and configurations are configured by using FS parameters for both EHCI and
@@ -1140,6 +2236,7 @@ usb_status_t USB_DeviceSetSpeed(usb_device_handle handle, uint8_t speed)
 {
     usb_descriptor_union_t *descriptorHead;
     usb_descriptor_union_t *descriptorTail;
+    uint8_t alternate = 0U;
 
     descriptorHead = (usb_descriptor_union_t *)&g_UsbDeviceConfigurationDescriptor[0];
     descriptorTail =
@@ -1147,6 +2244,15 @@ usb_status_t USB_DeviceSetSpeed(usb_device_handle handle, uint8_t speed)
 
     while (descriptorHead < descriptorTail)
     {
+        /**
+         * The data endpoints are the same for all the alternate settings, with different packet sizes (for the max
+         * sampling rate) and intervals
+         */
+        if (descriptorHead->common.bDescriptorType == USB_DESCRIPTOR_TYPE_INTERFACE)
+        {
+            alternate = descriptorHead->interface.bAlternateSetting;
+        }
+
         if (descriptorHead->common.bDescriptorType == USB_DESCRIPTOR_TYPE_ENDPOINT)
         {
             if (USB_SPEED_HIGH == speed)
@@ -1154,15 +2260,15 @@ usb_status_t USB_DeviceSetSpeed(usb_device_handle handle, uint8_t speed)
                 if ((USB_AUDIO_STREAM_IN_ENDPOINT == (descriptorHead->endpoint.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK)) &&
                     ((descriptorHead->endpoint.bEndpointAddress >> USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT) == USB_IN))
                 {
-                    descriptorHead->endpoint.bInterval = HS_ISO_IN_ENDP_INTERVAL;
-                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(HS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE), descriptorHead->endpoint.wMaxPacketSize);
+                    descriptorHead->endpoint.bInterval = USB_DeviceGetStreamInterval(speed, alternate);
+                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(USB_DeviceGetStreamPacketSize(speed, alternate, AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U), descriptorHead->endpoint.wMaxPacketSize);
                 }
 
                 if ((USB_AUDIO_STREAM_OUT_ENDPOINT == (descriptorHead->endpoint.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK)) &&
                     ((descriptorHead->endpoint.bEndpointAddress >> USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT) == USB_OUT))
                 {
-                    descriptorHead->endpoint.bInterval = HS_ISO_OUT_ENDP_INTERVAL;
-                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(HS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE), descriptorHead->endpoint.wMaxPacketSize);
+                    descriptorHead->endpoint.bInterval = USB_DeviceGetStreamInterval(speed, alternate);
+                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(USB_DeviceGetStreamPacketSize(speed, alternate, AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U), descriptorHead->endpoint.wMaxPacketSize);
                 }
 
                 if ((USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT == (descriptorHead->endpoint.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK)) &&
@@ -1178,14 +2284,14 @@ usb_status_t USB_DeviceSetSpeed(usb_device_handle handle, uint8_t speed)
                     ((descriptorHead->endpoint.bEndpointAddress >> USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT) == USB_IN))
                 {
                     descriptorHead->endpoint.bInterval = FS_ISO_IN_ENDP_INTERVAL;
-                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(FS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE), descriptorHead->endpoint.wMaxPacketSize);
+                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(USB_DeviceGetStreamPacketSize(speed, alternate, AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U), descriptorHead->endpoint.wMaxPacketSize);
                 }
 
                 if ((USB_AUDIO_STREAM_OUT_ENDPOINT == (descriptorHead->endpoint.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK)) &&
                     ((descriptorHead->endpoint.bEndpointAddress >> USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT) == USB_OUT))
                 {
                     descriptorHead->endpoint.bInterval = FS_ISO_OUT_ENDP_INTERVAL;
-                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE), descriptorHead->endpoint.wMaxPacketSize);
+                    USB_SHORT_TO_LITTLE_ENDIAN_ADDRESS(USB_DeviceGetStreamPacketSize(speed, alternate, AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U), descriptorHead->endpoint.wMaxPacketSize);
                 }
 
                 if ((USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT == (descriptorHead->endpoint.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK)) &&
@@ -1199,27 +2305,29 @@ usb_status_t USB_DeviceSetSpeed(usb_device_handle handle, uint8_t speed)
         descriptorHead = (usb_descriptor_union_t *)((uint8_t *)descriptorHead + descriptorHead->common.bLength);
     }
 
-    if (USB_SPEED_HIGH == speed)
-    {
-        g_UsbDeviceAudiodeviceInEndpoints[0].maxPacketSize = HS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE);
-        g_UsbDeviceAudiodeviceInEndpoints[0].interval = HS_ISO_IN_ENDP_INTERVAL;
-
-        g_UsbDeviceAudiodeviceOutEndpoints[0].maxPacketSize = HS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE);
-        g_UsbDeviceAudiodeviceOutEndpoints[0].interval = HS_ISO_OUT_ENDP_INTERVAL;
-
-        g_UsbDeviceAudiodeviceOutEndpoints[1].maxPacketSize = HS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE;
-        g_UsbDeviceAudiodeviceOutEndpoints[1].interval = HS_ISO_IN_FEEDBACK_ENDP_INTERVAL;
-    }
-    else
+    /* The class opens the endpoints of the alternate setting selected by the host */
+    for (uint8_t alt = USB_AUDIO_STREAM_INTERFACE_ALTERNATE_1; alt < USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT; alt++)
     {
-        g_UsbDeviceAudiodeviceInEndpoints[0].maxPacketSize = FS_ISO_IN_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE);
-        g_UsbDeviceAudiodeviceInEndpoints[0].interval = FS_ISO_IN_ENDP_INTERVAL;
+        usb_device_endpoint_struct_t *in = g_UsbDeviceAudioStreamInInterface[alt].endpointList.endpoint;
+        usb_device_endpoint_struct_t *out = g_UsbDeviceAudioStreamOutInterface[alt].endpointList.endpoint;
 
-        g_UsbDeviceAudiodeviceOutEndpoints[0].maxPacketSize = FS_ISO_OUT_ENDP_PACKET_SIZE + (AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE);
-        g_UsbDeviceAudiodeviceOutEndpoints[0].interval = FS_ISO_OUT_ENDP_INTERVAL;
+        in[0].maxPacketSize = USB_DeviceGetStreamPacketSize(speed, alt, AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U);
+        out[0].maxPacketSize = USB_DeviceGetStreamPacketSize(speed, alt, AUDIO_SAMPLING_RATE_MAX_KHZ * 1000U);
 
-        g_UsbDeviceAudiodeviceOutEndpoints[1].maxPacketSize = FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE;
-        g_UsbDeviceAudiodeviceOutEndpoints[1].interval = FS_ISO_IN_FEEDBACK_ENDP_INTERVAL;
+        if (USB_SPEED_HIGH == speed)
+        {
+            in[0].interval = USB_DeviceGetStreamInterval(speed, alt);
+            out[0].interval = USB_DeviceGetStreamInterval(speed, alt);
+            out[1].maxPacketSize = HS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE;
+            out[1].interval = HS_ISO_IN_FEEDBACK_ENDP_INTERVAL;
+        }
+        else
+        {
+            in[0].interval = FS_ISO_IN_ENDP_INTERVAL;
+            out[0].interval = FS_ISO_OUT_ENDP_INTERVAL;
+            out[1].maxPacketSize = FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE;
+            out[1].interval = FS_ISO_IN_FEEDBACK_ENDP_INTERVAL;
+        }
     }
 
     return kStatus_USB_Success;
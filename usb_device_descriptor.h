@@ -30,6 +30,7 @@
 #define USB_AUDIO_CLOCK_SOURCE_DESC_LENGTH (8U)
 #define USB_AUDIO_INPUT_TERMINAL_DESC_LENGTH (17U)
 #define USB_AUDIO_OUTPUT_TERMINAL_DESC_LENGTH (12U)
+#define USB_AUDIO_FEATURE_UNIT_DESC_LENGTH (6U + ((USB_AUDIO_FEATURE_UNIT_CHANNELS + 1U) * 4U))
 #define USB_AUDIO_AS_INTERFACE_DESC_LENGTH (16U)
 #define USB_AUDIO_TYPE_I_FORMAT_TYPE_DESC_LENGTH (6U)
 
@@ -45,10 +46,36 @@
 #define USB_AUDIO_STREAM_IN_INTERFACE_INDEX (1U)
 #define USB_AUDIO_STREAM_OUT_INTERFACE_INDEX (2U)
 
+/**
+ * Set USB_AUDIO_SYNC_MODE to (1) to run both streaming endpoints as
+ * synchronous: the Audio PLL is disciplined to the SOF (see sync.h) and the
+ * OUT endpoint has no feedback endpoint. Requires I2S_MASTER.
+ */
+#ifndef USB_AUDIO_SYNC_MODE
+#define USB_AUDIO_SYNC_MODE (0)
+#endif
+
 #define USB_AUDIO_STREAM_IN_ENDPOINT_COUNT (1U)
+#if USB_AUDIO_SYNC_MODE
+#define USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT (1U)
+#else
 #define USB_AUDIO_STREAM_OUT_ENDPOINT_COUNT (2U)
+#endif
 #define USB_AUDIO_CONTROL_ENDPOINT_COUNT (1U)
 
+/**
+ * bmAttributes of the data endpoints (isochronous, asynchronous or synchronous,
+ * data) and of the clock sources (internal programmable, synchronized to SOF
+ * or not).
+ */
+#if USB_AUDIO_SYNC_MODE
+#define USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES (0x0DU)
+#define USB_AUDIO_CLOCK_SOURCE_ATTRIBUTES (0x07U)
+#else
+#define USB_AUDIO_STREAM_ENDPOINT_ATTRIBUTES (0x05U)
+#define USB_AUDIO_CLOCK_SOURCE_ATTRIBUTES (0x03U)
+#endif
+
 #define USB_AUDIO_STREAM_IN_ENDPOINT (2U)
 #define USB_AUDIO_STREAM_OUT_ENDPOINT (1U)
 #define USB_AUDIO_STREAM_IN_FEEDBACK_ENDPOINT (1U)
@@ -59,17 +86,46 @@
 #define USB_AUDIO_INTERFACE_COUNT (USB_AUDIO_CONTROL_INTERFACE_COUNT + USB_AUDIO_STREAM_INTERFACE_COUNT)
 
 #define USB_AUDIO_CONTROL_INTERFACE_ALTERNATE_COUNT (1U)
-#define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT (2U)
+#define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_COUNT (5U)
 #define USB_AUDIO_CONTROL_INTERFACE_ALTERNATE_0 (0U)
 #define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_0 (0U)
 #define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_1 (1U)
+#define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_2 (2U)
+#define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_3 (3U)
+#define USB_AUDIO_STREAM_INTERFACE_ALTERNATE_4 (4U)
 
 /* Audio data format */
 #define AUDIO_SAMPLING_RATE_KHZ (48U)
+
+/**
+ * Sampling rates advertised by the clock sources (see g_audioDevice), the
+ * device boots at AUDIO_SAMPLING_RATE_KHZ. The endpoints and the I2S buffers
+ * are sized for AUDIO_SAMPLING_RATE_MAX_KHZ.
+ *
+ * 96 kHz is only advertised when AUDIO_SAMPLING_RATE_MAX_KHZ is (96). Higher
+ * rates are not supported: a full-width packet at 192 kHz (1600 bytes) does not
+ * fit the single isochronous transaction per microframe of the endpoints.
+ */
+#ifndef AUDIO_SAMPLING_RATE_MAX_KHZ
+#define AUDIO_SAMPLING_RATE_MAX_KHZ (96U)
+#endif
+#if (AUDIO_SAMPLING_RATE_MAX_KHZ >= 96U)
+#define AUDIO_SAMPLING_RATE_COUNT (3U)
+#else
+#define AUDIO_SAMPLING_RATE_COUNT (2U)
+#endif
 #define AUDIO_FORMAT_CHANNELS (0x10U)
 #define AUDIO_FORMAT_BITS (32U)
 #define AUDIO_FORMAT_SIZE (0x04U)
 
+/* Packed 24-bit format (alternate setting 2) */
+#define AUDIO_FORMAT_BITS_24 (24U)
+#define AUDIO_FORMAT_SIZE_24 (0x03U)
+
+/* Fewer channels, the first TDM slots (alternate settings 3 and 4) */
+#define AUDIO_FORMAT_CHANNELS_8 (0x08U)
+#define AUDIO_FORMAT_CHANNELS_2 (0x02U)
+
 /* Packet size and interval. */
 #define HS_INTERRUPT_IN_PACKET_SIZE (8U)
 #define FS_INTERRUPT_IN_PACKET_SIZE (8U)
@@ -84,13 +140,100 @@
 #define HS_ISO_OUT_ENDP_PACKET_SIZE ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE) / 8)
 #define FS_ISO_OUT_ENDP_PACKET_SIZE (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE)
 
+#define HS_ISO_IN_ENDP_PACKET_SIZE_24 ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24) / 8)
+#define FS_ISO_IN_ENDP_PACKET_SIZE_24 (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24)
+
+#define HS_ISO_OUT_ENDP_PACKET_SIZE_24 ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24) / 8)
+#define FS_ISO_OUT_ENDP_PACKET_SIZE_24 (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE_24)
+
+#define HS_ISO_IN_ENDP_PACKET_SIZE_8CH ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE) / 8)
+#define FS_ISO_IN_ENDP_PACKET_SIZE_8CH (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE)
+
+#define HS_ISO_OUT_ENDP_PACKET_SIZE_8CH ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE) / 8)
+#define FS_ISO_OUT_ENDP_PACKET_SIZE_8CH (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_8 * AUDIO_FORMAT_SIZE)
+
+#define HS_ISO_IN_ENDP_PACKET_SIZE_2CH ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE) / 8)
+#define FS_ISO_IN_ENDP_PACKET_SIZE_2CH (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE)
+
+#define HS_ISO_OUT_ENDP_PACKET_SIZE_2CH ((AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE) / 8)
+#define FS_ISO_OUT_ENDP_PACKET_SIZE_2CH (AUDIO_SAMPLING_RATE_KHZ * AUDIO_FORMAT_CHANNELS_2 * AUDIO_FORMAT_SIZE)
+
+/**
+ * HS bInterval of the streaming data endpoints, per alternate setting: one
+ * packet every 2^(bInterval - 1) microframes, from 1 (125us) to 3 (500us). The
+ * packet sizes, the implicit feedback and the TX fill level target follow it,
+ * fewer and larger packets mean fewer USB interrupts.
+ *
+ * The I2S rings hold a packet of the longest interval at the max sampling
+ * rate, so AUDIO_SAMPLING_RATE_MAX_KHZ times the microframes per packet is
+ * limited like the rate alone: 96 with the interleaved data paths, 192 with
+ * the copy based ones. The max rate is at least AUDIO_SAMPLING_RATE_KHZ (48),
+ * which allows 4 microframes at most: 4 (1ms, 8 microframes) is rejected.
+ */
+#ifndef HS_ISO_ENDP_INTERVAL_ALT_1
+#define HS_ISO_ENDP_INTERVAL_ALT_1 (0x01U)
+#endif
+#ifndef HS_ISO_ENDP_INTERVAL_ALT_2
+#define HS_ISO_ENDP_INTERVAL_ALT_2 (0x01U)
+#endif
+#ifndef HS_ISO_ENDP_INTERVAL_ALT_3
+#define HS_ISO_ENDP_INTERVAL_ALT_3 (0x01U)
+#endif
+#ifndef HS_ISO_ENDP_INTERVAL_ALT_4
+#define HS_ISO_ENDP_INTERVAL_ALT_4 (0x01U)
+#endif
+
+#define HS_ISO_ENDP_INTERVAL_MAX2(a, b) (((a) > (b)) ? (a) : (b))
+#define HS_ISO_ENDP_INTERVAL_MAX                                                              \
+    HS_ISO_ENDP_INTERVAL_MAX2(HS_ISO_ENDP_INTERVAL_MAX2(HS_ISO_ENDP_INTERVAL_ALT_1, HS_ISO_ENDP_INTERVAL_ALT_2), \
+                              HS_ISO_ENDP_INTERVAL_MAX2(HS_ISO_ENDP_INTERVAL_ALT_3, HS_ISO_ENDP_INTERVAL_ALT_4))
+
+/** Microframes per packet for the longest interval [1] */
+#define HS_ISO_ENDP_INTERVAL_MAX_UFRAMES (1U << (HS_ISO_ENDP_INTERVAL_MAX - 1U))
+
+#if (HS_ISO_ENDP_INTERVAL_MAX > 3U) || (HS_ISO_ENDP_INTERVAL_ALT_1 < 1U) || (HS_ISO_ENDP_INTERVAL_ALT_2 < 1U) || \
+    (HS_ISO_ENDP_INTERVAL_ALT_3 < 1U) || (HS_ISO_ENDP_INTERVAL_ALT_4 < 1U)
+#error "HS_ISO_ENDP_INTERVAL_ALT_n must be between 1 and 3"
+#endif
+
+#if ((AUDIO_SAMPLING_RATE_MAX_KHZ * HS_ISO_ENDP_INTERVAL_MAX_UFRAMES) > 192U)
+#error "AUDIO_SAMPLING_RATE_MAX_KHZ too high for the HS_ISO_ENDP_INTERVAL_ALT_n packets"
+#endif
+
+/** At the max sampling rate and the longest interval, for the buffers */
+#define HS_ISO_IN_ENDP_PACKET_SIZE_MAX \
+    ((AUDIO_SAMPLING_RATE_MAX_KHZ * HS_ISO_ENDP_INTERVAL_MAX_UFRAMES * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE) / 8)
+#define HS_ISO_OUT_ENDP_PACKET_SIZE_MAX \
+    ((AUDIO_SAMPLING_RATE_MAX_KHZ * HS_ISO_ENDP_INTERVAL_MAX_UFRAMES * AUDIO_FORMAT_CHANNELS * AUDIO_FORMAT_SIZE) / 8)
+
+/** Largest isochronous wMaxPacketSize (one transaction per (micro)frame) */
+#define HS_ISO_MAX_PACKET_SIZE (1024U)
+
+/**
+ * Largest packet of an alternate setting at the max rate, one frame of rate
+ * adaptation included. It has to fit a single transaction: at 48 kHz the
+ * full-width alternate settings allow a packet every 2 microframes at most,
+ * the 8 and 2 channels ones every 4.
+ */
+#define HS_ISO_ENDP_PACKET_SIZE_AT_MAX(interval, channels, size) \
+    ((((AUDIO_SAMPLING_RATE_MAX_KHZ << ((interval)-1U)) + 7U) / 8U + 1U) * (channels) * (size))
+
+#if (HS_ISO_ENDP_PACKET_SIZE_AT_MAX(HS_ISO_ENDP_INTERVAL_ALT_1, AUDIO_FORMAT_CHANNELS, AUDIO_FORMAT_SIZE) >    \
+     HS_ISO_MAX_PACKET_SIZE) ||                                                                              \
+    (HS_ISO_ENDP_PACKET_SIZE_AT_MAX(HS_ISO_ENDP_INTERVAL_ALT_2, AUDIO_FORMAT_CHANNELS, AUDIO_FORMAT_SIZE_24) > \
+     HS_ISO_MAX_PACKET_SIZE) ||                                                                              \
+    (HS_ISO_ENDP_PACKET_SIZE_AT_MAX(HS_ISO_ENDP_INTERVAL_ALT_3, AUDIO_FORMAT_CHANNELS_8, AUDIO_FORMAT_SIZE) >  \
+     HS_ISO_MAX_PACKET_SIZE) ||                                                                              \
+    (HS_ISO_ENDP_PACKET_SIZE_AT_MAX(HS_ISO_ENDP_INTERVAL_ALT_4, AUDIO_FORMAT_CHANNELS_2, AUDIO_FORMAT_SIZE) >  \
+     HS_ISO_MAX_PACKET_SIZE)
+#error "HS packets at AUDIO_SAMPLING_RATE_MAX_KHZ do not fit a single isochronous transaction"
+#endif
+#define FS_ISO_MAX_PACKET_SIZE (1023U)
+
 #define HS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE (4U)
 #define FS_ISO_IN_FEEDBACK_ENDP_PACKET_SIZE (4U)
 
-#define HS_ISO_IN_ENDP_INTERVAL (0x01U) /* 125us */
 #define FS_ISO_IN_ENDP_INTERVAL (0x01U)
-
-#define HS_ISO_OUT_ENDP_INTERVAL (0x01U) /* 125us */
 #define FS_ISO_OUT_ENDP_INTERVAL (0x01U)
 
 #define FS_ISO_IN_FEEDBACK_ENDP_INTERVAL (0x01U)
@@ -125,6 +268,23 @@
 #define USB_AUDIO_IN_CONTROL_OUTPUT_TERMINAL_ID (0x04U)
 #define USB_AUDIO_OUT_CONTROL_OUTPUT_TERMINAL_ID (0x03U)
 
+#define USB_AUDIO_IN_CONTROL_FEATURE_UNIT_ID (0x07U)
+#define USB_AUDIO_OUT_CONTROL_FEATURE_UNIT_ID (0x08U)
+
+/**
+ * Logical channels of the feature units, one per TDM slot. Channel 0 is the
+ * master [16 channels]
+ */
+#define USB_AUDIO_FEATURE_UNIT_CHANNELS (AUDIO_FORMAT_CHANNELS)
+
+/**
+ * Volume range of the feature units, 1/256 dB [-127 dB .. +6 dB, 1/256 dB
+ * steps]. The volume of a channel adds up with the master one.
+ */
+#define USB_AUDIO_VOLUME_MIN ((int16_t)0x8100)
+#define USB_AUDIO_VOLUME_MAX ((int16_t)0x0600)
+#define USB_AUDIO_VOLUME_RES ((int16_t)0x0001)
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -167,4 +327,54 @@ usb_status_t USB_DeviceGetConfigurationDescriptor(
 usb_status_t USB_DeviceGetStringDescriptor(usb_device_handle handle,
                                            usb_device_get_string_descriptor_struct_t *stringDescriptor);
 
+/*!
+ * @brief Number of channels of a streaming alternate setting.
+ *
+ * @param alternate The alternate setting of the streaming interface.
+ *
+ * @return The number of channels, carried by the first TDM slots.
+ */
+uint8_t USB_DeviceGetStreamChannels(uint8_t alternate);
+
+/*!
+ * @brief Subslot size (bytes per sample) of a streaming alternate setting.
+ *
+ * @param alternate The alternate setting of the streaming interface.
+ *
+ * @return AUDIO_FORMAT_SIZE or AUDIO_FORMAT_SIZE_24.
+ */
+uint8_t USB_DeviceGetStreamSubslotSize(uint8_t alternate);
+
+/*!
+ * @brief Service interval of the streaming data endpoints.
+ *
+ * @param speed Speed type. USB_SPEED_HIGH/USB_SPEED_FULL.
+ * @param alternate The alternate setting of the streaming interface.
+ *
+ * @return The bInterval of the data endpoints.
+ */
+uint8_t USB_DeviceGetStreamInterval(uint8_t speed, uint8_t alternate);
+
+/*!
+ * @brief Microframes between two packets of the streaming data endpoints.
+ *
+ * @param speed Speed type. USB_SPEED_HIGH/USB_SPEED_FULL.
+ * @param alternate The alternate setting of the streaming interface.
+ *
+ * @return 2^(bInterval - 1) in HS, 1 in FS (the data paths are paced per
+ *         packet as in HS).
+ */
+uint32_t USB_DeviceGetStreamUframes(uint8_t speed, uint8_t alternate);
+
+/*!
+ * @brief Max packet size of the streaming data endpoints.
+ *
+ * @param speed Speed type. USB_SPEED_HIGH/USB_SPEED_FULL.
+ * @param alternate The alternate setting of the streaming interface.
+ * @param rate The sampling rate [Hz].
+ *
+ * @return The max packet size in bytes of a service interval.
+ */
+uint32_t USB_DeviceGetStreamPacketSize(uint8_t speed, uint8_t alternate, uint32_t rate);
+
 #endif /* __USB_DESCRIPTOR_H__ */